@@ -0,0 +1,282 @@
+/*
+ * benchmark.c
+ * Includes the main function of the benchmark, which runs a script the same way as batch mode, and measures every command.
+ * Each command is measured in 4 stages: the parser (tokenizing the line), the validator (compiling the line into an instruction),
+ * the kernels (executing any command other than print_set) and the printer (executing print_set).
+ * Set-writing commands are committed as soon as they are executed, so each kernel is measured with its own command.
+ * The printed sets go to the standard output, and the report goes to the standard error.
+ *
+ * Name: Ariel Keren
+ * Course: C Lab, 20465
+ * Semester: 2024B
+ * Date: 18/10/2026
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "calculator.h"
+#include "execution.h"
+#include "globals.h"
+#include "graph.h"
+#include "lexer.h"
+#include "mysetUtils.h"
+#include "reader.h"
+#include "registry.h"
+#include "setUtils.h"
+#include "utils.h"
+#include "validation.h"
+
+/* The latencies of every command in a stage (or of a single operation), in seconds. */
+typedef struct {
+    double *samples; /* The latency of each command, in the order of the script (until sorted). */
+    size_t count;    /* The number of latencies. */
+    size_t capacity; /* The number of latencies there is memory for. */
+    double total;    /* The sum of every latency. */
+} latencylist;
+
+/**
+ * Returns the current time, from a clock which never goes back.
+ *
+ * @return The current time, in seconds.
+ */
+static double getTime() {
+    struct timespec now; /* The current time. */
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + (double)now.tv_nsec / NANOSECONDS_PER_SECOND;
+}
+
+/**
+ * Adds the latency of a command to the list.
+ * Exits the program if the memory allocation fails.
+ *
+ * @param latencies The list to add the latency to.
+ * @param latency The latency of the command, in seconds.
+ */
+static void addLatency(latencylist *latencies, double latency) {
+    double *larger; /* The latencies with more memory. */
+
+    /* Allocate more memory if necessary. */
+    if (latencies->count == latencies->capacity) {
+        latencies->capacity = latencies->capacity == EMPTY ? INITIAL_SIZE : latencies->capacity * GROWTH_FACTOR;
+
+        /* Check for an error in the memory allocation. */
+        if ((larger = realloc(latencies->samples, latencies->capacity * sizeof(double))) == NULL) {
+            /* Exit the program. */
+            fprintf(stderr, "Failed to allocate memory for the latencies.\n");
+            exit(ERROR);
+        }
+
+        latencies->samples = larger;
+    }
+
+    latencies->samples[latencies->count++] = latency;
+    latencies->total += latency;
+}
+
+/**
+ * Compares two latencies (for qsort).
+ *
+ * @param first The first latency.
+ * @param second The second latency.
+ * @return A negative number, 0 or a positive number if the first latency is shorter, equal or longer.
+ */
+static int compareLatencies(const void *first, const void *second) {
+    double difference; /* The difference between the latencies. */
+
+    difference = *(const double *)first - *(const double *)second;
+    return (difference > EMPTY) - (difference < EMPTY);
+}
+
+/**
+ * Returns the latency at the given percentile (nearest rank).
+ * Assumes the latencies are sorted and that there is at least one.
+ *
+ * @param latencies The latencies.
+ * @param percentile The percentile (0-100).
+ * @return The latency at the percentile, in seconds.
+ */
+static double getPercentile(const latencylist *latencies, int percentile) {
+    return latencies->samples[(latencies->count - NEXT_INDEX_DIFFERENCE) * percentile / WHOLE_PERCENT];
+}
+
+/**
+ * Prints a line of the report, with the number of commands, their total time and their latencies.
+ * Sorts the latencies, and then frees them.
+ *
+ * @param name The name of the stage (or of the operation).
+ * @param latencies The latencies of the commands.
+ */
+static void reportLatencies(const char name[], latencylist *latencies) {
+    /* Skip stages (and operations) which no command has gone through. */
+    if (latencies->count == EMPTY) {
+        return;
+    }
+
+    qsort(latencies->samples, latencies->count, sizeof(double), compareLatencies);
+    fprintf(stderr, "%-14s %10lu %12.3f %12.0f %12.3f %12.3f %12.3f\n", name, (unsigned long)latencies->count, latencies->total * MILLISECONDS_PER_SECOND,
+            latencies->count / latencies->total, getPercentile(latencies, MEDIAN_PERCENTILE) * MICROSECONDS_PER_SECOND,
+            getPercentile(latencies, TAIL_PERCENTILE) * MICROSECONDS_PER_SECOND, getPercentile(latencies, WHOLE_PERCENT) * MICROSECONDS_PER_SECOND);
+    free(latencies->samples);
+}
+
+/**
+ * Runs the script, measures every command, and prints the report.
+ * Takes the same arguments as the program itself (always in batch mode).
+ *
+ * @param argc The number of command line arguments.
+ * @param argv The command line arguments.
+ * @return 0 when run successfully.
+ */
+int main(int argc, char *argv[]) {
+    /* The calculator which runs the commands (its sets, command graph and statistics). */
+    calculator *context;
+    /* The options the program has been run with. */
+    options programOptions;
+    /* Reads the script a block at a time. */
+    linereader reader;
+    /* The tokens of the current line. */
+    tokenlist tokens;
+    /* The current line, compiled into an instruction. */
+    instruction command;
+    /* The current line of the script. */
+    char *line;
+    /* The length of the current line. */
+    size_t length;
+    /* Has the whole current line been read? */
+    boolean isComplete;
+    /* Is the current line valid? */
+    boolean isValid;
+    /* Is the script stopped? */
+    boolean isStopped;
+    /* The number of the current line. */
+    unsigned long lineNumber;
+    /* The number of characters in the script (including newlines). */
+    unsigned long characters;
+    /* The latencies of every stage. */
+    latencylist stages[NUMBER_OF_STAGES];
+    /* The latencies of executing each operation. */
+    latencylist operations[NUMBER_OF_OPERATIONS];
+    /* The time at which the script started. */
+    double scriptStart;
+    /* The time at which the current stage started. */
+    double stageStart;
+    /* The time at which the current stage ended. */
+    double stageEnd;
+    /* Current index in the stages or the operations. */
+    int index;
+
+    parseArguments(argc, argv, &programOptions);
+    programOptions.isBatch = TRUE;
+
+    /* Every set covers the universe chosen on the command line, and starts from the saved state given on the command line (if any). */
+    context = createCalculator(programOptions.universe, writeStandardOutput, writeStandardError, NULL);
+    initializeTokenList(&tokens);
+
+    /* Check for an error in the memory allocation. */
+    if (context == NULL || !createReader(&reader, openInput(&programOptions)) || !createInstruction(&command)) {
+        /* Exit the program. */
+        fprintf(stderr, "Failed to allocate memory for the benchmark.\n");
+        exit(ERROR);
+    }
+
+    useCalculator(context);
+    loadStartingState(&context->sets, &programOptions);
+
+    for (index = FIRST_INDEX; index < NUMBER_OF_STAGES; index++) {
+        stages[index].samples = NULL;
+        stages[index].count = stages[index].capacity = EMPTY;
+        stages[index].total = STARTING_VALUE;
+    }
+
+    for (index = FIRST_INDEX; index < NUMBER_OF_OPERATIONS; index++) {
+        operations[index] = stages[FIRST_INDEX];
+    }
+
+    isStopped = FALSE;
+    lineNumber = characters = STARTING_VALUE;
+    scriptStart = getTime();
+
+    /* Loop until the script is stopped. */
+    while (!isStopped) {
+        setLineNumber(++lineNumber);
+        line = readLine(&reader, &length, &isComplete);
+
+        /* Skip blank lines. */
+        if (line == NULL) {
+            characters++;
+            continue;
+        }
+
+        /* The benchmark always keeps the whole line. */
+        if (!isComplete) {
+            finishLine(&reader, &line, &length);
+        }
+
+        characters += length + NEXT_INDEX_DIFFERENCE;
+
+        /* Measure the parser on its own (the validator tokenizes the line again, unless it is a well-formed read_set). */
+        stageStart = getTime();
+        tokenizeLine(line, length, &tokens);
+        stageEnd = getTime();
+        addLatency(&stages[PARSER_STAGE], stageEnd - stageStart);
+
+        stageStart = stageEnd;
+        isValid = compileLine(line, length, &tokens, &command);
+        stageEnd = getTime();
+        addLatency(&stages[VALIDATOR_STAGE], stageEnd - stageStart);
+
+        /* Skip to the next line if the current line is invalid. */
+        if (!isValid) {
+            if (command.error != NULL) {
+                printError(command.error);
+            }
+
+            continue;
+        }
+
+        /* Compute the latest version of every set right away, so the kernels are not deferred to a later command. */
+        stageStart = stageEnd;
+        isStopped = executeInstruction(&command, &context->sets);
+        commitVersions();
+        stageEnd = getTime();
+        addLatency(&stages[command.operation == PRINT_SET ? PRINTER_STAGE : KERNEL_STAGE], stageEnd - stageStart);
+        addLatency(&operations[command.operation], stageEnd - stageStart);
+
+        /* Check if the command could not be executed (e.g. it refers to a set which is not defined). */
+        if (command.error != NULL) {
+            printError(command.error);
+        }
+    }
+
+    /* Write out the rest of the printed sets before the script's time is taken. */
+    fflush(stdout);
+    stageEnd = getTime();
+
+    fprintf(stderr, "Commands: %lu, characters: %lu, time: %.3f s\n", lineNumber, characters, stageEnd - scriptStart);
+    fprintf(stderr, "Throughput: %.0f commands/s, %.2f MiB/s\n", lineNumber / (stageEnd - scriptStart), characters / BYTES_PER_MEBIBYTE / (stageEnd - scriptStart));
+    fprintf(stderr, "%-14s %10s %12s %12s %12s %12s %12s\n", "stage", "commands", "total (ms)", "commands/s", "p50 (us)", "p99 (us)", "max (us)");
+
+    for (index = FIRST_INDEX; index < NUMBER_OF_STAGES; index++) {
+        reportLatencies(STAGES[index], &stages[index]);
+    }
+
+    fprintf(stderr, "%-14s %10s %12s %12s %12s %12s %12s\n", "operation", "commands", "total (ms)", "commands/s", "p50 (us)", "p99 (us)", "max (us)");
+
+    for (index = FIRST_INDEX; index < NUMBER_OF_OPERATIONS; index++) {
+        reportLatencies(OPERATIONS[index], &operations[index]);
+    }
+
+    /* Everything the script used is no longer used. */
+    freeTokenList(&tokens);
+    freeInstruction(&command);
+    freeReader(&reader);
+    freeCalculator(context);
+
+    /* Return 0 when run successfully. */
+    return SUCCESS;
+}
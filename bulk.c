@@ -0,0 +1,402 @@
+/*
+ * bulk.c
+ * Includes functions for loading a single set from a binary file, and for dumping a single set to one.
+ * Files are mapped into memory when they are loaded, and written a chunk (or a block of members) at a time.
+ * On little-endian machines, a bitmap chunk is moved between the file and a bitmap container with a single copy.
+ *
+ * Name: Ariel Keren
+ * Course: C Lab, 20465
+ * Semester: 2024B
+ * Date: 18/10/2026
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include "bulk.h"
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "calculator.h"
+#include "container.h"
+#include "globals.h"
+#include "set.h"
+#include "setUtils.h"
+
+/* Buffers the members of a set before they are written in the array format. */
+typedef struct {
+    FILE *file;                                              /* The file to write to. */
+    unsigned char bytes[DUMP_BUFFER_MEMBERS * MEMBER_BYTES]; /* The members which have not been written yet. */
+    size_t used;                                             /* The number of bytes in the buffer. */
+} arraywriter;
+
+/**
+ * Gives up on the current command because a memory allocation has failed (see failMemory).
+ */
+static void failAllocation() {
+    failMemory("Failed to allocate memory for the set.");
+}
+
+/**
+ * Checks if the machine keeps the lowest byte of a number first.
+ *
+ * @return TRUE if the machine is little-endian, FALSE otherwise.
+ */
+static boolean isLittleEndian() {
+    uint16_t probe; /* A number whose lowest byte is the only one which is not 0. */
+
+    probe = SINGLE_BIT;
+    return *(const unsigned char *)&probe == SINGLE_BIT;
+}
+
+/**
+ * Maps the file with the given path into memory.
+ * An empty file is not mapped (its data is NULL).
+ *
+ * @param path The path of the file.
+ * @param data Receives the first byte of the mapped file.
+ * @param length Receives the number of bytes in the file.
+ * @return NULL if the file has been mapped, or the reason it could not be mapped.
+ */
+static const char *mapFile(const char path[], const unsigned char **data, size_t *length) {
+    int file;           /* The descriptor of the file. */
+    struct stat status; /* The size of the file. */
+    void *mapping;      /* The mapped file. */
+
+    if ((file = open(path, O_RDONLY)) < EMPTY) {
+        return "Failed to open the file.";
+    }
+
+    if (fstat(file, &status)) {
+        close(file);
+        return "Failed to read the file.";
+    }
+
+    *length = (size_t)status.st_size;
+    *data = NULL;
+
+    /* An empty file cannot be mapped, and has no members anyway. */
+    if (*length == EMPTY) {
+        close(file);
+        return NULL;
+    }
+
+    mapping = mmap(NULL, *length, PROT_READ, MAP_PRIVATE, file, STARTING_VALUE);
+    close(file);
+
+    if (mapping == MAP_FAILED) {
+        return "Failed to read the file.";
+    }
+
+    *data = mapping;
+    return NULL;
+}
+
+/**
+ * Fills the set with the members of a file in the bitmap format, a chunk at a time.
+ *
+ * @param data The bytes of the file.
+ * @param length The number of bytes in the file.
+ * @param members The empty set to fill.
+ * @return NULL if the members have been loaded, or the reason they could not be loaded.
+ */
+static const char *loadBitmap(const unsigned char data[], size_t length, set *members) {
+    unsigned long lastKey; /* The key of the chunk of the largest potential member. */
+    unsigned long key;     /* The key of the current chunk. */
+    size_t offset;         /* The index of the first byte of the current chunk in the file. */
+    size_t part;           /* The number of bytes of the current chunk in the file. */
+    size_t index;          /* Current index in the bytes of the chunk. */
+    container chunk;       /* The current chunk. */
+    boolean isCopied;      /* Can the bytes be copied to the sections as they are? */
+
+    lastKey = (unsigned long)getLargestMember() >> CONTAINER_BITS;
+    isCopied = isLittleEndian();
+
+    for (key = STARTING_VALUE, offset = FIRST_INDEX; offset < length; key++, offset += BITMAP_BYTES) {
+        part = length - offset < BITMAP_BYTES ? length - offset : BITMAP_BYTES;
+
+        /* The sections start out empty, so a partial chunk is padded with zeros. */
+        if (!createBitmapContainer(&chunk, (uint32_t)key)) {
+            failAllocation();
+        }
+
+        if (isCopied) {
+            memcpy(chunk.data.sections, data + offset, part);
+        } else {
+            for (index = FIRST_INDEX; index < part; index++) {
+                chunk.data.sections[index / sizeof(setsection)] |= (setsection)data[offset + index] << (index % sizeof(setsection) * BITS_PER_BYTE);
+            }
+        }
+
+        chunk.cardinality = countBitmap(chunk.data.sections);
+
+        /* Every member should be in the universe. */
+        if (chunk.cardinality != EMPTY && (key > lastKey || (key == lastKey && findMaximumValue(&chunk) > ((unsigned long)getLargestMember() & LOW_BITS_MASK)))) {
+            freeContainer(&chunk);
+            return "The file has members outside the universe.";
+        }
+
+        /* Keep the chunk in the kind which fits it best, unless it is empty. */
+        if (!optimizeContainer(&chunk)) {
+            failAllocation();
+        }
+
+        if (chunk.cardinality != EMPTY && !appendContainer(members, &chunk)) {
+            failAllocation();
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Fills the set with the members of a file in the array format.
+ *
+ * @param data The bytes of the file.
+ * @param length The number of bytes in the file.
+ * @param members The empty set to fill.
+ * @return NULL if the members have been loaded, or the reason they could not be loaded.
+ */
+static const char *loadArray(const unsigned char data[], size_t length, set *members) {
+    size_t offset;          /* The index of the current member's first byte in the file. */
+    unsigned long member;   /* The current member. */
+    unsigned long previous; /* The previous member. */
+    unsigned byte;          /* Current index in the bytes of the member. */
+
+    if (length % MEMBER_BYTES != NO_REMAINDER) {
+        return "The file is not an array of members.";
+    }
+
+    previous = STARTING_VALUE;
+
+    for (offset = FIRST_INDEX; offset < length; offset += MEMBER_BYTES) {
+        member = STARTING_VALUE;
+
+        /* The lowest byte comes first. */
+        for (byte = FIRST_INDEX; byte < MEMBER_BYTES; byte++) {
+            member |= (unsigned long)data[offset + byte] << (byte * BITS_PER_BYTE);
+        }
+
+        if (offset != FIRST_INDEX && member <= previous) {
+            return "The members in the file are not sorted.";
+        }
+
+        if (member > (unsigned long)getLargestMember()) {
+            return "The file has members outside the universe.";
+        }
+
+        /* The members come in order, so every member is added to the end of the last container. */
+        if (!addMember(members, (long)member)) {
+            failAllocation();
+        }
+
+        previous = member;
+    }
+
+    /* Convert every container to the kind which fits it best. */
+    if (!optimizeSet(members)) {
+        failAllocation();
+    }
+
+    return NULL;
+}
+
+/**
+ * Fills the set with the members kept in the file with the given path.
+ * The file is mapped into memory and decoded a chunk (bitmap) or a member (array) at a time.
+ * If the file is invalid, the set is left empty.
+ * Exits the program if the memory allocation fails.
+ *
+ * @param path The path of the file to load the members from.
+ * @param format The format of the file (BITMAP_FORMAT or ARRAY_FORMAT).
+ * @param members The set to fill (its previous members are removed).
+ * @return NULL if the members have been loaded, or the reason they could not be loaded.
+ */
+const char *loadSetFile(const char path[], int format, set *members) {
+    const unsigned char *data; /* The mapped file. */
+    size_t length;             /* The number of bytes in the file. */
+    const char *error;         /* The reason the members could not be loaded. */
+
+    clearSet(members);
+
+    if ((error = mapFile(path, &data, &length)) != NULL) {
+        return error;
+    }
+
+    error = format == BITMAP_FORMAT ? loadBitmap(data, length, members) : loadArray(data, length, members);
+
+    if (data != NULL) {
+        munmap((void *)data, length);
+    }
+
+    /* Do not keep the members of an invalid file. */
+    if (error != NULL) {
+        clearSet(members);
+    }
+
+    return error;
+}
+
+/**
+ * Writes the members of the set in the bitmap format, a chunk at a time (up to the end of the universe).
+ *
+ * @param source The set to write.
+ * @param file The file to write to.
+ * @return TRUE if the members have been written, FALSE otherwise.
+ */
+static boolean writeBitmap(const set *source, FILE *file) {
+    setsection sections[BITMAP_SECTIONS]; /* The members of the current chunk. */
+    unsigned char bytes[BITMAP_BYTES];    /* The members of the current chunk, in the order of the file (big-endian machines only). */
+    unsigned long length;                 /* The number of bytes in the file. */
+    unsigned long offset;                 /* The index of the first byte of the current chunk in the file. */
+    size_t part;                          /* The number of bytes of the current chunk in the file. */
+    size_t index;                         /* Current index in the bytes of the chunk. */
+    size_t next;                          /* The index of the next container of the set. */
+    boolean isCopied;                     /* Can the sections be written as they are? */
+
+    length = ((unsigned long)getLargestMember() + BITS_PER_BYTE) / BITS_PER_BYTE;
+    next = FIRST_INDEX;
+    isCopied = isLittleEndian();
+
+    for (offset = STARTING_VALUE; offset < length; offset += BITMAP_BYTES) {
+        part = length - offset < BITMAP_BYTES ? length - offset : BITMAP_BYTES;
+
+        /* Fill the chunk from its container (if it has any members). */
+        if (next < source->count && source->containers[next].key == offset / BITMAP_BYTES) {
+            fillBitmap(&source->containers[next++], sections);
+        } else {
+            memset(sections, EMPTY, BITMAP_BYTES);
+        }
+
+        if (isCopied) {
+            if (fwrite(sections, SINGLE_CHARACTER, part, file) != part) {
+                return FALSE;
+            }
+
+            continue;
+        }
+
+        for (index = FIRST_INDEX; index < part; index++) {
+            bytes[index] = (unsigned char)((sections[index / sizeof(setsection)] >> (index % sizeof(setsection) * BITS_PER_BYTE)) & BYTE_MASK);
+        }
+
+        if (fwrite(bytes, SINGLE_CHARACTER, part, file) != part) {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+/**
+ * Adds a member to the buffer of the writer (as a little-endian 32-bit integer), and writes the buffer out when it is full.
+ *
+ * @param writer The writer to add the member to.
+ * @param member The member to add.
+ * @return TRUE if the member has been added, FALSE if the buffer could not be written.
+ */
+static boolean addArrayMember(arraywriter *writer, unsigned long member) {
+    unsigned byte; /* Current index in the bytes of the member. */
+
+    for (byte = FIRST_INDEX; byte < MEMBER_BYTES; byte++) {
+        writer->bytes[writer->used++] = (unsigned char)((member >> (byte * BITS_PER_BYTE)) & BYTE_MASK);
+    }
+
+    if (writer->used < sizeof(writer->bytes)) {
+        return TRUE;
+    }
+
+    writer->used = STARTING_VALUE;
+    return fwrite(writer->bytes, SINGLE_CHARACTER, sizeof(writer->bytes), writer->file) == sizeof(writer->bytes);
+}
+
+/**
+ * Writes the members of the set in the array format.
+ *
+ * @param source The set to write.
+ * @param file The file to write to.
+ * @return TRUE if the members have been written, FALSE otherwise.
+ */
+static boolean writeArray(const set *source, FILE *file) {
+    arraywriter writer;       /* Buffers the members. */
+    const container *current; /* The current container. */
+    unsigned long base;       /* The smallest potential member in the current container. */
+    size_t index;             /* Current index in the containers. */
+    size_t position;          /* Current index in the values, sections or runs of the container. */
+    setsection section;       /* The bits of the current section which have not been written yet. */
+    unsigned long value;      /* Current value in a run. */
+    boolean isWritten;        /* Has everything been written so far? */
+
+    writer.file = file;
+    writer.used = STARTING_VALUE;
+    isWritten = TRUE;
+
+    /* Write the members of every container, in increasing order. */
+    for (index = FIRST_INDEX; isWritten && index < source->count; index++) {
+        current = &source->containers[index];
+        base = (unsigned long)current->key << CONTAINER_BITS;
+
+        switch (current->type) {
+            case ARRAY_CONTAINER:
+                for (position = FIRST_INDEX; isWritten && position < current->count; position++) {
+                    isWritten = addArrayMember(&writer, base + current->data.values[position]);
+                }
+
+                break;
+            case BITMAP_CONTAINER:
+                for (position = FIRST_INDEX; isWritten && position < BITMAP_SECTIONS; position++) {
+                    /* Clear the lowest bit after writing it, until the section is empty. */
+                    for (section = current->data.sections[position]; isWritten && section != EMPTY; section &= section - SINGLE_BIT) {
+                        isWritten = addArrayMember(&writer, base + position * SECTION_BITS + findLowestBit(section));
+                    }
+                }
+
+                break;
+            default:
+                for (position = FIRST_INDEX; isWritten && position < current->count; position++) {
+                    for (value = current->data.runs[position].start; isWritten && value <= (unsigned long)current->data.runs[position].start + current->data.runs[position].length; value++) {
+                        isWritten = addArrayMember(&writer, base + value);
+                    }
+                }
+
+                break;
+        }
+    }
+
+    return isWritten && fwrite(writer.bytes, SINGLE_CHARACTER, writer.used, file) == writer.used;
+}
+
+/**
+ * Writes the members of the set to the file with the given path.
+ * A bitmap covers the whole universe, and an array only has the members.
+ *
+ * @param source The set to write.
+ * @param path The path of the file to write the members to.
+ * @param format The format of the file (BITMAP_FORMAT or ARRAY_FORMAT).
+ * @return NULL if the members have been written, or the reason they could not be written.
+ */
+const char *dumpSetFile(const set *source, const char path[], int format) {
+    FILE *file;        /* The file to write to. */
+    boolean isWritten; /* Have all the members been written? */
+
+    if ((file = fopen(path, "wb")) == NULL) {
+        return "Failed to open the file.";
+    }
+
+    isWritten = format == BITMAP_FORMAT ? writeBitmap(source, file) : writeArray(source, file);
+    isWritten = !fclose(file) && isWritten;
+
+    /* Do not leave a partial file behind. */
+    if (!isWritten) {
+        remove(path);
+        return "Failed to write the file.";
+    }
+
+    return NULL;
+}
@@ -0,0 +1,45 @@
+/*
+ * bulk.h
+ * Includes the prototypes of all the functions in bulk.c.
+ *
+ * A single set can be kept in a binary file in one of two formats:
+ * - bitmap: bit i (the bit of value 1 << (i % 8) in byte i / 8) is set if and only if i is a member.
+ * - array: every member as a little-endian 32-bit integer, in increasing order.
+ *
+ * Name: Ariel Keren
+ * Course: C Lab, 20465
+ * Semester: 2024B
+ * Date: 18/10/2026
+ */
+
+#ifndef BULK_H
+#define BULK_H
+
+#include "globals.h"
+#include "set.h"
+
+/**
+ * Fills the set with the members kept in the file with the given path.
+ * The file is mapped into memory and decoded a chunk (bitmap) or a member (array) at a time.
+ * If the file is invalid, the set is left empty.
+ * Exits the program if the memory allocation fails.
+ *
+ * @param path The path of the file to load the members from.
+ * @param format The format of the file (BITMAP_FORMAT or ARRAY_FORMAT).
+ * @param members The set to fill (its previous members are removed).
+ * @return NULL if the members have been loaded, or the reason they could not be loaded.
+ */
+const char *loadSetFile(const char path[], int format, set *members);
+
+/**
+ * Writes the members of the set to the file with the given path.
+ * A bitmap covers the whole universe, and an array only has the members.
+ *
+ * @param source The set to write.
+ * @param path The path of the file to write the members to.
+ * @param format The format of the file (BITMAP_FORMAT or ARRAY_FORMAT).
+ * @return NULL if the members have been written, or the reason they could not be written.
+ */
+const char *dumpSetFile(const set *source, const char path[], int format);
+
+#endif
@@ -0,0 +1,287 @@
+/*
+ * calculator.c
+ * Includes the functions of the set calculator library (see setcalc.h): allocating a calculator, running a line in it, and freeing it.
+ * Also, includes the functions the modules use to reach the calculator in use, its sinks, and to give up on a line when memory runs out.
+ *
+ * Name: Ariel Keren
+ * Course: C Lab, 20465
+ * Semester: 2024B
+ * Date: 18/10/2026
+ */
+
+#include "calculator.h"
+
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "execution.h"
+#include "globals.h"
+#include "graph.h"
+#include "lexer.h"
+#include "registry.h"
+#include "setUtils.h"
+#include "snapshot.h"
+#include "stats.h"
+#include "utils.h"
+#include "validation.h"
+
+/* The calculator the current thread uses (every thread has its own, where the compiler supports it). */
+#ifdef __GNUC__
+static __thread calculator *currentCalculator = NULL;
+#else
+static calculator *currentCalculator = NULL;
+#endif
+
+/**
+ * Returns the calculator the current thread uses.
+ *
+ * @return The calculator in use (NULL if none).
+ */
+calculator *getCalculator() {
+    return currentCalculator;
+}
+
+/**
+ * Makes the current thread use the given calculator, until another one is used.
+ * The myset program uses a single calculator from start to end, and executeLine uses its calculator while it runs a line.
+ *
+ * @param context The calculator to use (NULL for none).
+ * @return The calculator which has been used until now (NULL if none).
+ */
+calculator *useCalculator(calculator *context) {
+    calculator *previous; /* The calculator which has been used until now. */
+
+    previous = currentCalculator;
+    currentCalculator = context;
+    return previous;
+}
+
+/**
+ * Writes text to the output sink of the calculator in use.
+ *
+ * @param text The text to write (does not have to be null-terminated).
+ * @param length The number of characters to write.
+ */
+void writeOutput(const char text[], size_t length) {
+    currentCalculator->output(currentCalculator->sinkData, text, length);
+}
+
+/**
+ * Writes text to the error sink of the calculator in use.
+ *
+ * @param text The text to write (does not have to be null-terminated).
+ * @param length The number of characters to write.
+ */
+void writeErrors(const char text[], size_t length) {
+    currentCalculator->errors(currentCalculator->sinkData, text, length);
+}
+
+/**
+ * Gives up on the current line because a memory allocation has failed.
+ * While executeLine runs a line, returns to it (the calculator can then only be freed).
+ * Otherwise (the myset program), prints the message to the standard error and exits the program.
+ *
+ * @param message What the memory was for (e.g. "Failed to allocate memory for the sets.").
+ */
+void failMemory(const char message[]) {
+    /* Return to executeLine, which reports the message. */
+    if (currentCalculator != NULL && currentCalculator->isGuarded) {
+        currentCalculator->failedMemory = message;
+        longjmp(currentCalculator->failure, ERROR);
+    }
+
+    /* Exit the program. */
+    fprintf(stderr, "%s\n", message);
+    exit(ERROR);
+}
+
+/**
+ * Loads a saved state into the sets of a calculator (see load_state), before its first line runs.
+ * Exits the program if the memory allocation fails.
+ *
+ * @param context The calculator.
+ * @param path The path of the saved state.
+ * @return NULL if the state has been loaded, or the reason it could not be loaded.
+ */
+const char *loadCalculatorState(calculator *context, const char path[]) {
+    calculator *previous; /* The calculator the thread has used before. */
+    const char *error;    /* The reason the state could not be loaded. */
+
+    /* The mapped state is kept in the calculator in use. */
+    previous = useCalculator(context);
+    error = loadState(&context->sets, path);
+    useCalculator(previous);
+    return error;
+}
+
+/**
+ * Reports that the input of a calculator has ended without the stop command (as the error of the line after the last one).
+ *
+ * @param context The calculator.
+ */
+void reportMissingStop(calculator *context) {
+    calculator *previous; /* The calculator the thread has used before. */
+
+    previous = useCalculator(context);
+    context->lineNumber++;
+    printError("Missing stop command.");
+    useCalculator(previous);
+}
+
+/**
+ * Allocates a calculator, with SETA to SETF (empty).
+ *
+ * @param universe The number of potential members in every set (between 1 and 2147483647).
+ * @param output Receives everything the commands print.
+ * @param errors Receives every error message (a whole line at a time).
+ * @param data Passed to both sinks.
+ * @return The calculator, or NULL if the universe is out of range or the memory allocation failed.
+ */
+calculator *createCalculator(long universe, outputsink output, outputsink errors, void *data) {
+    calculator *created; /* The allocated calculator. */
+    size_t index;        /* Current index in the predefined set names. */
+    setname name;        /* The name of the current predefined set. */
+    boolean isCreated;   /* Has everything been allocated so far? */
+
+    /* Check if the size of the universe is out of range. */
+    if (universe < MINIMUM_UNIVERSE || universe > MAXIMUM_UNIVERSE) {
+        return NULL;
+    }
+
+    if ((created = malloc(sizeof(calculator))) == NULL) {
+        return NULL;
+    }
+
+    initializeGraph(&created->graph);
+    initializeTokenList(&created->tokens);
+    created->largestMember = universe - NEXT_INDEX_DIFFERENCE;
+    created->printed.text = NULL;
+    created->printed.capacity = created->printed.length = STARTING_VALUE;
+    created->isBatch = TRUE;
+    created->lineNumber = NO_LINE_NUMBER;
+    created->mappedState = NULL;
+    created->mappedLength = EMPTY;
+    created->output = output;
+    created->errors = errors;
+    created->sinkData = data;
+    created->isGuarded = FALSE;
+    created->failedMemory = NULL;
+#ifndef NO_STATS
+    /* Every phase of every operation starts out with no measurements. */
+    memset(&created->statistics, EMPTY, sizeof(created->statistics));
+#endif
+
+    /* Allocate the registry, along with SETA to SETF (each with no containers). */
+    if (!createRegistry(&created->sets)) {
+        free(created);
+        return NULL;
+    }
+
+    isCreated = TRUE;
+
+    for (index = FIRST_INDEX; index < NUMBER_OF_SETS && isCreated; index++) {
+        nameSet(&name, SETS[index], strlen(SETS[index]));
+        isCreated = defineSet(&created->sets, &name) != NULL;
+    }
+
+    /* The instruction is reused for every line. */
+    if (!isCreated || !createInstruction(&created->command)) {
+        freeRegistry(&created->sets);
+        free(created);
+        return NULL;
+    }
+
+    return created;
+}
+
+/**
+ * Runs a single line (without its newline character), and writes out everything it prints before returning.
+ * The line does not have to be null-terminated.
+ *
+ * @param context The calculator to run the line in.
+ * @param line The line to run.
+ * @param length The number of characters in the line.
+ * @return CALCULATOR_SUCCESS if the line has run (or it is blank),
+ *         CALCULATOR_INVALID if it is not a valid command, CALCULATOR_FAILED if the command could not be executed
+ *         (e.g. it refers to a set which is not defined), CALCULATOR_STOPPED if it is the stop command (more lines can still run),
+ *         or CALCULATOR_OUT_OF_MEMORY if a memory allocation has failed (the calculator can then only be freed, and every further line gets this result).
+ */
+int executeLine(calculator *context, const char line[], size_t length) {
+    calculator *previous; /* The calculator the thread has used before this line. */
+    instruction *command; /* The line, compiled into an instruction. */
+    statstimer timer;     /* Times validating or executing the line. */
+    int result;           /* The result of the line. */
+
+    /* A calculator whose memory has run out is never used again. */
+    if (context->failedMemory != NULL) {
+        return CALCULATOR_OUT_OF_MEMORY;
+    }
+
+    previous = useCalculator(context);
+    command = &context->command;
+    context->lineNumber++;
+
+    /* A failed memory allocation returns here (every variable which is changed afterwards is kept in the calculator). */
+    if (setjmp(context->failure) != SUCCESS) {
+        context->isGuarded = FALSE;
+        printError(context->failedMemory);
+        useCalculator(previous);
+        return CALCULATOR_OUT_OF_MEMORY;
+    }
+
+    context->isGuarded = TRUE;
+    startTimer(&timer);
+    result = compileLine(line, length, &context->tokens, command) ? CALCULATOR_SUCCESS : CALCULATOR_INVALID;
+    stopTimer(&timer);
+    /* Lines which are not valid commands are recorded apart from every operation. */
+    recordTimer(&timer, VALIDATE_PHASE, result == CALCULATOR_SUCCESS ? command->operation : INVALID_OPERATION);
+
+    if (result == CALCULATOR_SUCCESS) {
+        startTimer(&timer);
+
+        if (executeInstruction(command, &context->sets)) {
+            result = CALCULATOR_STOPPED;
+        }
+
+        stopTimer(&timer);
+        recordTimer(&timer, EXECUTE_PHASE, command->operation);
+
+        /* Check if the command could not be executed (e.g. it refers to a set which is not defined). */
+        if (command->error != NULL) {
+            result = CALCULATOR_FAILED;
+        }
+    }
+
+    /* Blank lines are skipped without an error. */
+    if (command->error != NULL) {
+        printError(command->error);
+    } else if (result == CALCULATOR_INVALID) {
+        result = CALCULATOR_SUCCESS;
+    }
+
+    context->isGuarded = FALSE;
+    useCalculator(previous);
+    return result;
+}
+
+/**
+ * Frees the calculator, along with every set in it.
+ *
+ * @param context The calculator to free.
+ */
+void freeCalculator(calculator *context) {
+    calculator *previous; /* The calculator the thread has used before. */
+
+    /* The command graph and the saved state are freed through the calculator in use. */
+    previous = useCalculator(context);
+    freeVersions();
+    freeRegistry(&context->sets);
+    freeState();
+    freeOutputBuffer();
+    freeTokenList(&context->tokens);
+    freeInstruction(&context->command);
+    useCalculator(previous == context ? NULL : previous);
+    free(context);
+}
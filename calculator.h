@@ -0,0 +1,111 @@
+/*
+ * calculator.h
+ * Includes the prototypes of the functions in calculator.c which are not part of the library's interface (see setcalc.h).
+ * Also, includes the type of a calculator, which holds everything a stream of commands changes.
+ *
+ * The modules reach the calculator which is running a line through getCalculator (a thread only runs a single line at a time),
+ * so a calculator does not have to be passed through every function.
+ *
+ * Name: Ariel Keren
+ * Course: C Lab, 20465
+ * Semester: 2024B
+ * Date: 18/10/2026
+ */
+
+#ifndef CALCULATOR_H
+#define CALCULATOR_H
+
+#include <setjmp.h>
+#include <stddef.h>
+
+#include "globals.h"
+#include "graph.h"
+#include "lexer.h"
+#include "registry.h"
+#include "setcalc.h"
+#include "setUtils.h"
+#include "stats.h"
+#include "validation.h"
+
+/* Everything a stream of commands changes. */
+struct calculator {
+    setregistry sets;           /* Every set defined in the calculator, by its name. */
+    commandgraph graph;         /* The versions of the sets which have not been stored in the sets yet. */
+    long largestMember;         /* The largest potential member in every set. */
+    printbuffer printed;        /* The buffer sets are printed into (reused for every print). */
+    boolean isBatch;            /* Are informational messages left out? */
+    unsigned long lineNumber;   /* The number of the line which is currently handled (0 if unknown). */
+    void *mappedState;          /* The last loaded state, mapped into memory (NULL if none). */
+    size_t mappedLength;        /* The length of the mapped state. */
+#ifndef NO_STATS
+    statisticstable statistics; /* The statistics of every phase of every operation (and of lines which are not valid commands). */
+#endif
+    tokenlist tokens;           /* The tokens of the current line (executeLine only). */
+    instruction command;        /* The current line, compiled into an instruction (executeLine only). */
+    outputsink output;          /* Receives everything the commands print. */
+    outputsink errors;          /* Receives every error message. */
+    void *sinkData;             /* Passed to both sinks. */
+    jmp_buf failure;            /* Where a failed memory allocation returns to, while executeLine runs a line. */
+    boolean isGuarded;          /* Is executeLine running a line (so a failed memory allocation returns to it instead of exiting)? */
+    const char *failedMemory;   /* What a failed memory allocation was for (NULL if none has failed). */
+};
+
+/**
+ * Returns the calculator the current thread uses.
+ *
+ * @return The calculator in use (NULL if none).
+ */
+calculator *getCalculator();
+
+/**
+ * Makes the current thread use the given calculator, until another one is used.
+ * The myset program uses a single calculator from start to end, and executeLine uses its calculator while it runs a line.
+ *
+ * @param context The calculator to use (NULL for none).
+ * @return The calculator which has been used until now (NULL if none).
+ */
+calculator *useCalculator(calculator *context);
+
+/**
+ * Writes text to the output sink of the calculator in use.
+ *
+ * @param text The text to write (does not have to be null-terminated).
+ * @param length The number of characters to write.
+ */
+void writeOutput(const char text[], size_t length);
+
+/**
+ * Writes text to the error sink of the calculator in use.
+ *
+ * @param text The text to write (does not have to be null-terminated).
+ * @param length The number of characters to write.
+ */
+void writeErrors(const char text[], size_t length);
+
+/**
+ * Gives up on the current line because a memory allocation has failed.
+ * While executeLine runs a line, returns to it (the calculator can then only be freed).
+ * Otherwise (the myset program), prints the message to the standard error and exits the program.
+ *
+ * @param message What the memory was for (e.g. "Failed to allocate memory for the sets.").
+ */
+void failMemory(const char message[]);
+
+/**
+ * Loads a saved state into the sets of a calculator (see load_state), before its first line runs.
+ * Exits the program if the memory allocation fails.
+ *
+ * @param context The calculator.
+ * @param path The path of the saved state.
+ * @return NULL if the state has been loaded, or the reason it could not be loaded.
+ */
+const char *loadCalculatorState(calculator *context, const char path[]);
+
+/**
+ * Reports that the input of a calculator has ended without the stop command (as the error of the line after the last one).
+ *
+ * @param context The calculator.
+ */
+void reportMissingStop(calculator *context);
+
+#endif
@@ -0,0 +1,1127 @@
+/*
+ * container.c
+ * Includes functions for creating, converting and combining the containers a set is made of.
+ * Every set operation on a pair of containers is dispatched to a kernel which fits their kinds:
+ * - Two arrays are merged.
+ * - An array and a bitmap are combined by checking (or changing) the bits of the array's values.
+ * - Two runs are combined interval by interval (union and intersection).
+ * - Every other pair is combined a whole vector (or word) at a time, as two bitmaps.
+ * Every result is then converted to the kind which keeps its members in the least memory.
+ *
+ * Name: Ariel Keren
+ * Course: C Lab, 20465
+ * Semester: 2024B
+ * Date: 18/10/2026
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include "container.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "globals.h"
+
+#ifdef __SSE2__
+/* The number of set sections in a single SSE2 vector. */
+#define VECTOR_SECTIONS (sizeof(__m128i) / sizeof(setsection))
+#endif
+
+/* An empty section, with every bit cleared. */
+#define EMPTY_SECTION ((setsection)EMPTY)
+/* A full section, with every bit set. */
+#define FULL_SECTION (~EMPTY_SECTION)
+
+/**
+ * Counts the bits which are set in the given section.
+ *
+ * @param section The section to count the bits of.
+ * @return The number of bits which are set.
+ */
+unsigned countBits(setsection section) {
+#ifdef __GNUC__
+    /* Use the hardware population count when there is one. */
+    return __builtin_popcountl(section);
+#else
+    unsigned count; /* The number of bits counted so far. */
+
+    /* Clear the lowest set bit until there are none left. */
+    for (count = STARTING_VALUE; section != EMPTY; count++) {
+        section &= section - SINGLE_BIT;
+    }
+
+    return count;
+#endif
+}
+
+/**
+ * Finds the position of the lowest bit which is set in the given section.
+ * Assumes the section is not empty.
+ *
+ * @param section The section to check.
+ * @return The position of the lowest set bit (0 for the least significant bit).
+ */
+unsigned findLowestBit(setsection section) {
+#ifdef __GNUC__
+    /* Use the hardware count of trailing zeros when there is one. */
+    return __builtin_ctzl(section);
+#else
+    unsigned position; /* The position of the current bit. */
+
+    /* Shift the section until its lowest bit is set. */
+    for (position = FIRST_INDEX; (section & SINGLE_BIT) == EMPTY; position++) {
+        section >>= SINGLE_BIT;
+    }
+
+    return position;
+#endif
+}
+
+/**
+ * Finds the position of the highest bit which is set in the given section.
+ * Assumes the section is not empty.
+ *
+ * @param section The section to check.
+ * @return The position of the highest set bit (0 for the least significant bit).
+ */
+unsigned findHighestBit(setsection section) {
+#ifdef __GNUC__
+    /* Use the hardware count of leading zeros when there is one. */
+    return SECTION_BITS - NEXT_INDEX_DIFFERENCE - __builtin_clzl(section);
+#else
+    unsigned position; /* The position of the current bit. */
+
+    position = FIRST_INDEX;
+
+    /* Shift the section until only its highest bit is left. */
+    while ((section >>= SINGLE_BIT) != EMPTY) {
+        position++;
+    }
+
+    return position;
+#endif
+}
+
+/**
+ * Allocates an empty array container.
+ *
+ * @param result The container to allocate.
+ * @param key The key of the container.
+ * @param capacity The number of values the container should have memory for.
+ * @return TRUE if the container has been allocated, FALSE if the memory allocation failed.
+ */
+boolean createArrayContainer(container *result, uint32_t key, uint32_t capacity) {
+    /* Always have memory for at least one value. */
+    if (capacity == EMPTY) {
+        capacity = SINGLE_BIT;
+    }
+
+    result->type = ARRAY_CONTAINER;
+    result->key = key;
+    result->cardinality = STARTING_VALUE;
+    result->count = STARTING_VALUE;
+    result->capacity = capacity;
+    result->data.values = malloc(capacity * sizeof(uint16_t));
+    return result->data.values != NULL;
+}
+
+/**
+ * Allocates an empty bitmap container.
+ *
+ * @param result The container to allocate.
+ * @param key The key of the container.
+ * @return TRUE if the container has been allocated, FALSE if the memory allocation failed.
+ */
+boolean createBitmapContainer(container *result, uint32_t key) {
+    void *memory; /* The aligned memory of the sections. */
+
+    result->type = BITMAP_CONTAINER;
+    result->key = key;
+    result->cardinality = STARTING_VALUE;
+    result->count = STARTING_VALUE;
+    result->capacity = BITMAP_SECTIONS;
+
+    /* Allocate the sections, aligned to a cache line. */
+    if (posix_memalign(&memory, CACHE_LINE_SIZE, BITMAP_BYTES)) {
+        result->data.sections = NULL;
+        return FALSE;
+    }
+
+    result->data.sections = memory;
+    memset(result->data.sections, EMPTY, BITMAP_BYTES);
+    return TRUE;
+}
+
+/**
+ * Allocates an empty run container.
+ *
+ * @param result The container to allocate.
+ * @param key The key of the container.
+ * @param capacity The number of runs the container should have memory for.
+ * @return TRUE if the container has been allocated, FALSE if the memory allocation failed.
+ */
+boolean createRunContainer(container *result, uint32_t key, uint32_t capacity) {
+    /* Always have memory for at least one run. */
+    if (capacity == EMPTY) {
+        capacity = SINGLE_BIT;
+    }
+
+    result->type = RUN_CONTAINER;
+    result->key = key;
+    result->cardinality = STARTING_VALUE;
+    result->count = STARTING_VALUE;
+    result->capacity = capacity;
+    result->data.runs = malloc(capacity * sizeof(valuerun));
+    return result->data.runs != NULL;
+}
+
+/**
+ * Fills the container with members kept in memory which it does not own (e.g. a mapped saved state).
+ * The members are used in place, so they are never changed or freed through the container.
+ *
+ * @param result The container to fill.
+ * @param type The kind of the container.
+ * @param key The key of the container.
+ * @param cardinality The number of members in the container.
+ * @param count The number of values (array containers) or runs (run containers).
+ * @param data The members of the container (aligned to a cache line for bitmap containers).
+ */
+void borrowContainer(container *result, containertype type, uint32_t key, uint32_t cardinality, uint32_t count, const void *data) {
+    result->type = type;
+    result->key = key;
+    result->cardinality = cardinality;
+    result->count = count;
+    result->capacity = EMPTY;
+    /* Every kind of container keeps its members in a single block (the union shares the pointer). */
+    result->data.values = (uint16_t *)data;
+}
+
+/**
+ * Checks if the members of the container agree with its kind and its cardinality (e.g. for a container borrowed from a file).
+ * Array values should be strictly increasing, runs should be sorted, apart from each other and inside the container,
+ * and the number of members should be the cardinality of the container.
+ *
+ * @param source The container to check.
+ * @return TRUE if the members are consistent, FALSE otherwise.
+ */
+boolean isConsistentContainer(const container *source) {
+    uint32_t index;       /* Current index in the values or runs. */
+    unsigned long total;  /* The number of members counted so far. */
+    unsigned long end;    /* The last value of the current run. */
+    unsigned long border; /* The smallest value the current run may start at. */
+
+    switch (source->type) {
+        case ARRAY_CONTAINER:
+            for (index = NEXT_INDEX_DIFFERENCE; index < source->count; index++) {
+                if (source->data.values[index] <= source->data.values[index - NEXT_INDEX_DIFFERENCE]) {
+                    return FALSE;
+                }
+            }
+
+            return source->count == source->cardinality;
+        case BITMAP_CONTAINER:
+            return countBitmap(source->data.sections) == source->cardinality;
+        default:
+            total = border = STARTING_VALUE;
+
+            for (index = FIRST_INDEX; index < source->count; index++) {
+                end = (unsigned long)source->data.runs[index].start + source->data.runs[index].length;
+
+                if (source->data.runs[index].start < border || end >= (unsigned long)CONTAINER_VALUES) {
+                    return FALSE;
+                }
+
+                total += source->data.runs[index].length + NEXT_INDEX_DIFFERENCE;
+                border = end + NEXT_INDEX_DIFFERENCE;
+            }
+
+            return total == source->cardinality;
+    }
+}
+
+/**
+ * Finds the first container in the given range of a sorted array of containers whose key is not smaller than the given one.
+ *
+ * @param containers The containers, sorted by their keys.
+ * @param low The first index to search from.
+ * @param high The index after the last one to search.
+ * @param key The key to find.
+ * @return The index of the container (high if every key in the range is smaller).
+ */
+size_t findContainerIndex(const container containers[], size_t low, size_t high, unsigned long key) {
+    size_t middle; /* The middle of the current range of indices. */
+
+    /* Find the position of the key in the sorted array. */
+    while (low < high) {
+        middle = low + (high - low) / SEARCH_DIVISOR;
+
+        if (containers[middle].key < key) {
+            low = middle + NEXT_INDEX_DIFFERENCE;
+        } else {
+            high = middle;
+        }
+    }
+
+    return low;
+}
+
+/**
+ * Frees the memory used by the container.
+ * The memory of a container which does not own it is left as it is.
+ *
+ * @param target The container to free.
+ */
+void freeContainer(container *target) {
+    /* Every kind of container keeps its members in a single block (the union shares the pointer). */
+    if (target->capacity != EMPTY) {
+        free(target->data.values);
+    }
+
+    target->data.values = NULL;
+    target->cardinality = STARTING_VALUE;
+    target->count = STARTING_VALUE;
+}
+
+/**
+ * Copies the container (including its members) to a newly allocated container.
+ *
+ * @param source The container to copy.
+ * @param result The container to allocate and fill.
+ * @return TRUE if the container has been copied, FALSE if the memory allocation failed.
+ */
+boolean copyContainer(const container *source, container *result) {
+    /* Allocate a container of the same kind and copy the members' memory. */
+    switch (source->type) {
+        case ARRAY_CONTAINER:
+            if (!createArrayContainer(result, source->key, source->count)) {
+                return FALSE;
+            }
+
+            memcpy(result->data.values, source->data.values, source->count * sizeof(uint16_t));
+            break;
+        case BITMAP_CONTAINER:
+            if (!createBitmapContainer(result, source->key)) {
+                return FALSE;
+            }
+
+            memcpy(result->data.sections, source->data.sections, BITMAP_BYTES);
+            break;
+        default:
+            if (!createRunContainer(result, source->key, source->count)) {
+                return FALSE;
+            }
+
+            memcpy(result->data.runs, source->data.runs, source->count * sizeof(valuerun));
+            break;
+    }
+
+    result->cardinality = source->cardinality;
+    result->count = source->count;
+    return TRUE;
+}
+
+/**
+ * Sets the bits of every value in the given interval.
+ *
+ * @param sections The bitmap to change.
+ * @param start The first value in the interval.
+ * @param end The last value in the interval.
+ */
+static void setBitRange(setsection sections[], unsigned long start, unsigned long end) {
+    unsigned long firstSection; /* The index of the section of the first value. */
+    unsigned long lastSection;  /* The index of the section of the last value. */
+    setsection firstMask;       /* The bits of the first section which are in the interval. */
+    setsection lastMask;        /* The bits of the last section which are in the interval. */
+    unsigned long index;        /* Current index in the bitmap. */
+
+    firstSection = start / SECTION_BITS;
+    lastSection = end / SECTION_BITS;
+    firstMask = FULL_SECTION << (start % SECTION_BITS);
+    lastMask = FULL_SECTION >> (SECTION_BITS - NEXT_INDEX_DIFFERENCE - end % SECTION_BITS);
+
+    /* Check if the whole interval is in a single section. */
+    if (firstSection == lastSection) {
+        sections[firstSection] |= firstMask & lastMask;
+        return;
+    }
+
+    /* Set the partial sections at both ends, and every section in between. */
+    sections[firstSection] |= firstMask;
+
+    for (index = firstSection + NEXT_INDEX_DIFFERENCE; index < lastSection; index++) {
+        sections[index] = FULL_SECTION;
+    }
+
+    sections[lastSection] |= lastMask;
+}
+
+/**
+ * Finds the first value (starting from the given one) whose bit is set, or cleared.
+ *
+ * @param sections The bitmap to search in.
+ * @param from The first value to check.
+ * @param isSet TRUE to find a set bit, FALSE to find a cleared bit.
+ * @return The value which has been found, or 65536 if there is none.
+ */
+static unsigned long findNextBit(const setsection sections[], unsigned long from, boolean isSet) {
+    unsigned long index; /* Current index in the bitmap. */
+    setsection section;  /* The current section (inverted when searching for a cleared bit). */
+
+    /* Check if the search starts after the end of the bitmap. */
+    if (from >= CONTAINER_VALUES) {
+        return CONTAINER_VALUES;
+    }
+
+    index = from / SECTION_BITS;
+    section = isSet ? sections[index] : ~sections[index];
+    /* Ignore the bits before the first value to check. */
+    section &= FULL_SECTION << (from % SECTION_BITS);
+
+    /* Skip every section without a matching bit. */
+    while (section == EMPTY) {
+        if (++index == BITMAP_SECTIONS) {
+            return CONTAINER_VALUES;
+        }
+
+        section = isSet ? sections[index] : ~sections[index];
+    }
+
+    return index * SECTION_BITS + findLowestBit(section);
+}
+
+/**
+ * Counts the bits which are set in the given bitmap.
+ *
+ * @param sections The bitmap to count the bits of.
+ * @return The number of bits which are set.
+ */
+uint32_t countBitmap(const setsection sections[]) {
+    size_t index;   /* Current index in the bitmap. */
+    uint32_t count; /* The number of bits counted so far. */
+
+    count = STARTING_VALUE;
+
+    /* Count the bits in every section. */
+    for (index = FIRST_INDEX; index < BITMAP_SECTIONS; index++) {
+        count += countBits(sections[index]);
+    }
+
+    return count;
+}
+
+/**
+ * Counts the intervals of consecutive members in the container.
+ *
+ * @param source The container to count the intervals of.
+ * @return The number of intervals.
+ */
+static uint32_t countRuns(const container *source) {
+    uint32_t runs;      /* The number of intervals counted so far. */
+    uint32_t index;     /* Current index in the container. */
+    setsection carry;   /* The highest bit of the previous section. */
+    setsection section; /* The current section. */
+
+    runs = STARTING_VALUE;
+
+    switch (source->type) {
+        case ARRAY_CONTAINER:
+            /* Count every value which does not continue the previous one. */
+            for (index = FIRST_INDEX; index < source->count; index++) {
+                if (index == FIRST_INDEX || source->data.values[index] != source->data.values[index - NEXT_INDEX_DIFFERENCE] + NEXT_INDEX_DIFFERENCE) {
+                    runs++;
+                }
+            }
+
+            return runs;
+        case BITMAP_CONTAINER:
+            carry = EMPTY;
+
+            /* Count every set bit whose previous bit is cleared (the start of an interval). */
+            for (index = FIRST_INDEX; index < BITMAP_SECTIONS; index++) {
+                section = source->data.sections[index];
+                runs += countBits(section & ~((section << SINGLE_BIT) | carry));
+                carry = section >> (SECTION_BITS - NEXT_INDEX_DIFFERENCE);
+            }
+
+            return runs;
+        default:
+            return source->count;
+    }
+}
+
+/**
+ * Sets a bit in the given bitmap for every member of the container.
+ * Clears all the other bits.
+ *
+ * @param source The container to convert.
+ * @param sections The bitmap to fill (65536 bits).
+ */
+void fillBitmap(const container *source, setsection sections[]) {
+    uint32_t index;       /* Current index in the container. */
+    const valuerun *runs; /* The runs of a run container. */
+    uint16_t value;       /* The current value. */
+
+    /* A bitmap is copied as it is. */
+    if (source->type == BITMAP_CONTAINER) {
+        memcpy(sections, source->data.sections, BITMAP_BYTES);
+        return;
+    }
+
+    memset(sections, EMPTY, BITMAP_BYTES);
+
+    /* Set the bit of every value in an array. */
+    if (source->type == ARRAY_CONTAINER) {
+        for (index = FIRST_INDEX; index < source->count; index++) {
+            value = source->data.values[index];
+            sections[value / SECTION_BITS] |= (setsection)SINGLE_BIT << (value % SECTION_BITS);
+        }
+
+        return;
+    }
+
+    /* Set the bits of every interval in a run container. */
+    runs = source->data.runs;
+
+    for (index = FIRST_INDEX; index < source->count; index++) {
+        setBitRange(sections, runs[index].start, (unsigned long)runs[index].start + runs[index].length);
+    }
+}
+
+/**
+ * Fills an array container with every value whose bit is set in the given bitmap.
+ * Assumes the container has memory for all the values.
+ *
+ * @param sections The bitmap to convert.
+ * @param result The array container to fill.
+ */
+static void extractValues(const setsection sections[], container *result) {
+    size_t index;       /* Current index in the bitmap. */
+    setsection section; /* The bits of the current section which have not been extracted yet. */
+
+    result->count = STARTING_VALUE;
+
+    /* Extract the lowest set bit of every section until there are none left. */
+    for (index = FIRST_INDEX; index < BITMAP_SECTIONS; index++) {
+        for (section = sections[index]; section != EMPTY; section &= section - SINGLE_BIT) {
+            result->data.values[result->count++] = (uint16_t)(index * SECTION_BITS + findLowestBit(section));
+        }
+    }
+
+    result->cardinality = result->count;
+}
+
+/**
+ * Fills a run container with every interval of set bits in the given bitmap.
+ * Assumes the container has memory for all the intervals.
+ *
+ * @param sections The bitmap to convert.
+ * @param result The run container to fill.
+ */
+static void extractRuns(const setsection sections[], container *result) {
+    unsigned long start; /* The first value of the current interval. */
+    unsigned long end;   /* The value right after the current interval. */
+
+    result->count = STARTING_VALUE;
+    result->cardinality = STARTING_VALUE;
+
+    /* Find every interval by jumping between set and cleared bits. */
+    for (start = findNextBit(sections, FIRST_INDEX, TRUE); start < CONTAINER_VALUES; start = findNextBit(sections, end, TRUE)) {
+        end = findNextBit(sections, start, FALSE);
+        result->data.runs[result->count].start = (uint16_t)start;
+        result->data.runs[result->count].length = (uint16_t)(end - start - NEXT_INDEX_DIFFERENCE);
+        result->count++;
+        result->cardinality += end - start;
+    }
+}
+
+/**
+ * Returns the smallest value in the container.
+ * Assumes the container is not empty.
+ *
+ * @param source The container to check.
+ * @return The low bits of the smallest member in the container.
+ */
+uint16_t findMinimumValue(const container *source) {
+    size_t index; /* Current index in the bitmap. */
+
+    switch (source->type) {
+        case ARRAY_CONTAINER:
+            return source->data.values[FIRST_INDEX];
+        case BITMAP_CONTAINER:
+            /* Find the first section with a member, and its lowest bit. */
+            index = FIRST_INDEX;
+
+            while (source->data.sections[index] == EMPTY) {
+                index++;
+            }
+
+            return (uint16_t)(index * SECTION_BITS + findLowestBit(source->data.sections[index]));
+        default:
+            return source->data.runs[FIRST_INDEX].start;
+    }
+}
+
+/**
+ * Returns the largest value in the container.
+ * Assumes the container is not empty.
+ *
+ * @param source The container to check.
+ * @return The low bits of the largest member in the container.
+ */
+uint16_t findMaximumValue(const container *source) {
+    size_t index;         /* Current index in the bitmap. */
+    const valuerun *last; /* The last run of a run container. */
+
+    switch (source->type) {
+        case ARRAY_CONTAINER:
+            return source->data.values[source->count - NEXT_INDEX_DIFFERENCE];
+        case BITMAP_CONTAINER:
+            /* Find the last section with a member, and its highest bit. */
+            index = BITMAP_SECTIONS - NEXT_INDEX_DIFFERENCE;
+
+            while (source->data.sections[index] == EMPTY) {
+                index--;
+            }
+
+            return (uint16_t)(index * SECTION_BITS + findHighestBit(source->data.sections[index]));
+        default:
+            last = &source->data.runs[source->count - NEXT_INDEX_DIFFERENCE];
+            return (uint16_t)(last->start + last->length);
+    }
+}
+
+/**
+ * Converts the container to the kind which keeps its members in the least memory.
+ * Frees the memory of an empty container.
+ *
+ * @param target The container to convert.
+ * @return TRUE if the container has been converted, FALSE if the memory allocation failed.
+ */
+boolean optimizeContainer(container *target) {
+    uint32_t runs;                       /* The number of intervals of consecutive members. */
+    size_t runBytes;                     /* The memory a run container would need. */
+    size_t arrayBytes;                   /* The memory an array container would need (if it fits). */
+    containertype bestType;              /* The kind of container which needs the least memory. */
+    container result;                    /* The converted container. */
+    setsection scratch[BITMAP_SECTIONS]; /* The members as a bitmap, when converting from a non-bitmap. */
+    const setsection *sections;          /* The members as a bitmap. */
+
+    /* An empty container does not need any memory. */
+    if (target->cardinality == EMPTY) {
+        freeContainer(target);
+        return TRUE;
+    }
+
+    runs = countRuns(target);
+    runBytes = runs * sizeof(valuerun);
+    arrayBytes = target->cardinality <= ARRAY_MAX_CARDINALITY ? target->cardinality * sizeof(uint16_t) : BITMAP_BYTES;
+
+    /* Find the kind which needs the least memory (preferring arrays and bitmaps when equal). */
+    if (runBytes < arrayBytes && runBytes < BITMAP_BYTES) {
+        bestType = RUN_CONTAINER;
+    } else if (target->cardinality <= ARRAY_MAX_CARDINALITY) {
+        bestType = ARRAY_CONTAINER;
+    } else {
+        bestType = BITMAP_CONTAINER;
+    }
+
+    /* Check if the container is already of the right kind. */
+    if (bestType == target->type) {
+        return TRUE;
+    }
+
+    /* Get the members as a bitmap (without copying a bitmap container). */
+    if (target->type == BITMAP_CONTAINER) {
+        sections = target->data.sections;
+    } else {
+        fillBitmap(target, scratch);
+        sections = scratch;
+    }
+
+    /* Build the container of the right kind from the bitmap. */
+    switch (bestType) {
+        case ARRAY_CONTAINER:
+            if (!createArrayContainer(&result, target->key, target->cardinality)) {
+                return FALSE;
+            }
+
+            extractValues(sections, &result);
+            break;
+        case BITMAP_CONTAINER:
+            if (!createBitmapContainer(&result, target->key)) {
+                return FALSE;
+            }
+
+            memcpy(result.data.sections, sections, BITMAP_BYTES);
+            result.cardinality = target->cardinality;
+            break;
+        default:
+            if (!createRunContainer(&result, target->key, runs)) {
+                return FALSE;
+            }
+
+            extractRuns(sections, &result);
+            break;
+    }
+
+    /* Replace the container with the converted one. */
+    freeContainer(target);
+    *target = result;
+    return TRUE;
+}
+
+/**
+ * Adds the given value to the container.
+ * An array container which becomes too large is converted to a bitmap container.
+ * A run container is converted to a bitmap container first.
+ *
+ * @param target The container to add the value to.
+ * @param value The low bits of the member to add.
+ * @return TRUE if the value has been added, FALSE if the memory allocation failed.
+ */
+boolean addContainerValue(container *target, uint16_t value) {
+    uint32_t low;        /* The lowest index the value can be inserted at. */
+    uint32_t high;       /* The highest index the value can be inserted at. */
+    uint32_t middle;     /* The middle of the current range of indices. */
+    uint16_t *values;    /* The values of an array container. */
+    setsection mask;     /* The bit of the value in its section. */
+    container converted; /* The container after it has been converted to a bitmap. */
+
+    /* Run containers are changed as bitmaps. */
+    if (target->type == RUN_CONTAINER || (target->type == ARRAY_CONTAINER && target->count == ARRAY_MAX_CARDINALITY)) {
+        if (!createBitmapContainer(&converted, target->key)) {
+            return FALSE;
+        }
+
+        fillBitmap(target, converted.data.sections);
+        converted.cardinality = target->cardinality;
+        freeContainer(target);
+        *target = converted;
+    }
+
+    /* Set the value's bit in a bitmap container. */
+    if (target->type == BITMAP_CONTAINER) {
+        mask = (setsection)SINGLE_BIT << (value % SECTION_BITS);
+
+        if ((target->data.sections[value / SECTION_BITS] & mask) == EMPTY) {
+            target->data.sections[value / SECTION_BITS] |= mask;
+            target->cardinality++;
+        }
+
+        return TRUE;
+    }
+
+    values = target->data.values;
+    low = FIRST_INDEX;
+    high = target->count;
+
+    /* Values usually come in order, so check the end of the array first. */
+    if (high != EMPTY && values[high - NEXT_INDEX_DIFFERENCE] < value) {
+        low = high;
+    }
+
+    /* Find the position of the value in the sorted array. */
+    while (low < high) {
+        middle = low + (high - low) / SEARCH_DIVISOR;
+
+        if (values[middle] < value) {
+            low = middle + NEXT_INDEX_DIFFERENCE;
+        } else {
+            high = middle;
+        }
+    }
+
+    /* Check if the value is already in the array. */
+    if (low < target->count && values[low] == value) {
+        return TRUE;
+    }
+
+    /* Grow the array (geometrically) if it is full. */
+    if (target->count == target->capacity) {
+        values = realloc(values, target->capacity * GROWTH_FACTOR * sizeof(uint16_t));
+
+        if (values == NULL) {
+            return FALSE;
+        }
+
+        target->data.values = values;
+        target->capacity *= GROWTH_FACTOR;
+    }
+
+    /* Make room for the value and insert it. */
+    memmove(values + low + NEXT_INDEX_DIFFERENCE, values + low, (target->count - low) * sizeof(uint16_t));
+    values[low] = value;
+    target->count++;
+    target->cardinality++;
+    return TRUE;
+}
+
+/**
+ * Applies a set operation to two bitmaps, a whole vector (or word) at a time.
+ * Stores the result in the first bitmap.
+ *
+ * @param result The first bitmap, which also receives the result.
+ * @param other The second bitmap.
+ * @param operation The operation to apply.
+ */
+static void combineBitmaps(setsection result[], const setsection other[], int operation) {
+    size_t index; /* Current index in the bitmaps. */
+#ifdef __SSE2__
+    __m128i first;  /* The current vector of the first bitmap. */
+    __m128i second; /* The current vector of the second bitmap. */
+    __m128i output; /* The current vector of the result. */
+
+    /* Apply the operation a whole vector at a time. */
+    for (index = FIRST_INDEX; index < BITMAP_SECTIONS; index += VECTOR_SECTIONS) {
+        first = _mm_loadu_si128((const __m128i *)(result + index));
+        second = _mm_loadu_si128((const __m128i *)(other + index));
+
+        switch (operation) {
+            case UNION_SET:
+                output = _mm_or_si128(first, second);
+                break;
+            case INTERSECT_SET:
+                output = _mm_and_si128(first, second);
+                break;
+            case SUB_SET:
+                output = _mm_andnot_si128(second, first);
+                break;
+            default:
+                output = _mm_xor_si128(first, second);
+                break;
+        }
+
+        _mm_storeu_si128((__m128i *)(result + index), output);
+    }
+#else
+    /* Apply the operation a whole word at a time. */
+    for (index = FIRST_INDEX; index < BITMAP_SECTIONS; index++) {
+        switch (operation) {
+            case UNION_SET:
+                result[index] |= other[index];
+                break;
+            case INTERSECT_SET:
+                result[index] &= other[index];
+                break;
+            case SUB_SET:
+                result[index] &= ~other[index];
+                break;
+            default:
+                result[index] ^= other[index];
+                break;
+        }
+    }
+#endif
+}
+
+/**
+ * Merges two array containers, keeping the values the operation keeps.
+ * Assumes the result fits in an array container.
+ *
+ * @param containerA The first array container.
+ * @param containerB The second array container.
+ * @param result The container to store the result in.
+ * @param operation The operation to apply.
+ * @return TRUE if the operation has been applied, FALSE if the memory allocation failed.
+ */
+static boolean mergeArrays(const container *containerA, const container *containerB, container *result, int operation) {
+    const uint16_t *valuesA; /* The values of the first container. */
+    const uint16_t *valuesB; /* The values of the second container. */
+    uint32_t indexA;         /* Current index in the first container. */
+    uint32_t indexB;         /* Current index in the second container. */
+    uint16_t *output;        /* The values of the result. */
+    uint32_t count;          /* The number of values in the result so far. */
+    boolean keepOnlyA;       /* Should values which are only in the first container be kept? */
+    boolean keepOnlyB;       /* Should values which are only in the second container be kept? */
+    boolean keepBoth;        /* Should values which are in both containers be kept? */
+
+    if (!createArrayContainer(result, containerA->key, containerA->count + containerB->count)) {
+        return FALSE;
+    }
+
+    valuesA = containerA->data.values;
+    valuesB = containerB->data.values;
+    output = result->data.values;
+    count = STARTING_VALUE;
+    keepOnlyA = operation != INTERSECT_SET;
+    keepOnlyB = operation == UNION_SET || operation == SYMDIFF_SET;
+    keepBoth = operation == UNION_SET || operation == INTERSECT_SET;
+
+    /* Walk over both sorted arrays together. */
+    for (indexA = indexB = FIRST_INDEX; indexA < containerA->count && indexB < containerB->count;) {
+        if (valuesA[indexA] < valuesB[indexB]) {
+            if (keepOnlyA) {
+                output[count++] = valuesA[indexA];
+            }
+
+            indexA++;
+        } else if (valuesA[indexA] > valuesB[indexB]) {
+            if (keepOnlyB) {
+                output[count++] = valuesB[indexB];
+            }
+
+            indexB++;
+        } else {
+            if (keepBoth) {
+                output[count++] = valuesA[indexA];
+            }
+
+            indexA++;
+            indexB++;
+        }
+    }
+
+    /* Add the rest of the values which are only in one of the containers. */
+    while (keepOnlyA && indexA < containerA->count) {
+        output[count++] = valuesA[indexA++];
+    }
+
+    while (keepOnlyB && indexB < containerB->count) {
+        output[count++] = valuesB[indexB++];
+    }
+
+    result->count = result->cardinality = count;
+    return TRUE;
+}
+
+/**
+ * Keeps the values of an array container whose bits are set (or cleared) in a bitmap container.
+ * Used for intersection (the bit is set) and for the difference of an array from a bitmap (the bit is cleared).
+ *
+ * @param array The array container.
+ * @param bitmap The bitmap container.
+ * @param result The container to store the result in.
+ * @param isSet TRUE to keep the values whose bits are set, FALSE to keep the values whose bits are cleared.
+ * @return TRUE if the operation has been applied, FALSE if the memory allocation failed.
+ */
+static boolean filterArray(const container *array, const container *bitmap, container *result, boolean isSet) {
+    uint32_t index;   /* Current index in the array. */
+    uint16_t value;   /* The current value. */
+    boolean inBitmap; /* Is the current value's bit set in the bitmap? */
+
+    if (!createArrayContainer(result, array->key, array->count)) {
+        return FALSE;
+    }
+
+    /* Check the bit of every value in the array. */
+    for (index = FIRST_INDEX; index < array->count; index++) {
+        value = array->data.values[index];
+        inBitmap = (boolean)((bitmap->data.sections[value / SECTION_BITS] >> (value % SECTION_BITS)) & SINGLE_BIT);
+
+        if (inBitmap == isSet) {
+            result->data.values[result->count++] = value;
+        }
+    }
+
+    result->cardinality = result->count;
+    return TRUE;
+}
+
+/**
+ * Changes the bits of every value of an array container in a copy of a bitmap container.
+ * Used for union (setting), difference from the bitmap (clearing) and symmetric difference (flipping).
+ *
+ * @param bitmap The bitmap container.
+ * @param array The array container.
+ * @param result The container to store the result in.
+ * @param operation The operation to apply.
+ * @return TRUE if the operation has been applied, FALSE if the memory allocation failed.
+ */
+static boolean changeBitmap(const container *bitmap, const container *array, container *result, int operation) {
+    uint32_t index;      /* Current index in the array. */
+    uint16_t value;      /* The current value. */
+    setsection mask;     /* The bit of the current value in its section. */
+    setsection *section; /* The section of the current value. */
+
+    if (!copyContainer(bitmap, result)) {
+        return FALSE;
+    }
+
+    /* Change the bit of every value in the array, keeping the cardinality up to date. */
+    for (index = FIRST_INDEX; index < array->count; index++) {
+        value = array->data.values[index];
+        mask = (setsection)SINGLE_BIT << (value % SECTION_BITS);
+        section = &result->data.sections[value / SECTION_BITS];
+
+        if ((*section & mask) == EMPTY) {
+            /* The bit is cleared, so union and symmetric difference set it. */
+            if (operation != SUB_SET) {
+                *section |= mask;
+                result->cardinality++;
+            }
+        } else if (operation != UNION_SET) {
+            /* The bit is set, so difference and symmetric difference clear it. */
+            *section &= ~mask;
+            result->cardinality--;
+        }
+    }
+
+    return TRUE;
+}
+
+/**
+ * Applies union or intersection to two run containers, interval by interval.
+ *
+ * @param containerA The first run container.
+ * @param containerB The second run container.
+ * @param result The container to store the result in.
+ * @param operation The operation to apply (UNION_SET or INTERSECT_SET).
+ * @return TRUE if the operation has been applied, FALSE if the memory allocation failed.
+ */
+static boolean combineRuns(const container *containerA, const container *containerB, container *result, int operation) {
+    const valuerun *runsA; /* The runs of the first container. */
+    const valuerun *runsB; /* The runs of the second container. */
+    uint32_t indexA;       /* Current index in the first container. */
+    uint32_t indexB;       /* Current index in the second container. */
+    unsigned long endA;    /* The last value of the current run of the first container. */
+    unsigned long endB;    /* The last value of the current run of the second container. */
+    unsigned long start;   /* The first value of the current run of the result. */
+    unsigned long end;     /* The last value of the current run of the result. */
+    valuerun *output;      /* The runs of the result. */
+    valuerun *last;        /* The last run of the result. */
+
+    if (!createRunContainer(result, containerA->key, containerA->count + containerB->count)) {
+        return FALSE;
+    }
+
+    runsA = containerA->data.runs;
+    runsB = containerB->data.runs;
+    output = result->data.runs;
+    indexA = indexB = FIRST_INDEX;
+
+    if (operation == INTERSECT_SET) {
+        /* Keep the overlap of the current runs, then move past the one which ends first. */
+        while (indexA < containerA->count && indexB < containerB->count) {
+            endA = (unsigned long)runsA[indexA].start + runsA[indexA].length;
+            endB = (unsigned long)runsB[indexB].start + runsB[indexB].length;
+            start = runsA[indexA].start > runsB[indexB].start ? runsA[indexA].start : runsB[indexB].start;
+            end = endA < endB ? endA : endB;
+
+            if (start <= end) {
+                output[result->count].start = (uint16_t)start;
+                output[result->count].length = (uint16_t)(end - start);
+                result->count++;
+                result->cardinality += end - start + NEXT_INDEX_DIFFERENCE;
+            }
+
+            if (endA < endB) {
+                indexA++;
+            } else {
+                indexB++;
+            }
+        }
+
+        return TRUE;
+    }
+
+    /* Take the runs of both containers in order of their starts, merging the ones which touch. */
+    while (indexA < containerA->count || indexB < containerB->count) {
+        if (indexB == containerB->count || (indexA < containerA->count && runsA[indexA].start <= runsB[indexB].start)) {
+            start = runsA[indexA].start;
+            end = start + runsA[indexA++].length;
+        } else {
+            start = runsB[indexB].start;
+            end = start + runsB[indexB++].length;
+        }
+
+        last = result->count == EMPTY ? NULL : &output[result->count - NEXT_INDEX_DIFFERENCE];
+
+        if (last != NULL && start <= (unsigned long)last->start + last->length + NEXT_INDEX_DIFFERENCE) {
+            /* Extend the last run of the result. */
+            if (end > (unsigned long)last->start + last->length) {
+                result->cardinality += end - last->start - last->length;
+                last->length = (uint16_t)(end - last->start);
+            }
+        } else {
+            /* Start a new run in the result. */
+            output[result->count].start = (uint16_t)start;
+            output[result->count].length = (uint16_t)(end - start);
+            result->count++;
+            result->cardinality += end - start + NEXT_INDEX_DIFFERENCE;
+        }
+    }
+
+    return TRUE;
+}
+
+/**
+ * Applies a set operation to two containers of any kinds, as two bitmaps.
+ *
+ * @param containerA The first container.
+ * @param containerB The second container.
+ * @param result The container to store the result in.
+ * @param operation The operation to apply.
+ * @return TRUE if the operation has been applied, FALSE if the memory allocation failed.
+ */
+static boolean combineAsBitmaps(const container *containerA, const container *containerB, container *result, int operation) {
+    setsection scratch[BITMAP_SECTIONS]; /* The members of the second container as a bitmap. */
+
+    if (!createBitmapContainer(result, containerA->key)) {
+        return FALSE;
+    }
+
+    fillBitmap(containerA, result->data.sections);
+    fillBitmap(containerB, scratch);
+    combineBitmaps(result->data.sections, scratch, operation);
+    result->cardinality = countBitmap(result->data.sections);
+    return TRUE;
+}
+
+/**
+ * Applies a set operation to two containers with the same key, using the kernel which fits their kinds.
+ * The result is allocated as the kind which keeps its members in the least memory.
+ * If the result is empty, its cardinality is 0 and no memory is allocated for it.
+ *
+ * @param containerA The first container to apply the operation to.
+ * @param containerB The second container to apply the operation to.
+ * @param result The container to store the result in.
+ * @param operation The operation to apply (UNION_SET, INTERSECT_SET, SUB_SET or SYMDIFF_SET).
+ * @return TRUE if the operation has been applied, FALSE if the memory allocation failed.
+ */
+boolean combineContainers(const container *containerA, const container *containerB, container *result, int operation) {
+    boolean isApplied; /* Has the operation been applied? */
+
+    if (containerA->type == ARRAY_CONTAINER && containerB->type == ARRAY_CONTAINER) {
+        /* Merge two arrays, unless a union or a symmetric difference could be too large for an array. */
+        if (operation == INTERSECT_SET || operation == SUB_SET || containerA->count + containerB->count <= ARRAY_MAX_CARDINALITY) {
+            isApplied = mergeArrays(containerA, containerB, result, operation);
+        } else {
+            isApplied = combineAsBitmaps(containerA, containerB, result, operation);
+        }
+    } else if (containerA->type == ARRAY_CONTAINER && containerB->type == BITMAP_CONTAINER) {
+        /* Check the array's values in the bitmap, or change the bitmap by the array's values. */
+        if (operation == INTERSECT_SET || operation == SUB_SET) {
+            isApplied = filterArray(containerA, containerB, result, operation == INTERSECT_SET);
+        } else {
+            isApplied = changeBitmap(containerB, containerA, result, operation);
+        }
+    } else if (containerA->type == BITMAP_CONTAINER && containerB->type == ARRAY_CONTAINER) {
+        /* Check the array's values in the bitmap, or change the bitmap by the array's values. */
+        if (operation == INTERSECT_SET) {
+            isApplied = filterArray(containerB, containerA, result, TRUE);
+        } else {
+            isApplied = changeBitmap(containerA, containerB, result, operation);
+        }
+    } else if (containerA->type == RUN_CONTAINER && containerB->type == RUN_CONTAINER && (operation == UNION_SET || operation == INTERSECT_SET)) {
+        isApplied = combineRuns(containerA, containerB, result, operation);
+    } else {
+        isApplied = combineAsBitmaps(containerA, containerB, result, operation);
+    }
+
+    if (!isApplied) {
+        return FALSE;
+    }
+
+    /* Convert the result to the kind which fits it best. */
+    if (!optimizeContainer(result)) {
+        freeContainer(result);
+        return FALSE;
+    }
+
+    return TRUE;
+}
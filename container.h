@@ -0,0 +1,237 @@
+/*
+ * container.h
+ * Includes the prototypes of all the functions in container.c.
+ * Also, includes the types of the containers a set is made of.
+ *
+ * Every set is split into chunks of 65536 potential members, which share the same high 16 bits (the key).
+ * Each chunk with at least one member is kept in a container of the kind which fits its members best:
+ * - An array container keeps the sorted low 16 bits of each member (up to 4096 members).
+ * - A bitmap container keeps a bit for each of the 65536 potential members.
+ * - A run container keeps the sorted intervals of consecutive members.
+ *
+ * Name: Ariel Keren
+ * Course: C Lab, 20465
+ * Semester: 2024B
+ * Date: 18/10/2026
+ */
+
+#ifndef CONTAINER_H
+#define CONTAINER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "globals.h"
+
+/* Each set section is a machine word, representing 64 numbers in the set (32 on 32-bit machines). */
+typedef unsigned long setsection;
+
+/* The number of numbers each section represents. */
+#define SECTION_BITS (sizeof(setsection) * BITS_PER_BYTE)
+
+/* Container information. */
+#define CONTAINER_BITS 16                                   /* The number of low bits of a member kept inside its container. */
+#define CONTAINER_VALUES 65536L                             /* The number of potential members in a single container. */
+#define LOW_BITS_MASK 0xFFFF                                /* The mask of the low bits of a member. */
+#define ARRAY_MAX_CARDINALITY 4096                          /* The largest number of members in an array container. */
+#define BITMAP_SECTIONS (CONTAINER_VALUES / SECTION_BITS)   /* The number of sections in a bitmap container. */
+#define BITMAP_BYTES (CONTAINER_VALUES / BITS_PER_BYTE)     /* The size of a bitmap container, in bytes. */
+
+/* The kinds of containers. */
+typedef enum { ARRAY_CONTAINER,
+               BITMAP_CONTAINER,
+               RUN_CONTAINER } containertype;
+
+/* An interval of consecutive members in a run container. */
+typedef struct {
+    uint16_t start;  /* The first value in the interval. */
+    uint16_t length; /* The number of values in the interval after the first one. */
+} valuerun;
+
+/* A container of all the members of a set which share the same key. */
+typedef struct {
+    containertype type;   /* The kind of the container. */
+    uint32_t key;         /* The high bits shared by every member in the container. */
+    uint32_t cardinality; /* The number of members in the container (0 only while it is being built). */
+    uint32_t count;       /* The number of values (array containers) or runs (run containers). */
+    uint32_t capacity;    /* The number of values or runs the container has memory for (0 if the container does not own its memory). */
+    union {
+        uint16_t *values;     /* The sorted values of an array container. */
+        setsection *sections; /* The sections of a bitmap container (aligned to a cache line). */
+        valuerun *runs;       /* The sorted runs of a run container. */
+    } data;
+} container;
+
+/**
+ * Counts the bits which are set in the given section.
+ *
+ * @param section The section to count the bits of.
+ * @return The number of bits which are set.
+ */
+unsigned countBits(setsection section);
+
+/**
+ * Finds the position of the lowest bit which is set in the given section.
+ * Assumes the section is not empty.
+ *
+ * @param section The section to check.
+ * @return The position of the lowest set bit (0 for the least significant bit).
+ */
+unsigned findLowestBit(setsection section);
+
+/**
+ * Finds the position of the highest bit which is set in the given section.
+ * Assumes the section is not empty.
+ *
+ * @param section The section to check.
+ * @return The position of the highest set bit (0 for the least significant bit).
+ */
+unsigned findHighestBit(setsection section);
+
+/**
+ * Allocates an empty array container.
+ *
+ * @param result The container to allocate.
+ * @param key The key of the container.
+ * @param capacity The number of values the container should have memory for.
+ * @return TRUE if the container has been allocated, FALSE if the memory allocation failed.
+ */
+boolean createArrayContainer(container *result, uint32_t key, uint32_t capacity);
+
+/**
+ * Allocates an empty bitmap container.
+ *
+ * @param result The container to allocate.
+ * @param key The key of the container.
+ * @return TRUE if the container has been allocated, FALSE if the memory allocation failed.
+ */
+boolean createBitmapContainer(container *result, uint32_t key);
+
+/**
+ * Allocates an empty run container.
+ *
+ * @param result The container to allocate.
+ * @param key The key of the container.
+ * @param capacity The number of runs the container should have memory for.
+ * @return TRUE if the container has been allocated, FALSE if the memory allocation failed.
+ */
+boolean createRunContainer(container *result, uint32_t key, uint32_t capacity);
+
+/**
+ * Fills the container with members kept in memory which it does not own (e.g. a mapped saved state).
+ * The members are used in place, so they are never changed or freed through the container.
+ *
+ * @param result The container to fill.
+ * @param type The kind of the container.
+ * @param key The key of the container.
+ * @param cardinality The number of members in the container.
+ * @param count The number of values (array containers) or runs (run containers).
+ * @param data The members of the container (aligned to a cache line for bitmap containers).
+ */
+void borrowContainer(container *result, containertype type, uint32_t key, uint32_t cardinality, uint32_t count, const void *data);
+
+/**
+ * Checks if the members of the container agree with its kind and its cardinality (e.g. for a container borrowed from a file).
+ * Array values should be strictly increasing, runs should be sorted, apart from each other and inside the container,
+ * and the number of members should be the cardinality of the container.
+ * @param source The container to check.
+ * @return TRUE if the members are consistent, FALSE otherwise.
+ */
+boolean isConsistentContainer(const container *source);
+
+/**
+ * Finds the first container in the given range of a sorted array of containers whose key is not smaller than the given one.
+ * @param containers The containers, sorted by their keys.
+ * @param low The first index to search from.
+ * @param high The index after the last one to search.
+ * @param key The key to find.
+ * @return The index of the container (high if every key in the range is smaller).
+ */
+size_t findContainerIndex(const container containers[], size_t low, size_t high, unsigned long key);
+
+/**
+ * Frees the memory used by the container.
+ * The memory of a container which does not own it is left as it is.
+ *
+ * @param target The container to free.
+ */
+void freeContainer(container *target);
+
+/**
+ * Copies the container (including its members) to a newly allocated container.
+ *
+ * @param source The container to copy.
+ * @param result The container to allocate and fill.
+ * @return TRUE if the container has been copied, FALSE if the memory allocation failed.
+ */
+boolean copyContainer(const container *source, container *result);
+
+/**
+ * Adds the given value to the container.
+ * An array container which becomes too large is converted to a bitmap container.
+ * A run container is converted to a bitmap container first.
+ *
+ * @param target The container to add the value to.
+ * @param value The low bits of the member to add.
+ * @return TRUE if the value has been added, FALSE if the memory allocation failed.
+ */
+boolean addContainerValue(container *target, uint16_t value);
+
+/**
+ * Sets a bit in the given bitmap for every member of the container.
+ * Clears all the other bits.
+ *
+ * @param source The container to convert.
+ * @param sections The bitmap to fill (65536 bits).
+ */
+void fillBitmap(const container *source, setsection sections[]);
+
+/**
+ * Counts the bits which are set in the given bitmap.
+ *
+ * @param sections The bitmap to count the bits of.
+ * @return The number of bits which are set.
+ */
+uint32_t countBitmap(const setsection sections[]);
+
+/**
+ * Returns the smallest value in the container.
+ * Assumes the container is not empty.
+ *
+ * @param source The container to check.
+ * @return The low bits of the smallest member in the container.
+ */
+uint16_t findMinimumValue(const container *source);
+
+/**
+ * Returns the largest value in the container.
+ * Assumes the container is not empty.
+ *
+ * @param source The container to check.
+ * @return The low bits of the largest member in the container.
+ */
+uint16_t findMaximumValue(const container *source);
+
+/**
+ * Converts the container to the kind which keeps its members in the least memory.
+ * Frees the memory of an empty container.
+ *
+ * @param target The container to convert.
+ * @return TRUE if the container has been converted, FALSE if the memory allocation failed.
+ */
+boolean optimizeContainer(container *target);
+
+/**
+ * Applies a set operation to two containers with the same key, using the kernel which fits their kinds.
+ * The result is allocated as the kind which keeps its members in the least memory.
+ * If the result is empty, its cardinality is 0 and no memory is allocated for it.
+ *
+ * @param containerA The first container to apply the operation to.
+ * @param containerB The second container to apply the operation to.
+ * @param result The container to store the result in.
+ * @param operation The operation to apply (UNION_SET, INTERSECT_SET, SUB_SET or SYMDIFF_SET).
+ * @return TRUE if the operation has been applied, FALSE if the memory allocation failed.
+ */
+boolean combineContainers(const container *containerA, const container *containerB, container *result, int operation);
+
+#endif
@@ -1,7 +1,8 @@
 /*
  * execution.c
  * Includes functions to execute every possible command in the program.
- * All functions in this file assume that the input command is valid.
+ * All functions in this file assume that the instruction has been compiled from a valid command.
+ * Commands which write a set are added to the command graph, and are only applied once a command observes their result.
  *
  * Name: Ariel Keren
  * Course: C Lab, 20465
@@ -12,179 +13,306 @@
 #include "execution.h"
 
 #include <stdio.h>
-#include <stdlib.h>
+#include <string.h>
 
+#include "bulk.h"
+#include "calculator.h"
 #include "globals.h"
+#include "graph.h"
+#include "registry.h"
 #include "set.h"
-#include "utils.h"
+#include "snapshot.h"
+#include "stats.h"
+#include "validation.h"
 
 /**
- * Executes the input line, based on the operation and the operands.
+ * Returns the current members of the set named by the given operand of the command.
+ * Sets the error of the command if the set is not defined.
  *
- * @param line The input line.
- * @param sets An array of sets.
- * @return TRUE if the program should be stopped, FALSE otherwise.
+ * @param command The instruction which names the set.
+ * @param sets The registry of every defined set.
+ * @param operand The index of the operand which names the set.
+ * @return The members of the set, or NULL if it is not defined.
  */
-boolean executeLine(char line[], setptr sets[]) {
-    boolean isStopped; /* Is the program stopped? */
-    char *lineCopy;    /* A copy of the input line. */
+static const set *observeOperand(instruction *command, const setregistry *sets, int operand) {
+    const set *found; /* The members of the set named by the operand. */
+
+    found = observeSet(sets, &command->operands[operand]);
 
-    /* Copy the input line to tokenize it. */
-    lineCopy = duplicateString(line);
-    isStopped = FALSE;
+    if (found == NULL) {
+        command->error = "Undefined set name.";
+    }
+
+    return found;
+}
 
+/**
+ * Executes the compiled instruction, based on the operation and the operands.
+ * Assumes the instruction has been compiled from a valid line.
+ * If the instruction cannot be executed (e.g. it refers to a set which is not defined), sets its error.
+ *
+ * @param command The instruction to execute.
+ * @param sets The registry of every defined set.
+ * @return TRUE if the program should be stopped, FALSE otherwise.
+ */
+boolean executeInstruction(instruction *command, setregistry *sets) {
     /* Determine the operation. */
-    switch (getOperationIndex(tokenizeLine(lineCopy))) {
+    switch (command->operation) {
         case STOP:
             /* stop. */
-            isStopped = TRUE;
-            break;
+            return TRUE;
         case PRINT_SET:
             /* print_set. */
-            executePrintSet(line, sets);
+            executePrintSet(command, sets);
             break;
         case READ_SET:
             /* read_set. */
-            executeReadSet(line, sets);
+            executeReadSet(command, sets);
+            break;
+        case DROP_SET:
+            /* drop_set. */
+            executeDropSet(command, sets);
+            break;
+        case COUNT_SET:
+        case MIN_SET:
+        case MAX_SET:
+            /* count_set, min_set, max_set. */
+            executeSetQuery(command, sets);
+            break;
+        case EVAL_SET:
+            /* eval. */
+            executeEval(command, sets);
+            break;
+        case CACHE_STATS:
+            /* cache_stats. */
+            executeCacheStats();
+            break;
+        case STATISTICS:
+            /* stats. */
+            executeStatistics(command);
+            break;
+        case SAVE_STATE:
+            /* save_state. */
+            executeSaveState(command, sets);
+            break;
+        case LOAD_STATE:
+            /* load_state. */
+            executeLoadState(command, sets);
+            break;
+        case LOAD_SET:
+            /* load_set. */
+            executeLoadSet(command, sets);
+            break;
+        case DUMP_SET:
+            /* dump_set. */
+            executeDumpSet(command, sets);
             break;
         default:
             /* union_set, intersect_set, sub_set, symdiff_set. */
-            executeSetOperation(line, sets);
+            executeSetOperation(command, sets);
             break;
     }
 
-    /* The copy is no longer used. */
-    free(lineCopy);
-    /* Return whether to stop the program or not. */
-    return isStopped;
+    /* Do not stop the program. */
+    return FALSE;
 }
 
 /**
  * Executes the print_set command.
- * Prints the set specified by the command.
+ * Prints the set specified by the command (computing its latest version first).
+ * Sets the error of the command if the set is not defined.
  *
- * @param line The input line.
- * @param sets An array of sets.
+ * @param command The instruction to execute.
+ * @param sets The registry of every defined set.
  */
-void executePrintSet(char line[], setptr sets[]) {
-    char *lineCopy; /* A copy of the input line. */
-
-    /* Copy the input line to tokenize it. */
-    lineCopy = duplicateString(line);
-    tokenizeLine(lineCopy);
-    /* Print the set. */
-    print_set(sets[getSetIndex(getNextToken())]);
+void executePrintSet(instruction *command, setregistry *sets) {
+    const set *target; /* The set to print. */
 
-    /* The copy is no longer used. */
-    free(lineCopy);
+    /* Print the set (if it is defined). */
+    if ((target = observeOperand(command, sets, FIRST_INDEX)) != NULL) {
+        print_set(target);
+    }
 }
 
 /**
  * Executes the read_set command.
- * Fills the set with the given numbers, as specified by the command.
+ * Adds the decoded members to the command graph, as the latest version of the set specified by the command.
+ * Defines the set if it is not defined yet.
+ * The members of the command are left empty.
+ * Exits the program if the memory allocation fails.
+ *
+ * @param command The instruction to execute.
+ * @param sets The registry of every defined set.
+ */
+void executeReadSet(instruction *command, setregistry *sets) {
+    /* Add the members as the latest version of the set. */
+    recordMembers(sets, &command->operands[FIRST_INDEX], &command->members);
+}
+
+/**
+ * Executes the drop_set command.
+ * Removes the set specified by the command and frees its memory.
+ * Stores the latest version of every set in the graph first.
+ * Sets the error of the command if the set is not defined.
  *
- * @param line The input line.
- * @param sets An array of sets.
+ * @param command The instruction to execute.
+ * @param sets The registry of every defined set.
  */
-void executeReadSet(char line[], setptr sets[]) {
-    operand *numbers; /* The numbers to fill the set with. */
-    size_t length;    /* The length of the numbers array. */
-    size_t index;     /* Current index in the numbers array. */
-    setptr setToFill; /* The set to fill, specified in the input line. */
-    char *lineCopy;   /* A copy of the input line. */
-
-    /* Copy the input line to tokenize it. */
-    lineCopy = duplicateString(line);
-    tokenizeLine(lineCopy);
-    /* Determine which set to fill. */
-    setToFill = sets[getSetIndex(getNextToken())];
-    length = STARTING_VALUE;
-
-    /* Count the number of operands. */
-    while (getNextToken() != NULL) {
-        length++;
+void executeDropSet(instruction *command, setregistry *sets) {
+    /* Store the latest version of every set first, since the pending commands may still read this set. */
+    commitVersions();
+
+    /* Remove the set. */
+    if (!dropSet(sets, &command->operands[FIRST_INDEX])) {
+        command->error = "Undefined set name.";
     }
+}
 
-    /* Exhausted the copy. */
-    free(lineCopy);
+/**
+ * Executes the count_set, min_set or max_set command.
+ * Prints the number of members, the smallest member or the largest member of the set specified by the command (computing its latest version first).
+ * Sets the error of the command if the set is not defined.
+ *
+ * @param command The instruction to execute.
+ * @param sets The registry of every defined set.
+ */
+void executeSetQuery(instruction *command, setregistry *sets) {
+    const set *target; /* The set to check. */
 
-    /* Allocate enough memory for the numbers array. */
-    numbers = malloc(length * sizeof(operand));
+    /* Check if the set is not defined. */
+    if ((target = observeOperand(command, sets, FIRST_INDEX)) == NULL) {
+        return;
+    }
 
-    /* Check for an error in the memory allocation. */
-    if (numbers == NULL) {
-        /* Exit the program. */
-        fprintf(stderr, "Failed to allocate memory for read_set's integer operands.\n");
-        exit(ERROR);
+    /* Determine what to print about the set. */
+    switch (command->operation) {
+        case COUNT_SET:
+            count_set(target);
+            break;
+        case MIN_SET:
+            min_set(target);
+            break;
+        default:
+            max_set(target);
+            break;
     }
+}
 
-    /* Make another copy of the input line. */
-    lineCopy = duplicateString(line);
-    /* Tokenize it again. */
-    tokenizeLine(lineCopy);
-    /* Skip the second token, which is the set name. */
-    getNextToken();
-
-    /* Loop over the numbers array and fill it. */
-    for (index = FIRST_INDEX; index < length; index++) {
-        /* Get the current number and convert it to an integer. */
-        numbers[index] = atoi(getNextToken());
+/**
+ * Executes union_set, intersect_set, sub_set or symdiff_set.
+ * Adds the result of the operation to the command graph, as the latest version of the set to store it in.
+ * The operation is only applied once the result is observed (and never, if the set is written again first).
+ * Defines the set to store the result in if it is not defined yet.
+ * Sets the error of the command if one of the sets to combine is not defined.
+ * Exits the program if the memory allocation fails.
+ *
+ * @param command The instruction to execute.
+ * @param sets The registry of every defined set.
+ */
+void executeSetOperation(instruction *command, setregistry *sets) {
+    if (!recordExpression(sets, command->operation, &command->formula, &command->operands[THIRD_INDEX])) {
+        command->error = "Undefined set name.";
     }
+}
 
-    /* The copy is no longer used. */
-    free(lineCopy);
-    /* Fill the set. */
-    read_set(setToFill, numbers);
-    /* The numbers array is no longer needed. */
-    free(numbers);
+/**
+ * Executes the eval command.
+ * Adds the result of the expression to the command graph, as the latest version of the set specified by the command.
+ * The expression is only evaluated once the result is observed (and never, if the set is written again first).
+ * Defines the set to store the result in if it is not defined yet.
+ * Sets the error of the command if one of the sets in the expression is not defined.
+ * Exits the program if the memory allocation fails.
+ *
+ * @param command The instruction to execute.
+ * @param sets The registry of every defined set.
+ */
+void executeEval(instruction *command, setregistry *sets) {
+    if (!recordExpression(sets, EVAL_SET, &command->formula, &command->operands[FIRST_INDEX])) {
+        command->error = "Undefined set name.";
+    }
 }
 
 /**
- * Executes union_set, intersect_set, sub_set or symdiff_set.
- * Applies the operation to the sets, as specified by the command.
+ * Executes the cache_stats command.
+ * Prints the number of set operations (and eval commands) which have reused an existing result, and the number which have not.
+ */
+void executeCacheStats() {
+    unsigned long hits;                /* The number of commands which have reused an existing result. */
+    unsigned long misses;              /* The number of commands which have not. */
+    char line[STATISTICS_LINE_LENGTH]; /* The printed line. */
+
+    getCacheStatistics(&hits, &misses);
+    sprintf(line, "Reused results: %lu, computed results: %lu\n", hits, misses);
+    writeOutput(line, strlen(line));
+}
+
+/**
+ * Executes the stats command.
+ * Prints the statistics of every phase of every operation (see stats.h).
+ * Sets the error of the command if the statistics have been compiled out of the program.
+ *
+ * @param command The instruction to execute.
+ */
+void executeStatistics(instruction *command) {
+    command->error = writeStatistics(getCalculator()->output, getCalculator()->sinkData);
+}
+
+/**
+ * Executes the save_state command.
+ * Saves every set to the file specified by the command (storing the latest version of every set in the graph first).
+ * Sets the error of the command if the file cannot be written.
+ *
+ * @param command The instruction to execute.
+ * @param sets The registry of every defined set.
+ */
+void executeSaveState(instruction *command, setregistry *sets) {
+    /* Only the members stored in the sets themselves are saved. */
+    commitVersions();
+    command->error = saveState(sets, command->path);
+}
+
+/**
+ * Executes the load_state command.
+ * Replaces every set with the sets saved in the file specified by the command.
+ * Sets the error of the command if the file is not a valid saved state (the sets are left as they are).
+ *
+ * @param command The instruction to execute.
+ * @param sets The registry of every defined set.
+ */
+void executeLoadState(instruction *command, setregistry *sets) {
+    command->error = loadState(sets, command->path);
+}
+
+/**
+ * Executes the load_set command.
+ * Adds the members kept in the file specified by the command to the command graph, as the latest version of the set.
+ * Defines the set if it is not defined yet.
+ * Sets the error of the command if the file is not valid (the set is left as it is).
+ * Exits the program if the memory allocation fails.
  *
- * @param line The input line.
- * @param sets An array of sets.
+ * @param command The instruction to execute.
+ * @param sets The registry of every defined set.
  */
-void executeSetOperation(char line[], setptr sets[]) {
-    int operationIndex;                        /* The index of the operation. */
-    unsigned index;                            /* Current index in the target sets array.*/
-    char *lineCopy;                            /* A copy of the input line.*/
-    setptr targetSets[SET_OPERATION_OPERANDS]; /* The three target sets. */
-
-    /* Copy the input line to tokenize it. */
-    lineCopy = duplicateString(line);
-    /* Tokenize the input line, and get the operation index. */
-    operationIndex = getOperationIndex(tokenizeLine(lineCopy));
-
-    /* Loop over the target sets and fill it with the set operands. */
-    for (index = FIRST_INDEX; index < SET_OPERATION_OPERANDS; index++) {
-        targetSets[index] = sets[getSetIndex(getNextToken())];
+void executeLoadSet(instruction *command, setregistry *sets) {
+    /* Decode the file into the members of the command, like read_set. */
+    if ((command->error = loadSetFile(command->path, command->format, &command->members)) == NULL) {
+        recordMembers(sets, &command->operands[FIRST_INDEX], &command->members);
     }
+}
 
-    /* The copy is no longer used. */
-    free(lineCopy);
+/**
+ * Executes the dump_set command.
+ * Writes the members of the set specified by the command (computing its latest version first) to the file specified by the command.
+ * Sets the error of the command if the set is not defined or if the file cannot be written.
+ *
+ * @param command The instruction to execute.
+ * @param sets The registry of every defined set.
+ */
+void executeDumpSet(instruction *command, setregistry *sets) {
+    const set *source; /* The set to write. */
 
-    /* Determine what operation to execute. */
-    switch (operationIndex) {
-        case UNION_SET:
-            /* Apply the union operation to the first two sets and store the result in the third. */
-            union_set(targetSets[FIRST_INDEX], targetSets[SECOND_INDEX], targetSets[THIRD_INDEX]);
-            break;
-        case INTERSECT_SET:
-            /* Apply the intersection operation to the first two sets and store the result in the third. */
-            intersect_set(targetSets[FIRST_INDEX], targetSets[SECOND_INDEX], targetSets[THIRD_INDEX]);
-            break;
-        case SUB_SET:
-            /* Apply the difference operation to the first two sets and store the result in the third. */
-            sub_set(targetSets[FIRST_INDEX], targetSets[SECOND_INDEX], targetSets[THIRD_INDEX]);
-            break;
-        case SYMDIFF_SET:
-            /* Apply the symmetric difference operation to the first two sets and store the result in the third. */
-            symdiff_set(targetSets[FIRST_INDEX], targetSets[SECOND_INDEX], targetSets[THIRD_INDEX]);
-            break;
-        default:
-            /* Should not happen (if the line validation works well). */
-            break;
+    /* Write the set (if it is defined). */
+    if ((source = observeOperand(command, sets, FIRST_INDEX)) != NULL) {
+        command->error = dumpSetFile(source, command->path, command->format);
     }
 }
@@ -11,42 +11,145 @@
 #ifndef EXECUTION_H
 #define EXECUTION_H
 
+#include "registry.h"
 #include "set.h"
+#include "validation.h"
 
 /**
- * Executes the input line, based on the operation and the operands.
+ * Executes the compiled instruction, based on the operation and the operands.
+ * Assumes the instruction has been compiled from a valid line.
+ * If the instruction cannot be executed (e.g. it refers to a set which is not defined), sets its error.
  *
- * @param line The input line.
- * @param sets An array of sets.
+ * @param command The instruction to execute.
+ * @param sets The registry of every defined set.
  * @return TRUE if the program should be stopped, FALSE otherwise.
  */
-boolean executeLine(char line[], setptr sets[]);
+boolean executeInstruction(instruction *command, setregistry *sets);
 
 /**
  * Executes the print_set command.
- * Prints the set specified by the command.
+ * Prints the set specified by the command (computing its latest version first).
+ * Sets the error of the command if the set is not defined.
  *
- * @param line The input line.
- * @param sets An array of sets.
+ * @param command The instruction to execute.
+ * @param sets The registry of every defined set.
  */
-void executePrintSet(char line[], setptr sets[]);
+void executePrintSet(instruction *command, setregistry *sets);
 
 /**
  * Executes the read_set command.
- * Fills the set with the given numbers, as specified by the command.
+ * Adds the decoded members to the command graph, as the latest version of the set specified by the command.
+ * Defines the set if it is not defined yet.
+ * The members of the command are left empty.
+ * Exits the program if the memory allocation fails.
  *
- * @param line The input line.
- * @param sets An array of sets.
+ * @param command The instruction to execute.
+ * @param sets The registry of every defined set.
  */
-void executeReadSet(char line[], setptr sets[]);
+void executeReadSet(instruction *command, setregistry *sets);
+
+/**
+ * Executes the drop_set command.
+ * Removes the set specified by the command and frees its memory.
+ * Stores the latest version of every set in the graph first.
+ * Sets the error of the command if the set is not defined.
+ *
+ * @param command The instruction to execute.
+ * @param sets The registry of every defined set.
+ */
+void executeDropSet(instruction *command, setregistry *sets);
+
+/**
+ * Executes the count_set, min_set or max_set command.
+ * Prints the number of members, the smallest member or the largest member of the set specified by the command (computing its latest version first).
+ * Sets the error of the command if the set is not defined.
+ *
+ * @param command The instruction to execute.
+ * @param sets The registry of every defined set.
+ */
+void executeSetQuery(instruction *command, setregistry *sets);
 
 /**
  * Executes union_set, intersect_set, sub_set or symdiff_set.
- * Applies the operation to the sets, as specified by the command.
+ * Adds the result of the operation to the command graph, as the latest version of the set to store it in.
+ * The operation is only applied once the result is observed (and never, if the set is written again first).
+ * Defines the set to store the result in if it is not defined yet.
+ * Sets the error of the command if one of the sets to combine is not defined.
+ * Exits the program if the memory allocation fails.
+ *
+ * @param command The instruction to execute.
+ * @param sets The registry of every defined set.
+ */
+void executeSetOperation(instruction *command, setregistry *sets);
+
+/**
+ * Executes the eval command.
+ * Adds the result of the expression to the command graph, as the latest version of the set specified by the command.
+ * The expression is only evaluated once the result is observed (and never, if the set is written again first).
+ * Defines the set to store the result in if it is not defined yet.
+ * Sets the error of the command if one of the sets in the expression is not defined.
+ * Exits the program if the memory allocation fails.
+ *
+ * @param command The instruction to execute.
+ * @param sets The registry of every defined set.
+ */
+void executeEval(instruction *command, setregistry *sets);
+
+/**
+ * Executes the cache_stats command.
+ * Prints the number of set operations (and eval commands) which have reused an existing result, and the number which have not.
+ */
+void executeCacheStats();
+
+/**
+ * Executes the stats command.
+ * Prints the statistics of every phase of every operation (see stats.h).
+ * Sets the error of the command if the statistics have been compiled out of the program.
+ *
+ * @param command The instruction to execute.
+ */
+void executeStatistics(instruction *command);
+
+/**
+ * Executes the save_state command.
+ * Saves every set to the file specified by the command (storing the latest version of every set in the graph first).
+ * Sets the error of the command if the file cannot be written.
+ *
+ * @param command The instruction to execute.
+ * @param sets The registry of every defined set.
+ */
+void executeSaveState(instruction *command, setregistry *sets);
+
+/**
+ * Executes the load_state command.
+ * Replaces every set with the sets saved in the file specified by the command.
+ * Sets the error of the command if the file is not a valid saved state (the sets are left as they are).
+ *
+ * @param command The instruction to execute.
+ * @param sets The registry of every defined set.
+ */
+void executeLoadState(instruction *command, setregistry *sets);
+
+/**
+ * Executes the load_set command.
+ * Adds the members kept in the file specified by the command to the command graph, as the latest version of the set.
+ * Defines the set if it is not defined yet.
+ * Sets the error of the command if the file is not valid (the set is left as it is).
+ * Exits the program if the memory allocation fails.
+ *
+ * @param command The instruction to execute.
+ * @param sets The registry of every defined set.
+ */
+void executeLoadSet(instruction *command, setregistry *sets);
+
+/**
+ * Executes the dump_set command.
+ * Writes the members of the set specified by the command (computing its latest version first) to the file specified by the command.
+ * Sets the error of the command if the set is not defined or if the file cannot be written.
  *
- * @param line The input line.
- * @param sets An array of sets.
+ * @param command The instruction to execute.
+ * @param sets The registry of every defined set.
  */
-void executeSetOperation(char line[], setptr sets[]);
+void executeDumpSet(instruction *command, setregistry *sets);
 
 #endif
@@ -0,0 +1,774 @@
+/*
+ * expression.c
+ * Includes functions for compiling set expressions (by recursive descent) and evaluating them.
+ * An expression is evaluated chunk by chunk (the same chunks the containers of a set cover).
+ * In every chunk, the whole expression is applied to a cache line of every input at a time,
+ * so no intermediate set is ever built.
+ *
+ * Name: Ariel Keren
+ * Course: C Lab, 20465
+ * Semester: 2024B
+ * Date: 18/10/2026
+ */
+
+#include "expression.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "calculator.h"
+#include "container.h"
+#include "globals.h"
+#include "registry.h"
+#include "set.h"
+#include "setUtils.h"
+#include "utils.h"
+
+/* The number of set sections in a single cache line (the block an expression is applied to at a time). */
+#define BLOCK_SECTIONS (CACHE_LINE_SIZE / sizeof(setsection))
+
+/* The state of the compiler while walking over the text of an expression. */
+typedef struct {
+    const char *text;    /* The text of the expression. */
+    size_t length;       /* The number of characters in the text. */
+    size_t position;     /* The offset of the next character to check. */
+    size_t nesting;      /* The number of parentheses and complements the current position is nested in. */
+    size_t stackSize;    /* The number of operands on the stack after the steps compiled so far. */
+    expression *formula; /* The expression being compiled. */
+} compiler;
+
+/* The sections of an empty chunk (used for inputs which have no container in the current chunk). */
+static const setsection emptyChunk[BITMAP_SECTIONS];
+
+static boolean compileUnion(compiler *state);
+
+/**
+ * Prepares an empty expression, which can be reused for every line.
+ * Does not allocate any memory.
+ *
+ * @param formula The expression to prepare.
+ */
+void initializeExpression(expression *formula) {
+    formula->steps = NULL;
+    formula->stepCount = formula->stepCapacity = STARTING_VALUE;
+    formula->names = NULL;
+    formula->inputs = NULL;
+    formula->nameCount = formula->nameCapacity = STARTING_VALUE;
+    formula->depth = STARTING_VALUE;
+    formula->error = NULL;
+}
+
+/**
+ * Removes every step and set name from the expression (keeping its memory).
+ *
+ * @param formula The expression to clear.
+ */
+void clearExpression(expression *formula) {
+    formula->stepCount = STARTING_VALUE;
+    formula->nameCount = STARTING_VALUE;
+    formula->depth = STARTING_VALUE;
+    formula->error = NULL;
+}
+
+/**
+ * Frees the memory used by the expression.
+ *
+ * @param formula The expression to free.
+ */
+void freeExpression(expression *formula) {
+    free(formula->steps);
+    free(formula->names);
+    free((void *)formula->inputs);
+    initializeExpression(formula);
+}
+
+/**
+ * Copies the steps of the expression to another expression, which is allocated separately.
+ * The names of the sets are not copied (they point into the line), but the number of sets is.
+ *
+ * @param copy The expression to fill (its previous steps are freed).
+ * @param formula The expression to copy.
+ * @return TRUE if the expression has been copied, FALSE if the memory allocation failed.
+ */
+boolean copyExpression(expression *copy, const expression *formula) {
+    freeExpression(copy);
+    copy->steps = malloc(formula->stepCount * sizeof(expressionstep));
+    copy->inputs = malloc(formula->nameCount * sizeof(const set *));
+
+    if (copy->steps == NULL || copy->inputs == NULL) {
+        freeExpression(copy);
+        return FALSE;
+    }
+
+    memcpy(copy->steps, formula->steps, formula->stepCount * sizeof(expressionstep));
+    copy->stepCount = copy->stepCapacity = formula->stepCount;
+    copy->nameCount = copy->nameCapacity = formula->nameCount;
+    copy->depth = formula->depth;
+    return TRUE;
+}
+
+/**
+ * Adds a step to the end of the expression.
+ * Keeps track of the number of operands on the stack.
+ * Exits the program if the memory allocation fails.
+ *
+ * @param state The state of the compiler.
+ * @param type The kind of the step.
+ * @param operand The index of the set to push (operand steps only).
+ */
+static void addStep(compiler *state, steptype type, size_t operand) {
+    expression *formula;      /* The expression being compiled. */
+    expressionstep *steps;    /* The grown array of steps. */
+    size_t capacity;          /* The number of steps the grown array has memory for. */
+
+    formula = state->formula;
+
+    /* Grow the array of steps (geometrically) if it is full. */
+    if (formula->stepCount == formula->stepCapacity) {
+        capacity = formula->stepCapacity == EMPTY ? INITIAL_STEPS : formula->stepCapacity * GROWTH_FACTOR;
+        steps = realloc(formula->steps, capacity * sizeof(expressionstep));
+
+        if (steps == NULL) {
+            failMemory("Failed to allocate memory for the expression.");
+        }
+
+        formula->steps = steps;
+        formula->stepCapacity = capacity;
+    }
+
+    formula->steps[formula->stepCount].type = type;
+    formula->steps[formula->stepCount].operand = operand;
+    formula->stepCount++;
+
+    /* An operand is pushed onto the stack, and a binary operator pops two operands and pushes one. */
+    if (type == OPERAND_STEP) {
+        if (++state->stackSize > formula->depth) {
+            formula->depth = state->stackSize;
+        }
+    } else if (type != COMPLEMENT_STEP) {
+        state->stackSize--;
+    }
+}
+
+/**
+ * Returns the index of the given set name among the distinct sets in the expression, adding it if it is new.
+ * Exits the program if the memory allocation fails.
+ *
+ * @param formula The expression being compiled.
+ * @param name The first character of the name.
+ * @param length The number of characters in the name.
+ * @return The index of the set name.
+ */
+static size_t addName(expression *formula, const char name[], size_t length) {
+    setname current;     /* The given name, along with its hash. */
+    size_t index;        /* Current index in the names. */
+    setname *names;      /* The grown array of names. */
+    const set **inputs;  /* The grown array of sets. */
+    size_t capacity;     /* The number of names the grown arrays have memory for. */
+
+    nameSet(&current, name, length);
+
+    /* Check if the set has already appeared in the expression. */
+    for (index = FIRST_INDEX; index < formula->nameCount; index++) {
+        if (formula->names[index].hash == current.hash && formula->names[index].length == length && !memcmp(formula->names[index].name, name, length)) {
+            return index;
+        }
+    }
+
+    /* Grow the arrays of names and sets (geometrically) if they are full. */
+    if (formula->nameCount == formula->nameCapacity) {
+        capacity = formula->nameCapacity == EMPTY ? INITIAL_STEPS : formula->nameCapacity * GROWTH_FACTOR;
+        names = realloc(formula->names, capacity * sizeof(setname));
+
+        if (names != NULL) {
+            formula->names = names;
+        }
+
+        inputs = realloc((void *)formula->inputs, capacity * sizeof(const set *));
+
+        if (inputs != NULL) {
+            formula->inputs = inputs;
+        }
+
+        if (names == NULL || inputs == NULL) {
+            failMemory("Failed to allocate memory for the expression.");
+        }
+
+        formula->nameCapacity = capacity;
+    }
+
+    formula->names[formula->nameCount] = current;
+    return formula->nameCount++;
+}
+
+/**
+ * Marks the expression as invalid because of the given error.
+ *
+ * @param state The state of the compiler.
+ * @param error The reason the expression is invalid.
+ * @return FALSE (so it can be returned by the compiling functions).
+ */
+static boolean rejectExpression(compiler *state, const char error[]) {
+    state->formula->error = error;
+    return FALSE;
+}
+
+/**
+ * Skips the whitespace characters at the current position, and returns the next character.
+ *
+ * @param state The state of the compiler.
+ * @return The next character, or '\0' at the end of the text.
+ */
+static char peekCharacter(compiler *state) {
+    /* Skip the whitespace characters. */
+    while (state->position < state->length && isspace((unsigned char)state->text[state->position])) {
+        state->position++;
+    }
+
+    return state->position < state->length ? state->text[state->position] : '\0';
+}
+
+/**
+ * Compiles a single set, a complemented operand or a parenthesized expression.
+ *
+ * @param state The state of the compiler.
+ * @return TRUE if the operand is valid, FALSE otherwise.
+ */
+static boolean compileOperand(compiler *state) {
+    char next;    /* The next character. */
+    size_t start; /* The offset of the first character of a set name. */
+
+    next = peekCharacter(state);
+
+    /* Complements and parentheses are nested, so their depth is limited. */
+    if ((next == '~' || next == '(') && ++state->nesting > MAXIMUM_NESTING) {
+        return rejectExpression(state, "The expression is nested too deeply.");
+    }
+
+    /* Handle a complemented operand. */
+    if (next == '~') {
+        state->position++;
+
+        if (!compileOperand(state)) {
+            return FALSE;
+        }
+
+        addStep(state, COMPLEMENT_STEP, EMPTY);
+        state->nesting--;
+        return TRUE;
+    }
+
+    /* Handle a parenthesized expression. */
+    if (next == '(') {
+        state->position++;
+
+        if (!compileUnion(state)) {
+            return FALSE;
+        }
+
+        if (peekCharacter(state) != ')') {
+            return rejectExpression(state, "Missing closing parenthesis.");
+        }
+
+        state->position++;
+        state->nesting--;
+        return TRUE;
+    }
+
+    start = state->position;
+
+    /* Find the end of the set name. */
+    while (state->position < state->length && (isalnum((unsigned char)state->text[state->position]) || state->text[state->position] == '_')) {
+        state->position++;
+    }
+
+    /* Check if there is no operand at all. */
+    if (state->position == start) {
+        return rejectExpression(state, "Missing set in the expression.");
+    }
+
+    /* Check if the operand is a valid set name. */
+    if (!isSetName(state->text + start, state->position - start)) {
+        return rejectExpression(state, "Invalid set name.");
+    }
+
+    addStep(state, OPERAND_STEP, addName(state->formula, state->text + start, state->position - start));
+    return TRUE;
+}
+
+/**
+ * Compiles a sequence of operands joined by & (intersection) or - (difference).
+ *
+ * @param state The state of the compiler.
+ * @return TRUE if the sequence is valid, FALSE otherwise.
+ */
+static boolean compileIntersection(compiler *state) {
+    char next; /* The next character. */
+
+    if (!compileOperand(state)) {
+        return FALSE;
+    }
+
+    /* Compile every following operand, and apply the operator after it. */
+    while ((next = peekCharacter(state)) == '&' || next == '-') {
+        state->position++;
+
+        if (!compileOperand(state)) {
+            return FALSE;
+        }
+
+        addStep(state, next == '&' ? INTERSECT_STEP : SUB_STEP, EMPTY);
+    }
+
+    return TRUE;
+}
+
+/**
+ * Compiles a sequence of intersections joined by ^ (symmetric difference).
+ *
+ * @param state The state of the compiler.
+ * @return TRUE if the sequence is valid, FALSE otherwise.
+ */
+static boolean compileSymdiff(compiler *state) {
+    if (!compileIntersection(state)) {
+        return FALSE;
+    }
+
+    /* Compile every following intersection, and apply the operator after it. */
+    while (peekCharacter(state) == '^') {
+        state->position++;
+
+        if (!compileIntersection(state)) {
+            return FALSE;
+        }
+
+        addStep(state, SYMDIFF_STEP, EMPTY);
+    }
+
+    return TRUE;
+}
+
+/**
+ * Compiles a sequence of symmetric differences joined by | (union).
+ *
+ * @param state The state of the compiler.
+ * @return TRUE if the sequence is valid, FALSE otherwise.
+ */
+static boolean compileUnion(compiler *state) {
+    if (!compileSymdiff(state)) {
+        return FALSE;
+    }
+
+    /* Compile every following symmetric difference, and apply the operator after it. */
+    while (peekCharacter(state) == '|') {
+        state->position++;
+
+        if (!compileSymdiff(state)) {
+            return FALSE;
+        }
+
+        addStep(state, UNION_STEP, EMPTY);
+    }
+
+    return TRUE;
+}
+
+/**
+ * Compiles the given text into an expression.
+ * The text does not have to be null-terminated, and must outlive the expression (the names point into it).
+ * If the text is not a valid expression, sets the error of the expression.
+ * Exits the program if the memory allocation fails.
+ *
+ * @param formula The expression to fill.
+ * @param text The text of the expression.
+ * @param length The number of characters in the text.
+ * @return TRUE if the text is a valid expression, FALSE otherwise.
+ */
+boolean compileExpression(expression *formula, const char text[], size_t length) {
+    compiler state; /* The state of the compiler. */
+
+    clearExpression(formula);
+    state.text = text;
+    state.length = length;
+    state.position = FIRST_INDEX;
+    state.nesting = STARTING_VALUE;
+    state.stackSize = STARTING_VALUE;
+    state.formula = formula;
+
+    if (!compileUnion(&state)) {
+        return FALSE;
+    }
+
+    /* Check if there is anything left after the expression (e.g. an unmatched closing parenthesis). */
+    if (peekCharacter(&state) != '\0') {
+        return rejectExpression(&state, "Unexpected character in the expression.");
+    }
+
+    return TRUE;
+}
+
+/**
+ * Adds a set to the end of an expression which applies a single operation to all of its sets, in their order.
+ * The first set is only pushed, and every following set is combined with the result so far.
+ * Assumes the set name is valid.
+ * Exits the program if the memory allocation fails.
+ *
+ * @param formula The expression to add the set to.
+ * @param name The first character of the set's name.
+ * @param length The number of characters in the name.
+ * @param type The kind of the operation (e.g. UNION_STEP).
+ */
+void appendOperand(expression *formula, const char name[], size_t length, steptype type) {
+    compiler state; /* The state of the compiler (only the stack is tracked). */
+
+    /* Between the sets, only the result so far is on the stack. */
+    state.stackSize = formula->stepCount == EMPTY ? STARTING_VALUE : NEXT_INDEX_DIFFERENCE;
+    state.formula = formula;
+    addStep(&state, OPERAND_STEP, addName(formula, name, length));
+
+    if (state.stackSize > NEXT_INDEX_DIFFERENCE) {
+        addStep(&state, type, EMPTY);
+    }
+}
+
+/**
+ * Checks if the expression only intersects its sets (with no other operation and no complement).
+ * The result of such an expression can only have members in chunks where every set has members.
+ *
+ * @param formula The expression to check.
+ * @return TRUE if the expression is an intersection of its sets, FALSE otherwise.
+ */
+static boolean isConjunction(const expression *formula) {
+    size_t step; /* Current index in the steps. */
+
+    /* Check every operator in the expression. */
+    for (step = FIRST_INDEX; step < formula->stepCount; step++) {
+        if (formula->steps[step].type != OPERAND_STEP && formula->steps[step].type != INTERSECT_STEP) {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+/**
+ * Finds the first chunk (starting from the given one) which every set of the expression has a container in.
+ * Moves the cursor of every set to its first container in or after that chunk.
+ *
+ * @param formula The expression whose sets to check.
+ * @param cursors The index of the next container of every set.
+ * @param key The key of the first chunk to check, which receives the key of the chunk found.
+ * @return TRUE if such a chunk has been found, FALSE if one of the sets has no containers left.
+ */
+static boolean findCommonChunk(const expression *formula, size_t cursors[], unsigned long *key) {
+    boolean isAligned; /* Does every set have a container in the current chunk? */
+    size_t index;      /* Current index in the sets. */
+    const set *input;  /* The current set. */
+
+    isAligned = FALSE;
+
+    /* Move the chunk forward until every set has a container in it. */
+    while (!isAligned) {
+        isAligned = TRUE;
+
+        for (index = FIRST_INDEX; index < formula->nameCount; index++) {
+            input = formula->inputs[index];
+
+            /* Skip the containers before the chunk. */
+            while (cursors[index] < input->count && input->containers[cursors[index]].key < *key) {
+                cursors[index]++;
+            }
+
+            /* Once a set has no containers left, the rest of the result is empty. */
+            if (cursors[index] == input->count) {
+                return FALSE;
+            }
+
+            if (input->containers[cursors[index]].key > *key) {
+                *key = input->containers[cursors[index]].key;
+                isAligned = FALSE;
+            }
+        }
+    }
+
+    return TRUE;
+}
+
+/**
+ * Checks if every section in the block is empty.
+ *
+ * @param block The block to check.
+ * @return TRUE if the block is empty, FALSE otherwise.
+ */
+static boolean isBlockEmpty(const setsection block[]) {
+    size_t index;      /* Current index in the block. */
+    setsection merged; /* The bits of every section in the block. */
+
+    merged = EMPTY;
+
+    for (index = FIRST_INDEX; index < BLOCK_SECTIONS; index++) {
+        merged |= block[index];
+    }
+
+    return merged == EMPTY;
+}
+
+/**
+ * Applies the expression to a single block of sections of every input.
+ *
+ * @param formula The expression to apply.
+ * @param chunks The sections of every input in the current chunk.
+ * @param offset The index of the block's first section in the chunk.
+ * @param stack The stack of operands (a block for each operand).
+ * @param output The sections to store the result in (a whole chunk).
+ * @param isIntersection Does the expression only intersect its sets? If so, stops once the result is empty.
+ */
+static void applyToBlock(const expression *formula, const setsection *const chunks[], size_t offset, setsection stack[], setsection output[], boolean isIntersection) {
+    size_t step;         /* Current index in the steps. */
+    size_t index;        /* Current index in the block. */
+    setsection *top;     /* The block on the top of the stack. */
+    setsection *below;   /* The block right below the top of the stack. */
+    const setsection *input; /* The block of the current input. */
+
+    top = stack - BLOCK_SECTIONS;
+
+    /* Apply every step to the whole block. */
+    for (step = FIRST_INDEX; step < formula->stepCount; step++) {
+        below = top - BLOCK_SECTIONS;
+
+        switch (formula->steps[step].type) {
+            case OPERAND_STEP:
+                top += BLOCK_SECTIONS;
+                input = chunks[formula->steps[step].operand] + offset;
+
+                for (index = FIRST_INDEX; index < BLOCK_SECTIONS; index++) {
+                    top[index] = input[index];
+                }
+
+                break;
+            case COMPLEMENT_STEP:
+                for (index = FIRST_INDEX; index < BLOCK_SECTIONS; index++) {
+                    top[index] = ~top[index];
+                }
+
+                break;
+            case UNION_STEP:
+                for (index = FIRST_INDEX; index < BLOCK_SECTIONS; index++) {
+                    below[index] |= top[index];
+                }
+
+                top = below;
+                break;
+            case INTERSECT_STEP:
+                for (index = FIRST_INDEX; index < BLOCK_SECTIONS; index++) {
+                    below[index] &= top[index];
+                }
+
+                top = below;
+
+                /* The result so far is on the bottom of the stack, and intersecting it with more sets keeps it empty. */
+                if (isIntersection && top == stack && isBlockEmpty(top)) {
+                    memset(output + offset, EMPTY, BLOCK_SECTIONS * sizeof(setsection));
+                    return;
+                }
+
+                break;
+            case SUB_STEP:
+                for (index = FIRST_INDEX; index < BLOCK_SECTIONS; index++) {
+                    below[index] &= ~top[index];
+                }
+
+                top = below;
+                break;
+            default:
+                for (index = FIRST_INDEX; index < BLOCK_SECTIONS; index++) {
+                    below[index] ^= top[index];
+                }
+
+                top = below;
+                break;
+        }
+    }
+
+    /* The result is the only operand left on the stack. */
+    memcpy(output + offset, stack, BLOCK_SECTIONS * sizeof(setsection));
+}
+
+/**
+ * Clears the bits of every value after the given one in the chunk.
+ * Used to keep complements inside the universe.
+ *
+ * @param sections The sections of the chunk.
+ * @param last The last value to keep.
+ */
+static void clearAfter(setsection sections[], unsigned long last) {
+    size_t index; /* Current index in the chunk. */
+
+    index = last / SECTION_BITS;
+    sections[index] &= ~(setsection)EMPTY >> (SECTION_BITS - NEXT_INDEX_DIFFERENCE - last % SECTION_BITS);
+
+    /* Clear every section after the last value's section. */
+    for (index++; index < BITMAP_SECTIONS; index++) {
+        sections[index] = EMPTY;
+    }
+}
+
+/**
+ * Evaluates the expression in a single pass over the chunks whose keys are in the given range, and stores the result in the given set.
+ * Every chunk of the result is computed a cache line at a time, reading each input once and writing the output once.
+ * Assumes the inputs of the expression have been filled, and have no containers outside of the range (so a range can be evaluated on its own).
+ * The result is built separately, so the given set may also be one of the inputs.
+ *
+ * @param formula The expression to evaluate.
+ * @param firstKey The key of the first chunk in the range.
+ * @param endKey The key of the last chunk in the range (chunks after the universe are left out).
+ * @param result The set to store the result in.
+ * @return TRUE if the expression has been evaluated, FALSE if the memory allocation failed.
+ */
+boolean evaluateChunks(const expression *formula, unsigned long firstKey, unsigned long endKey, set *result) {
+    set output;                /* The result of the expression. */
+    size_t *cursors;           /* The index of the next container of every input. */
+    const setsection **chunks; /* The sections of every input in the current chunk. */
+    setsection *scratch;       /* The sections of inputs whose containers are not bitmaps. */
+    setsection *stack;         /* The stack of operands (a block for each operand). */
+    setsection probe[BLOCK_SECTIONS]; /* The result of the expression on empty inputs. */
+    boolean isComplemented;    /* Does the expression have members even where all the inputs are empty? */
+    boolean isIntersection;    /* Does the expression only intersect its inputs? */
+    unsigned long key;         /* The key of the current chunk. */
+    unsigned long lastKey;     /* The key of the last chunk in the universe. */
+    boolean isFound;           /* Has a chunk with an input been found? */
+    size_t index;              /* Current index in the inputs. */
+    size_t offset;             /* Current index in the chunk. */
+    const container *current;  /* The current container of the current input. */
+    container chunk;           /* The current chunk of the result. */
+    boolean isEvaluated;       /* Has the expression been evaluated successfully? */
+
+    cursors = malloc(formula->nameCount * sizeof(size_t));
+    chunks = malloc(formula->nameCount * sizeof(const setsection *));
+    scratch = malloc(formula->nameCount * BITMAP_BYTES);
+    stack = malloc(formula->depth * BLOCK_SECTIONS * sizeof(setsection));
+    isEvaluated = cursors != NULL && chunks != NULL && scratch != NULL && stack != NULL && createSet(&output);
+
+    if (!isEvaluated) {
+        free(cursors);
+        free((void *)chunks);
+        free(scratch);
+        free(stack);
+        return FALSE;
+    }
+
+    /* Apply the expression to empty inputs, to find if it has members outside of its inputs' chunks (e.g. ~SETA). */
+    for (index = FIRST_INDEX; index < formula->nameCount; index++) {
+        cursors[index] = FIRST_INDEX;
+        chunks[index] = emptyChunk;
+    }
+
+    applyToBlock(formula, chunks, FIRST_INDEX, stack, probe, FALSE);
+    isComplemented = probe[FIRST_INDEX] != EMPTY;
+    isIntersection = isConjunction(formula);
+    lastKey = (unsigned long)getLargestMember() >> CONTAINER_BITS;
+    endKey = endKey < lastKey ? endKey : lastKey;
+    key = firstKey;
+
+    while (isEvaluated) {
+        /* Find the next chunk: every chunk in the universe for complements, the next chunk with every input for intersections, otherwise the next chunk with an input. */
+        if (isIntersection) {
+            if (!findCommonChunk(formula, cursors, &key)) {
+                break;
+            }
+        } else if (!isComplemented) {
+            isFound = FALSE;
+
+            for (index = FIRST_INDEX; index < formula->nameCount; index++) {
+                if (cursors[index] < formula->inputs[index]->count && (!isFound || formula->inputs[index]->containers[cursors[index]].key < key)) {
+                    key = formula->inputs[index]->containers[cursors[index]].key;
+                    isFound = TRUE;
+                }
+            }
+
+            if (!isFound) {
+                break;
+            }
+        } else if (key > endKey) {
+            break;
+        }
+
+        /* Find the sections of every input in the chunk (bitmaps are used in place). */
+        for (index = FIRST_INDEX; index < formula->nameCount; index++) {
+            current = cursors[index] < formula->inputs[index]->count ? &formula->inputs[index]->containers[cursors[index]] : NULL;
+
+            if (current == NULL || current->key != key) {
+                chunks[index] = emptyChunk;
+                continue;
+            }
+
+            if (current->type == BITMAP_CONTAINER) {
+                chunks[index] = current->data.sections;
+            } else {
+                fillBitmap(current, scratch + index * BITMAP_SECTIONS);
+                chunks[index] = scratch + index * BITMAP_SECTIONS;
+            }
+
+            cursors[index]++;
+        }
+
+        if (!createBitmapContainer(&chunk, (uint32_t)key)) {
+            isEvaluated = FALSE;
+            break;
+        }
+
+        /* Apply the whole expression to every block of the chunk. */
+        for (offset = FIRST_INDEX; offset < BITMAP_SECTIONS; offset += BLOCK_SECTIONS) {
+            applyToBlock(formula, chunks, offset, stack, chunk.data.sections, isIntersection);
+        }
+
+        /* Keep complements inside the universe. */
+        if (key == lastKey) {
+            clearAfter(chunk.data.sections, (unsigned long)getLargestMember() & LOW_BITS_MASK);
+        }
+
+        /* Add the chunk to the result (in the kind which fits it best), unless it is empty. */
+        chunk.cardinality = countBitmap(chunk.data.sections);
+
+        if (!optimizeContainer(&chunk)) {
+            freeContainer(&chunk);
+            isEvaluated = FALSE;
+        } else if (chunk.cardinality != EMPTY && !appendContainer(&output, &chunk)) {
+            freeContainer(&chunk);
+            isEvaluated = FALSE;
+        }
+
+        key++;
+    }
+
+    free(cursors);
+    free((void *)chunks);
+    free(scratch);
+    free(stack);
+
+    if (!isEvaluated) {
+        freeSet(&output);
+        return FALSE;
+    }
+
+    /* Replace the previous members of the set with the result. */
+    freeSet(result);
+    *result = output;
+    return TRUE;
+}
+
+/**
+ * Evaluates the expression in a single pass over the chunks of the universe, and stores the result in the given set.
+ * Every chunk of the result is computed a cache line at a time, reading each input once and writing the output once.
+ * Assumes the inputs of the expression have been filled.
+ * The result is built separately, so the given set may also be one of the inputs.
+ *
+ * @param formula The expression to evaluate.
+ * @param result The set to store the result in.
+ * @return TRUE if the expression has been evaluated, FALSE if the memory allocation failed.
+ */
+boolean evaluateExpression(const expression *formula, set *result) {
+    return evaluateChunks(formula, FIRST_INDEX, (unsigned long)getLargestMember() >> CONTAINER_BITS, result);
+}
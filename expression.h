@@ -0,0 +1,139 @@
+/*
+ * expression.h
+ * Includes the prototypes of all the functions in expression.c.
+ * Also, includes the type of a compiled set expression.
+ *
+ * A set expression combines sets with the operators below (from the lowest precedence to the highest):
+ * - | (union)
+ * - ^ (symmetric difference)
+ * - & (intersection) and - (difference)
+ * - ~ (complement, relative to the universe)
+ * Parentheses can be used to group parts of the expression.
+ *
+ * Name: Ariel Keren
+ * Course: C Lab, 20465
+ * Semester: 2024B
+ * Date: 18/10/2026
+ */
+
+#ifndef EXPRESSION_H
+#define EXPRESSION_H
+
+#include <stddef.h>
+
+#include "globals.h"
+#include "registry.h"
+#include "set.h"
+
+/* The kinds of steps in a compiled expression. */
+typedef enum { OPERAND_STEP,
+               UNION_STEP,
+               INTERSECT_STEP,
+               SUB_STEP,
+               SYMDIFF_STEP,
+               COMPLEMENT_STEP } steptype;
+
+/* A single step of a compiled expression, which works on a stack of operands. */
+typedef struct {
+    steptype type;  /* The kind of the step. */
+    size_t operand; /* The index of the set to push (operand steps only). */
+} expressionstep;
+
+/* An expression, compiled into postfix order (every operator comes after its operands). */
+typedef struct {
+    expressionstep *steps; /* The steps of the expression, in the order they are applied. */
+    size_t stepCount;      /* The number of steps in the expression. */
+    size_t stepCapacity;   /* The number of steps the expression has memory for. */
+    setname *names;        /* The names of the distinct sets in the expression (pointing into the line). */
+    const set **inputs;    /* The sets the names refer to (filled before the expression is evaluated). */
+    size_t nameCount;      /* The number of distinct sets in the expression. */
+    size_t nameCapacity;   /* The number of names (and sets) the expression has memory for. */
+    size_t depth;          /* The largest number of operands on the stack while the expression is evaluated. */
+    const char *error;     /* The reason the expression is invalid. */
+} expression;
+
+/**
+ * Prepares an empty expression, which can be reused for every line.
+ * Does not allocate any memory.
+ *
+ * @param formula The expression to prepare.
+ */
+void initializeExpression(expression *formula);
+
+/**
+ * Removes every step and set name from the expression (keeping its memory).
+ *
+ * @param formula The expression to clear.
+ */
+void clearExpression(expression *formula);
+
+/**
+ * Frees the memory used by the expression.
+ *
+ * @param formula The expression to free.
+ */
+void freeExpression(expression *formula);
+
+/**
+ * Copies the steps of the expression to another expression, which is allocated separately.
+ * The names of the sets are not copied (they point into the line), but the number of sets is.
+ *
+ * @param copy The expression to fill (its previous steps are freed).
+ * @param formula The expression to copy.
+ * @return TRUE if the expression has been copied, FALSE if the memory allocation failed.
+ */
+boolean copyExpression(expression *copy, const expression *formula);
+
+/**
+ * Compiles the given text into an expression.
+ * The text does not have to be null-terminated, and must outlive the expression (the names point into it).
+ * If the text is not a valid expression, sets the error of the expression.
+ * Exits the program if the memory allocation fails.
+ *
+ * @param formula The expression to fill.
+ * @param text The text of the expression.
+ * @param length The number of characters in the text.
+ * @return TRUE if the text is a valid expression, FALSE otherwise.
+ */
+boolean compileExpression(expression *formula, const char text[], size_t length);
+
+/**
+ * Adds a set to the end of an expression which applies a single operation to all of its sets, in their order.
+ * The first set is only pushed, and every following set is combined with the result so far.
+ * Assumes the set name is valid.
+ * Exits the program if the memory allocation fails.
+ *
+ * @param formula The expression to add the set to.
+ * @param name The first character of the set's name.
+ * @param length The number of characters in the name.
+ * @param type The kind of the operation (e.g. UNION_STEP).
+ */
+void appendOperand(expression *formula, const char name[], size_t length, steptype type);
+
+/**
+ * Evaluates the expression in a single pass over the chunks of the universe, and stores the result in the given set.
+ * Every chunk of the result is computed a cache line at a time, reading each input once and writing the output once.
+ * Assumes the inputs of the expression have been filled.
+ * The result is built separately, so the given set may also be one of the inputs.
+ *
+ * @param formula The expression to evaluate.
+ * @param result The set to store the result in.
+ * @return TRUE if the expression has been evaluated, FALSE if the memory allocation failed.
+ */
+boolean evaluateExpression(const expression *formula, set *result);
+
+/**
+ * Evaluates the expression in a single pass over the chunks whose keys are in the given range, and stores the result in the given set.
+ * Every chunk of the result is computed a cache line at a time, reading each input once and writing the output once.
+ * Assumes the inputs of the expression have been filled, and have no containers outside of the range (so a range can be evaluated on its own).
+ * The result is built separately, so the given set may also be one of the inputs.
+ *
+ * @param formula The expression to evaluate.
+ * @param firstKey The key of the first chunk in the range.
+ * @param endKey The key of the last chunk in the range (chunks after the universe are left out).
+ * @param result The set to store the result in.
+ * @return TRUE if the expression has been evaluated, FALSE if the memory allocation failed.
+ */
+boolean evaluateChunks(const expression *formula, unsigned long firstKey, unsigned long endKey, set *result);
+
+#endif
@@ -11,8 +11,16 @@
 #include "globals.h"
 
 /* Every possible operation name. */
-const char *OPERATIONS[] = {"read_set", "print_set", "union_set", "intersect_set", "sub_set", "symdiff_set", "stop"};
-/* Every possible set name. */
+const char *OPERATIONS[] = {"read_set", "print_set", "union_set", "intersect_set", "sub_set", "symdiff_set", "drop_set", "count_set", "min_set", "max_set", "eval", "cache_stats", "save_state", "load_state", "load_set", "dump_set", "stats", "stop"};
+/* The names of the sets which are defined when the program starts. */
 const char *SETS[] = {"SETA", "SETB", "SETC", "SETD", "SETE", "SETF"};
+/* The names of the formats a set can be kept in as a binary file. */
+const char *FORMATS[] = {"bitmap", "array"};
+/* The names of the stages a command goes through (which the benchmark measures separately). */
+const char *STAGES[] = {"parser", "validator", "kernels", "printer"};
+/* The names of the phases every command is timed in. */
+const char *PHASES[] = {"read", "validate", "execute", "kernel"};
+/* The ways a script run with --jobs can end. */
+const char *ENDINGS[] = {"stopped", "missing stop", "out of memory", "failed to open", "failed to load the state"};
 /* All the characters which should be ignored in the input line. */
 const char SEPARATORS[] = ", \t\n";
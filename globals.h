@@ -16,36 +16,183 @@
 #define ERROR 1   /* An error occurred. */
 
 /* Set information. */
-#define SET_SIZE 16        /* Number of sections in a set (128 / 8 = 16). */
-#define SMALLEST_MEMBER 0  /* The smallest potential member in the set. */
-#define LARGEST_MEMBER 127 /* The largest potential member in the set. */
+#define SMALLEST_MEMBER 0                     /* The smallest potential member in the set. */
+#define LARGEST_MEMBER 127                    /* The largest potential member in the set (by default). */
+#define DEFAULT_UNIVERSE (LARGEST_MEMBER + 1) /* The number of potential members in every set (by default). */
+#define MINIMUM_UNIVERSE 1                    /* The smallest number of potential members in every set. */
+#define MAXIMUM_UNIVERSE 2147483647L          /* The largest number of potential members in every set. */
+#define CACHE_LINE_SIZE 64                    /* The alignment of the sections of every bitmap container, in bytes. */
+#define SEARCH_DIVISOR 2                      /* Splits the range of indices in a binary search in half. */
+#define INITIAL_CONTAINERS 4                  /* The number of containers a set has memory for when it is created. */
+
+/* Set registry information. */
+#define INITIAL_REGISTRY_CAPACITY 16   /* The number of slots in the table of sets when it is created (a power of 2). */
+#define MAXIMUM_LOAD_NUMERATOR 3       /* The table of sets is rebuilt once more than 3/4 of its slots are used. */
+#define MAXIMUM_LOAD_DENOMINATOR 4     /* See above. */
+#define HASH_OFFSET_BASIS 2166136261UL /* The starting value of the hash of a set name (FNV-1a). */
+#define HASH_PRIME 16777619UL          /* The prime the hash of a set name is multiplied by after each character (FNV-1a). */
 
 /* Input line reading information. */
-#define INITIAL_SIZE 256 /* The size of the starting string to read the input line into. */
+#define INITIAL_SIZE 256         /* The size of the starting string to read the input line into. */
+#define LINE_PREFIX_LENGTH 65536 /* The number of characters of a line which are read before deciding whether it can be streamed. */
+#define READ_BLOCK_SIZE 1048576  /* The number of characters read from the input at a time (more than LINE_PREFIX_LENGTH). */
+
+/* Command line and batch mode information. */
+#define BATCH_FLAG "--batch"         /* The command line flag which runs a script file without any interaction. */
+#define UNIVERSE_FLAG "--universe"   /* The command line flag which sets the number of potential members in every set. */
+#define STATS_FLAG "--stats"         /* The command line flag which writes the statistics to a file on exit (and on SIGUSR1). */
+#define STATE_FLAG "--state"         /* The command line flag which loads a saved state before the first command. */
+#define JOBS_FLAG "--jobs"           /* The command line flag which runs the scripts after it at once, on the given number of worker threads. */
+#define SERVE_FLAG "--serve"         /* The command line flag which runs the server mode on a Unix domain socket. */
+#define WORKERS_FLAG "--workers"     /* The command line flag which sets the number of worker threads in server mode. */
+#define PIPELINE_FLAG "--pipeline"   /* The command line flag which reads, validates and executes the lines of a script on separate threads. */
+#define THREADS_FLAG "--threads"     /* The command line flag which sets the number of threads which compute the sets of a single stream of commands. */
+#define FLAG_PREFIX "--"             /* The start of every command line flag (so an argument which starts with it is never a script path). */
+#define FLAG_PREFIX_LENGTH 2         /* The number of characters in the start of every command line flag. */
+#define STANDARD_INPUT_PATH "-"      /* The script path which means the standard input. */
+#define OUTPUT_BUFFER_SIZE (1 << 20) /* The size of the output buffer in batch mode (1 MiB). */
+#define FIRST_ARGUMENT 1             /* The index of the first command line argument (after the program's name). */
+#define NO_LINE_NUMBER 0             /* Marks that no line number should be reported with errors. */
+#define ERROR_TEXT_LENGTH 512        /* The longest error message written to the error sink (longer messages are cut). */
+#define ERROR_PREFIX_LENGTH 40       /* Room for "Error (line <number>): ", the newline and the null terminator around an error message. */
+#define NUMBER_TEXT_LENGTH 24        /* Room for a number printed on its own line (along with its sign, the newline and the null terminator). */
+#define STATISTICS_LINE_LENGTH 1024  /* Room for a single line of the statistics (or of cache_stats). */
+
+/* Server mode information. */
+#define DEFAULT_WORKERS 0              /* Marks that the server runs a worker thread for every processor. */
+#define MINIMUM_WORKERS 1              /* The smallest number of worker threads. */
+#define MAXIMUM_WORKERS 256            /* The largest number of worker threads. */
+#define FALLBACK_WORKERS 4             /* The number of worker threads when the number of processors is unknown. */
+#define SERVER_BACKLOG 128             /* The number of connections which can wait to be accepted. */
+#define INITIAL_SESSIONS 16            /* The number of sessions the server has memory for when it starts. */
+#define SESSION_READ_SIZE 65536        /* The number of characters the server makes room for before receiving from a client. */
+#define SESSION_INPUT_LIMIT (1 << 20)  /* A session with complete lines waiting stops being read once it has this many characters (1 MiB). */
+#define SESSION_OUTPUT_LIMIT (1 << 20) /* A session stops running commands while this much of its output has not been sent (1 MiB). */
+#define SESSION_TURN_LINES 256         /* The number of lines a worker runs for a session before moving on to the next one. */
+#define LISTENER_DESCRIPTOR 0          /* The index of the listening socket among the descriptors the server waits for. */
+#define WAKEUP_DESCRIPTOR 1            /* The index of the wakeup pipe among the descriptors the server waits for. */
+#define FIRST_SESSION_DESCRIPTOR 2     /* The index of the first session among the descriptors the server waits for. */
+#define PIPE_ENDS 2                    /* The number of descriptors of a pipe. */
+#define READ_END 0                     /* The index of the end of a pipe which is read from. */
+#define WRITE_END 1                    /* The index of the end of a pipe which is written to. */
+#define WAKEUP_TEXT ""                 /* Written to the wakeup pipe (its null character). */
+#define WAKEUP_DRAIN_SIZE 64           /* The number of characters read from the wakeup pipe at a time. */
+#define INVALID_DESCRIPTOR (-1)        /* A descriptor which is not open (also ignored when waiting). */
+#define NO_JOBS 0                      /* Marks that the program does not run several scripts at once. */
+#define JOB_ERROR_SEPARATOR ": "       /* Between the path of a script run with --jobs and each of its errors. */
+#define NO_TIMEOUT (-1)                /* Waits until something happens, however long it takes. */
+
+/* Helper threads information. */
+#define DEFAULT_THREADS 1       /* The number of threads which compute the sets by default (only the thread which runs the commands). */
+#define MAXIMUM_THREADS 256     /* The largest number of threads which compute the sets. */
+#define DISPATCHED_PER_THREAD 4 /* The number of versions which may wait for the helper threads, for every thread (more are waited for). */
+#define PIECE_CONTAINERS 64     /* The smallest number of containers of the largest input in every piece of a kernel which is split. */
+
+/* Pipeline information. */
+#define PIPELINE_SLOTS 64               /* The number of lines which can be between reading and executing at once (a power of 2). */
+#define PIPELINE_OWNERS 2               /* The number of threads which free the pipeline (the reader and the executor, whichever ends last). */
+#define PIPELINE_SPINS 64               /* The number of times a stage yields the processor while its ring is empty, before it starts to nap. */
+#define PIPELINE_NAP_NANOSECONDS 50000L /* The time a stage naps while its ring is still empty. */
 
 /* Tokens and commas information. */
 #define SINGLE_TOKEN 1             /* A single token in an input line (the number of commas should be 0). */
 #define TOKENS_COMMAS_DIFFERENCE 2 /* The difference between the number of tokens and the number of commas in an input line. */
+#define SINGLE_CHARACTER 1         /* The length of a token consisting of a single character (e.g. a comma). */
+#define INITIAL_TOKENS 16          /* The number of tokens a token list has memory for when it first grows. */
+#define GROWTH_FACTOR 2            /* The factor to multiply the capacity of a growing array by. */
 
 /* Command information. */
-#define NUMBER_OF_OPERATIONS 7   /* The number of operations possible. */
-#define NUMBER_OF_SETS 6         /* The number of sets possible. */
+#define NUMBER_OF_OPERATIONS 18  /* The number of operations possible. */
+#define NUMBER_OF_SETS 6         /* The number of sets which are defined when the program starts. */
 #define SET_OPERATION_OPERANDS 3 /* The number of operands needed for a set operation (e.g. union_set). */
 
 /* Information for printing a set. */
-#define NUMBERS_PER_LINE 16 /* The maximum number of set members in a single line when the set is printed. */
+#define NUMBERS_PER_LINE 16          /* The maximum number of set members in a single line when the set is printed. */
+#define MAXIMUM_DIGITS 10            /* The largest number of digits in a set member. */
+#define MAXIMUM_MEMBER_TEXT 13       /* The longest text a single member adds to a printed set (10 digits, ", " and a newline). */
+#define DIGIT_PAIR_LENGTH 2          /* The number of digits in each entry of the digit table. */
+#define DIGIT_PAIRS 100              /* The number of entries in the digit table (00 to 99). */
+#define INITIAL_PRINT_BUFFER 4096    /* The size of the output buffer for printing sets when it is first allocated. */
+#define PRINT_BUFFER_LIMIT (1 << 20) /* The output buffer for printing sets stops growing at this size (1 MiB), and is written out when full. */
+
+/* Expression information. */
+#define INITIAL_STEPS 16         /* The number of steps (and set names) an expression has memory for when it first grows. */
+#define MAXIMUM_NESTING 256      /* The largest number of parentheses and complements an operand can be nested in. */
+#define BINARY_OPERATION_STEPS 3 /* The number of steps in an expression which combines two sets (the two sets and the operation). */
+
+/* Command graph information. */
+#define INITIAL_VERSION_BUCKETS 64  /* The number of buckets in the table of reusable versions when it is created (a power of 2). */
+#define INITIAL_VERSION_LIST 16     /* The number of entries the lists of the command graph have memory for when they first grow. */
+#define STORED_SET (-1)             /* The operation of a version which is the set in the registry itself. */
+#define MAXIMUM_GRAPH_VERSIONS 4096 /* The number of versions in the command graph after which every set is committed (so a long script which observes nothing stays in bounded memory). */
+#define RESULT_CACHE_SIZE 32        /* The number of computed results which are kept after nothing refers to them anymore. */
+#define EMPTY_GENERATION 0          /* The generation of a set which has just been defined (with no members). */
+
+/* Saved state information. */
+#define SNAPSHOT_MAGIC "MYSETSTA"        /* The first bytes of every saved state file. */
+#define SNAPSHOT_MAGIC_LENGTH 8          /* The number of bytes in the magic of a saved state file. */
+#define SNAPSHOT_VERSION 1               /* The version of the saved state format (changed whenever the format changes). */
+#define SNAPSHOT_BYTE_ORDER 0x01020304UL /* Written in the byte order of the machine, so a state saved with another byte order is rejected. */
+#define SNAPSHOT_HEADER_SIZE 64          /* The size of the header of a saved state, in bytes (the records after it start at a cache line). */
+#define SNAPSHOT_ALIGNMENT 8             /* Every record and array of members in a saved state starts at a multiple of this offset. */
+#define SNAPSHOT_BUFFER_SIZE (1 << 20)   /* The size of the buffer a saved state is written through (1 MiB). */
+#define TEMPORARY_SUFFIX ".tmp"          /* Added to the path of a saved state while it is being written. */
+
+/* Binary set file information. */
+#define NUMBER_OF_FORMATS 2      /* The number of formats a set can be kept in as a binary file. */
+#define MEMBER_BYTES 4           /* The size of every member in the array format (a little-endian 32-bit integer). */
+#define DUMP_BUFFER_MEMBERS 4096 /* The number of members which are buffered before they are written in the array format. */
 
 /* Information for bitwise operations.  */
 #define SINGLE_BIT 1    /* A bit to use for a mask. */
 #define BITS_PER_BYTE 8 /* The number of bits in a byte. */
+#define BYTE_MASK 0xFF  /* The mask of the lowest byte of a number. */
 
-/* Information for copying a string. */
-#define NULL_BYTE 1 /* The extra byte to add when copying a string because of the null character. */
+/* Information for parsing an integer. */
+#define DECIMAL_BASE 10                /* The base of the integers in the input. */
+#define INTEGER_SATURATION 2147483647L /* Larger magnitudes are all treated as this one, since they are out of range anyway. */
+#define ERROR_MESSAGE_LENGTH 128       /* The maximal length of an error message which includes numbers. */
+#define VECTOR_CHARACTERS 16           /* The number of characters checked at once when counting digits (with SSE2). */
 
 /* Information about indices. */
-#define INVALID_INDEX (-1)      /* An invalid index (when searching for a set or an operation). */
+#define INVALID_INDEX (-1)      /* An invalid index (when searching for an operation). */
 #define NEXT_INDEX_DIFFERENCE 1 /* The difference between the current index and the next one. */
 
+/* Benchmark information. */
+#define COMMANDS_FLAG "--commands"           /* The command line flag which sets the number of commands in a generated workload. */
+#define MEMBERS_FLAG "--members"             /* The command line flag which sets the average number of members in a generated read_set. */
+#define READ_WEIGHT_FLAG "--reads"           /* The command line flag which sets the weight of read_set commands in a generated workload. */
+#define OPERATION_WEIGHT_FLAG "--operations" /* The command line flag which sets the weight of set operations in a generated workload. */
+#define PRINT_WEIGHT_FLAG "--prints"         /* The command line flag which sets the weight of print_set commands in a generated workload. */
+#define SEED_FLAG "--seed"                   /* The command line flag which sets the seed of a generated workload. */
+#define DEFAULT_COMMANDS 10000               /* The number of commands in a generated workload (by default). */
+#define DEFAULT_MEMBERS 1000                 /* The average number of members in a generated read_set (by default). */
+#define DEFAULT_READ_WEIGHT 4                /* The weight of read_set commands in a generated workload (by default). */
+#define DEFAULT_OPERATION_WEIGHT 4           /* The weight of set operations in a generated workload (by default). */
+#define DEFAULT_PRINT_WEIGHT 1               /* The weight of print_set commands in a generated workload (by default). */
+#define DEFAULT_SEED 1                       /* The seed of a generated workload (by default). */
+#define MAXIMUM_WORKLOAD_OPTION 1000000000L  /* The largest value of a numeric workload option. */
+#define RANDOM_MASK 0xFFFFFFFFUL             /* Keeps the state of the random numbers of a workload to 32 bits (the same on every machine). */
+#define RANDOM_FIRST_SHIFT 13                /* The shifts of the random numbers of a workload (xorshift, 32 bits). */
+#define RANDOM_SECOND_SHIFT 17               /* See above. */
+#define RANDOM_THIRD_SHIFT 5                 /* See above. */
+#define MAXIMUM_EXTRA_OPERANDS 2             /* The largest number of operands a generated set operation has beyond the required 2. */
+#define NUMBER_OF_KINDS 3                    /* The number of kinds of commands in a generated workload (read_set, set operations and print_set). */
+#define NUMBER_OF_STAGES 4                   /* The number of stages a command goes through which are measured separately. */
+#define MEDIAN_PERCENTILE 50                 /* The percentile of the typical latency of a stage. */
+#define TAIL_PERCENTILE 99                   /* The percentile of the slow latencies of a stage. */
+#define WHOLE_PERCENT 100                    /* The percentile of the slowest latency. */
+#define NANOSECONDS_PER_SECOND 1000000000L   /* The number of nanoseconds in a second. */
+#define MICROSECONDS_PER_SECOND 1e6          /* The number of microseconds in a second. */
+#define MILLISECONDS_PER_SECOND 1e3          /* The number of milliseconds in a second. */
+#define BYTES_PER_MEBIBYTE 1048576.0         /* The number of bytes in a mebibyte. */
+
+/* Statistics information. */
+#define NUMBER_OF_PHASES 4                     /* The number of phases every command is timed in. */
+#define HISTOGRAM_BUCKETS 32                   /* The number of buckets in the histogram of a phase (powers of 2 nanoseconds). */
+#define INVALID_OPERATION NUMBER_OF_OPERATIONS /* The statistics of lines which are not valid commands are kept after those of every operation. */
+#define INVALID_OPERATION_NAME "invalid"       /* The name lines which are not valid commands are written under. */
+
 /* read_set. */
 #define TERMINATOR (-1) /* The number which should terminate a read_set command. */
 
@@ -55,13 +202,15 @@
 #define NO_REMAINDER 0   /* Used to check if a number is divisible by some number. */
 
 extern const char *OPERATIONS[]; /* All possible operation names (e.g. "print_set"). */
-extern const char *SETS[];       /* All possible set names (e.g. "SETA"). */
+extern const char *SETS[];       /* The names of the sets which are defined when the program starts (e.g. "SETA"). */
+extern const char *FORMATS[];    /* The names of the formats a set can be kept in as a binary file (e.g. "bitmap"). */
+extern const char *STAGES[];     /* The names of the stages a command goes through (e.g. "parser"). */
+extern const char *PHASES[];     /* The names of the phases every command is timed in (e.g. "read"). */
+extern const char *ENDINGS[];    /* The ways a script run with --jobs can end (e.g. "stopped"). */
 extern const char SEPARATORS[];  /* All the characters which should be ignored in the input line. */
 
 /* The type to loop over all sections in a set with. */
 typedef unsigned char setindex;
-/* The type consisting of all possible values of read_set's number operands. */
-typedef signed char operand;
 
 /* Boolean type. */
 typedef enum { FALSE,
@@ -74,9 +223,54 @@ enum { READ_SET,
        INTERSECT_SET,
        SUB_SET,
        SYMDIFF_SET,
+       DROP_SET,
+       COUNT_SET,
+       MIN_SET,
+       MAX_SET,
+       EVAL_SET,
+       CACHE_STATS,
+       SAVE_STATE,
+       LOAD_STATE,
+       LOAD_SET,
+       DUMP_SET,
+       STATISTICS,
        STOP };
 
-/* An index for each possible set. */
+/* An index for each format a set can be kept in as a binary file. */
+enum { BITMAP_FORMAT,
+       ARRAY_FORMAT };
+
+/* An index for each stage a command goes through, which the benchmark measures separately. */
+enum { PARSER_STAGE,
+       VALIDATOR_STAGE,
+       KERNEL_STAGE,
+       PRINTER_STAGE };
+
+/* An index for each phase every command is timed in (see stats.h). */
+enum { READ_PHASE,
+       VALIDATE_PHASE,
+       EXECUTE_PHASE,
+       KERNEL_PHASE };
+
+/* An index for each way a script run with --jobs can end. */
+enum { STOPPED_ENDING,
+       MISSING_STOP_ENDING,
+       OUT_OF_MEMORY_ENDING,
+       OPEN_FAILED_ENDING,
+       STATE_FAILED_ENDING };
+
+/* An index for each state a task of the helper threads can be in. */
+enum { IDLE_TASK,
+       QUEUED_TASK,
+       RUNNING_TASK,
+       DONE_TASK };
+
+/* An index for each kind of command in a generated workload. */
+enum { READ_KIND,
+       OPERATION_KIND,
+       PRINT_KIND };
+
+/* An index for each set which is defined when the program starts. */
 enum { SETA_INDEX,
        SETB_INDEX,
        SETC_INDEX,
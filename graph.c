@@ -0,0 +1,1032 @@
+/*
+ * graph.c
+ * Includes functions for adding versions of sets to the command graph, and for computing them once they are observed.
+ * Every version counts its references (the versions which read it and the sets it is the latest version of),
+ * so a version which is replaced before anything reads it is freed without ever being computed.
+ * Versions computed by set operations and eval are kept in a hash table, so a repeated command reuses them.
+ * Once nothing refers to a computed version, it stays in the table (as a cached result) until newer results push it out.
+ * With helper threads, every version is handed to them once it is added, and it is settled (its kernel timed, its sources released) on the thread which runs the commands,
+ * either once it is done or once a command needs it. The kernel of a version with large sets is split into pieces by the keys of their containers.
+ * Every calculator has its own graph, which the public functions reach through the calculator in use.
+ *
+ * Name: Ariel Keren
+ * Course: C Lab, 20465
+ * Semester: 2024B
+ * Date: 18/10/2026
+ */
+
+#include "graph.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "calculator.h"
+#include "container.h"
+#include "expression.h"
+#include "globals.h"
+#include "registry.h"
+#include "set.h"
+#include "setUtils.h"
+#include "stats.h"
+#include "tasks.h"
+
+/* A piece of a kernel which is split by the keys of the containers of its inputs (see splitKernel). */
+typedef struct {
+    task work;              /* Computes the piece on a helper thread. */
+    int operation;          /* The operation which computes the version the piece belongs to. */
+    expression formula;     /* The steps of the version, reading only the containers of the piece (shares the steps of the version). */
+    unsigned long firstKey; /* The key of the first chunk of the piece. */
+    unsigned long endKey;   /* The key of the last chunk of the piece. */
+    set result;             /* The members of the version in the piece. */
+    boolean isApplied;      /* Has the piece been computed? */
+} kernelpiece;
+
+/**
+ * Gives up on the current command because a memory allocation failed (see failMemory).
+ */
+static void failAllocation() {
+    failMemory("Failed to allocate memory for the sets.");
+}
+
+/**
+ * Grows the given list of pointers (geometrically) if it is full.
+ * Exits the program if the memory allocation fails.
+ *
+ * @param list The list to grow.
+ * @param count The number of pointers in the list.
+ * @param capacity The number of pointers the list has memory for, which receives the new capacity.
+ * @param size The size of each pointer in the list.
+ * @return The grown list.
+ */
+static void *reserveEntry(void *list, size_t count, size_t *capacity, size_t size) {
+    size_t grown; /* The number of pointers the grown list has memory for. */
+
+    if (count < *capacity) {
+        return list;
+    }
+
+    grown = *capacity == EMPTY ? INITIAL_VERSION_LIST : *capacity * GROWTH_FACTOR;
+    list = realloc(list, grown * size);
+
+    if (list == NULL) {
+        failAllocation();
+    }
+
+    *capacity = grown;
+    return list;
+}
+
+/**
+ * Adds a version to the top of the worklist.
+ * Exits the program if the memory allocation fails.
+ *
+ * @param graph The command graph.
+ * @param version The version to add.
+ */
+static void pushWork(commandgraph *graph, setversion *version) {
+    graph->worklist = reserveEntry(graph->worklist, graph->worklistCount, &graph->worklistCapacity, sizeof(setversion *));
+    graph->worklist[graph->worklistCount++] = version;
+}
+
+static void computeTask(void *data);
+
+/**
+ * Allocates a version with no sources and no references.
+ * Exits the program if the memory allocation fails.
+ *
+ * @param graph The command graph.
+ * @param operation The operation which computes the version.
+ * @return The allocated version.
+ */
+static setversion *createVersion(commandgraph *graph, int operation) {
+    setversion *created; /* The allocated version. */
+
+    created = malloc(sizeof(setversion));
+
+    if (created == NULL || !createSet(&created->result)) {
+        failAllocation();
+    }
+
+    graph->versionCount++;
+    created->id = graph->nextVersionId++;
+    created->operation = operation;
+    initializeExpression(&created->formula);
+    created->sources = NULL;
+    created->sourceIds = NULL;
+    created->sourceCount = STARTING_VALUE;
+    created->members = NULL;
+    created->references = STARTING_VALUE;
+    created->hash = HASH_OFFSET_BASIS;
+    created->next = NULL;
+    created->isListed = FALSE;
+    initializeTask(&created->work, computeTask, created);
+    created->isDispatched = FALSE;
+    created->newer = created->older = NULL;
+    return created;
+}
+
+/**
+ * Removes the version from the table of reusable versions.
+ *
+ * @param graph The command graph.
+ * @param version The version to remove.
+ */
+static void removeFromTable(commandgraph *graph, setversion *version) {
+    setversion **link; /* The link which points to the current version in the bucket. */
+
+    link = &graph->versionTable[version->hash & (graph->tableCapacity - NEXT_INDEX_DIFFERENCE)];
+
+    /* Find the link which points to the version. */
+    while (*link != version) {
+        link = &(*link)->next;
+    }
+
+    *link = version->next;
+    version->isListed = FALSE;
+    graph->tableCount--;
+}
+
+static void discardVersion(commandgraph *graph, setversion *version);
+static void settleVersion(commandgraph *graph, setversion *version, boolean isNeeded);
+
+/**
+ * Removes the version from the cached results.
+ *
+ * @param graph The command graph.
+ * @param version The version to remove.
+ */
+static void uncacheVersion(commandgraph *graph, const setversion *version) {
+    size_t index; /* The index of the version in the cached results. */
+
+    index = FIRST_INDEX;
+
+    while (graph->cachedResults[index] != version) {
+        index++;
+    }
+
+    /* Move the newer results back, to keep them in order. */
+    memmove(graph->cachedResults + index, graph->cachedResults + index + NEXT_INDEX_DIFFERENCE, (--graph->cachedCount - index) * sizeof(setversion *));
+}
+
+/**
+ * Keeps a version which nothing refers to anymore as a cached result, if it has been computed and can be reused.
+ * Frees the oldest cached result if there is no room for the version.
+ *
+ * @param graph The command graph.
+ * @param version The version to keep.
+ * @return TRUE if the version has been kept, FALSE if it should be freed.
+ */
+static boolean cacheVersion(commandgraph *graph, setversion *version) {
+    setversion *oldest; /* The oldest cached result. */
+
+    /* Nothing needs the version anymore, so it is only kept if a helper thread has already started computing it. */
+    settleVersion(graph, version, FALSE);
+
+    if (!version->isListed || version->members == NULL) {
+        return FALSE;
+    }
+
+    /* Push the oldest result out. */
+    if (graph->cachedCount == RESULT_CACHE_SIZE) {
+        oldest = graph->cachedResults[FIRST_INDEX];
+        uncacheVersion(graph, oldest);
+        discardVersion(graph, oldest);
+    }
+
+    graph->cachedResults[graph->cachedCount++] = version;
+    return TRUE;
+}
+
+/**
+ * Frees the versions from the given one (which has no references left) down to the sources which are no longer referenced.
+ *
+ * @param graph The command graph.
+ * @param version The version to free.
+ */
+static void discardVersion(commandgraph *graph, setversion *version) {
+    size_t bottom;       /* The number of versions in the worklist which belong to the caller. */
+    setversion *current; /* The version being freed. */
+    setversion *source;  /* The current source of the version. */
+
+    bottom = graph->worklistCount;
+    pushWork(graph, version);
+
+    /* Free the versions one by one, adding every source which loses its last reference. */
+    while (graph->worklistCount > bottom) {
+        current = graph->worklist[--graph->worklistCount];
+
+        if (current->isListed) {
+            removeFromTable(graph, current);
+        }
+
+        while (current->sourceCount > EMPTY) {
+            source = current->sources[--current->sourceCount];
+
+            if (--source->references == EMPTY && !cacheVersion(graph, source)) {
+                pushWork(graph, source);
+            }
+        }
+
+        freeExpression(&current->formula);
+        free(current->sources);
+        free(current->sourceIds);
+        freeSet(&current->result);
+        free(current);
+        graph->versionCount--;
+    }
+}
+
+/**
+ * Removes a reference to the version.
+ * If it has no references left, it is either kept as a cached result or freed.
+ *
+ * @param graph The command graph.
+ * @param version The version to release.
+ */
+static void releaseVersion(commandgraph *graph, setversion *version) {
+    if (--version->references == EMPTY && !cacheVersion(graph, version)) {
+        discardVersion(graph, version);
+    }
+}
+
+/**
+ * Makes the version the latest version of the given set, releasing its previous latest version.
+ * If nothing has read the previous version, it is freed without ever being computed.
+ * Exits the program if the memory allocation fails.
+ *
+ * @param graph The command graph.
+ * @param entry The set to write.
+ * @param version The new latest version of the set.
+ */
+static void writeVersion(commandgraph *graph, namedset *entry, setversion *version) {
+    /* Add the reference first, in case the version is already the latest one (when it is reused). */
+    version->references++;
+
+    if (entry->latest == NULL) {
+        graph->trackedSets = reserveEntry(graph->trackedSets, graph->trackedCount, &graph->trackedCapacity, sizeof(namedset *));
+        graph->trackedSets[graph->trackedCount++] = entry;
+    } else {
+        releaseVersion(graph, entry->latest);
+    }
+
+    entry->latest = version;
+}
+
+/**
+ * Returns the latest version of the given set, adding a reference to it.
+ * If the members of the set are up to date, the set itself becomes its latest version.
+ * Exits the program if the memory allocation fails.
+ *
+ * @param graph The command graph.
+ * @param entry The set to read.
+ * @return The latest version of the set.
+ */
+static setversion *readVersion(commandgraph *graph, namedset *entry) {
+    setversion *stored; /* The version which is the set itself. */
+
+    if (entry->latest == NULL) {
+        stored = createVersion(graph, STORED_SET);
+        stored->id = entry->generation;
+        stored->members = &entry->members;
+        writeVersion(graph, entry, stored);
+    }
+
+    entry->latest->references++;
+    return entry->latest;
+}
+
+/**
+ * Mixes a value into the hash of the version (FNV-1a, a whole value at a time).
+ *
+ * @param version The version to hash.
+ * @param value The value to mix in.
+ */
+static void mixHash(setversion *version, unsigned long value) {
+    version->hash = (version->hash ^ value) * HASH_PRIME;
+}
+
+/**
+ * Checks if two reusable versions apply the same steps to the same versions of the same sets.
+ *
+ * @param first The first version to compare.
+ * @param second The second version to compare.
+ * @return TRUE if the versions have the same members, FALSE otherwise.
+ */
+static boolean isSameVersion(const setversion *first, const setversion *second) {
+    size_t index; /* Current index in the steps and the sources. */
+
+    if (first->hash != second->hash || first->operation != second->operation || first->formula.stepCount != second->formula.stepCount || first->formula.nameCount != second->formula.nameCount) {
+        return FALSE;
+    }
+
+    /* Compare every step. */
+    for (index = FIRST_INDEX; index < first->formula.stepCount; index++) {
+        if (first->formula.steps[index].type != second->formula.steps[index].type || first->formula.steps[index].operand != second->formula.steps[index].operand) {
+            return FALSE;
+        }
+    }
+
+    /* Compare the versions of the sources. */
+    for (index = FIRST_INDEX; index < first->formula.nameCount; index++) {
+        if (first->sourceIds[index] != second->sourceIds[index]) {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+/**
+ * Doubles the number of buckets in the table of reusable versions (or creates the table).
+ * Exits the program if the memory allocation fails.
+ *
+ * @param graph The command graph.
+ */
+static void growTable(commandgraph *graph) {
+    size_t capacity;       /* The number of buckets in the grown table. */
+    setversion **buckets;  /* The buckets of the grown table. */
+    size_t index;          /* Current index in the previous table. */
+    setversion *current;   /* The current version in the bucket. */
+    setversion *following; /* The version after the current one in the bucket. */
+
+    capacity = graph->tableCapacity == EMPTY ? INITIAL_VERSION_BUCKETS : graph->tableCapacity * GROWTH_FACTOR;
+    buckets = calloc(capacity, sizeof(setversion *));
+
+    if (buckets == NULL) {
+        failAllocation();
+    }
+
+    /* Move every version to its bucket in the grown table. */
+    for (index = FIRST_INDEX; index < graph->tableCapacity; index++) {
+        for (current = graph->versionTable[index]; current != NULL; current = following) {
+            following = current->next;
+            current->next = buckets[current->hash & (capacity - NEXT_INDEX_DIFFERENCE)];
+            buckets[current->hash & (capacity - NEXT_INDEX_DIFFERENCE)] = current;
+        }
+    }
+
+    free(graph->versionTable);
+    graph->versionTable = buckets;
+    graph->tableCapacity = capacity;
+}
+
+/**
+ * Returns a version in the table which is the same as the given one, or adds the given version to the table.
+ * Exits the program if the memory allocation fails.
+ *
+ * @param graph The command graph.
+ * @param version The version to find.
+ * @return The version which is already in the table, or NULL if the given version has been added.
+ */
+static setversion *reuseVersion(commandgraph *graph, setversion *version) {
+    setversion *current; /* The current version in the bucket. */
+    size_t bucket;       /* The index of the version's bucket. */
+
+    /* Grow the table once it has as many versions as buckets. */
+    if (graph->tableCount >= graph->tableCapacity) {
+        growTable(graph);
+    }
+
+    bucket = version->hash & (graph->tableCapacity - NEXT_INDEX_DIFFERENCE);
+
+    /* Check every version in the bucket. */
+    for (current = graph->versionTable[bucket]; current != NULL; current = current->next) {
+        if (isSameVersion(current, version)) {
+            return current;
+        }
+    }
+
+    version->next = graph->versionTable[bucket];
+    graph->versionTable[bucket] = version;
+    version->isListed = TRUE;
+    graph->tableCount++;
+    return NULL;
+}
+
+/**
+ * Applies an operation to the inputs of the given steps, over the chunks whose keys are in the given range.
+ * Assumes the inputs have no containers outside of the range.
+ *
+ * @param operation The operation which computes the version (a set operation or EVAL_SET).
+ * @param formula The steps, with their inputs filled.
+ * @param firstKey The key of the first chunk in the range.
+ * @param endKey The key of the last chunk in the range.
+ * @param result The set to store the result in.
+ * @return TRUE if the operation has been applied, FALSE if the memory allocation failed.
+ */
+static boolean runKernel(int operation, const expression *formula, unsigned long firstKey, unsigned long endKey, set *result) {
+    const set *first;  /* The first set to apply a binary operation to. */
+    const set *second; /* The second set to apply a binary operation to. */
+
+    /* Two sets are combined container by container, while more sets (and eval) are combined in a single pass over all of them. */
+    if (operation == EVAL_SET || formula->stepCount > BINARY_OPERATION_STEPS) {
+        return evaluateChunks(formula, firstKey, endKey, result);
+    }
+
+    first = formula->inputs[formula->steps[FIRST_INDEX].operand];
+    second = formula->inputs[formula->steps[SECOND_INDEX].operand];
+
+    /* Determine what operation to execute. */
+    switch (operation) {
+        case UNION_SET:
+            return union_set(first, second, result);
+        case INTERSECT_SET:
+            return intersect_set(first, second, result);
+        case SUB_SET:
+            return sub_set(first, second, result);
+        default:
+            return symdiff_set(first, second, result);
+    }
+}
+
+/**
+ * Computes a piece of a kernel which is split (runs as a task).
+ *
+ * @param data The piece to compute.
+ */
+static void computePiece(void *data) {
+    kernelpiece *piece; /* The piece to compute. */
+
+    piece = data;
+    piece->isApplied = runKernel(piece->operation, &piece->formula, piece->firstKey, piece->endKey, &piece->result);
+}
+
+/**
+ * Computes the members of a version by splitting its kernel into pieces, each with the same share of the containers of its largest input.
+ * The first piece is computed on the current thread, while the helper threads take the others,
+ * and then the containers of every piece (whose keys follow the keys of the previous piece) are moved into the result.
+ *
+ * @param version The version to compute (with the inputs of its steps filled).
+ * @param largest The input with the most containers.
+ * @param pieceCount The number of pieces (at most the number of containers of the largest input).
+ * @return TRUE if the version has been computed, FALSE if the memory allocation failed.
+ */
+static boolean splitKernel(setversion *version, const set *largest, size_t pieceCount) {
+    const expression *formula; /* The steps which compute the version. */
+    kernelpiece *pieces;       /* The pieces of the kernel. */
+    set *views;                /* The containers of every input in every piece (pointing into the inputs). */
+    const set **inputs;        /* The inputs of the steps of every piece. */
+    kernelpiece *current;      /* The current piece. */
+    size_t piece;              /* Current index in the pieces. */
+    size_t index;              /* Current index in the inputs. */
+    size_t start;              /* The index of the first container of the current input in the current piece. */
+    container *containers;     /* The containers of the result. */
+    size_t total;              /* The number of containers in the result so far. */
+    boolean isApplied;         /* Has every piece been computed? */
+
+    formula = &version->formula;
+    pieces = malloc(pieceCount * sizeof(kernelpiece));
+    views = malloc(pieceCount * formula->nameCount * sizeof(set));
+    inputs = malloc(pieceCount * formula->nameCount * sizeof(const set *));
+
+    if (pieces == NULL || views == NULL || inputs == NULL) {
+        free(pieces);
+        free(views);
+        free((void *)inputs);
+        return FALSE;
+    }
+
+    /* Every piece starts at the key of its share of the largest input (the first one starts at the beginning of the universe). */
+    for (piece = FIRST_INDEX; piece < pieceCount; piece++) {
+        current = &pieces[piece];
+        initializeTask(&current->work, computePiece, current);
+        current->operation = version->operation;
+        current->formula = *formula;
+        current->formula.inputs = inputs + piece * formula->nameCount;
+        current->firstKey = piece == FIRST_INDEX ? FIRST_INDEX : largest->containers[piece * largest->count / pieceCount].key;
+        current->result.containers = NULL;
+        current->result.count = current->result.capacity = STARTING_VALUE;
+        current->isApplied = FALSE;
+    }
+
+    /* Every piece ends before the next one (the last one ends at the end of the universe), and reads the containers of every input in its range. */
+    for (piece = FIRST_INDEX; piece < pieceCount; piece++) {
+        current = &pieces[piece];
+        current->endKey = piece + NEXT_INDEX_DIFFERENCE == pieceCount ? (unsigned long)getLargestMember() >> CONTAINER_BITS : pieces[piece + NEXT_INDEX_DIFFERENCE].firstKey - NEXT_INDEX_DIFFERENCE;
+
+        for (index = FIRST_INDEX; index < formula->nameCount; index++) {
+            start = findContainerIndex(formula->inputs[index]->containers, FIRST_INDEX, formula->inputs[index]->count, current->firstKey);
+            views[piece * formula->nameCount + index].containers = formula->inputs[index]->containers + start;
+            views[piece * formula->nameCount + index].count = findContainerIndex(formula->inputs[index]->containers, start, formula->inputs[index]->count, current->endKey + NEXT_INDEX_DIFFERENCE) - start;
+            views[piece * formula->nameCount + index].capacity = views[piece * formula->nameCount + index].count;
+            current->formula.inputs[index] = &views[piece * formula->nameCount + index];
+        }
+    }
+
+    for (piece = FIRST_INDEX + NEXT_INDEX_DIFFERENCE; piece < pieceCount; piece++) {
+        submitTask(&pieces[piece].work);
+    }
+
+    computePiece(&pieces[FIRST_INDEX]);
+    isApplied = pieces[FIRST_INDEX].isApplied;
+    total = pieces[FIRST_INDEX].result.count;
+
+    for (piece = FIRST_INDEX + NEXT_INDEX_DIFFERENCE; piece < pieceCount; piece++) {
+        waitTask(&pieces[piece].work);
+        isApplied = isApplied && pieces[piece].isApplied;
+        total += pieces[piece].result.count;
+    }
+
+    containers = isApplied ? malloc((total > EMPTY ? total : INITIAL_CONTAINERS) * sizeof(container)) : NULL;
+
+    /* Move the containers of every piece into the result, in order, or free them if a piece could not be computed. */
+    if (containers != NULL) {
+        freeSet(&version->result);
+        version->result.containers = containers;
+        version->result.capacity = total > EMPTY ? total : INITIAL_CONTAINERS;
+        total = STARTING_VALUE;
+
+        for (piece = FIRST_INDEX; piece < pieceCount; piece++) {
+            memcpy(containers + total, pieces[piece].result.containers, pieces[piece].result.count * sizeof(container));
+            total += pieces[piece].result.count;
+            free(pieces[piece].result.containers);
+        }
+
+        version->result.count = total;
+    } else {
+        for (piece = FIRST_INDEX; piece < pieceCount; piece++) {
+            freeSet(&pieces[piece].result);
+        }
+    }
+
+    free(pieces);
+    free(views);
+    free((void *)inputs);
+    return containers != NULL;
+}
+
+/**
+ * Computes the members of a version whose sources have all been computed, and times its kernel.
+ * Does not release the sources, and does not fail on a failed memory allocation (the members are left NULL),
+ * so it can run on a helper thread. With helper threads, the kernel is split if its largest input is large enough.
+ *
+ * @param version The version to compute.
+ */
+static void applyKernel(setversion *version) {
+    expression *formula; /* The steps which compute the version. */
+    const set *largest;  /* The input with the most containers. */
+    size_t index;        /* Current index in the sources. */
+    size_t pieceCount;   /* The number of pieces to split the kernel into. */
+    boolean isApplied;   /* Has the operation been applied? */
+
+    formula = &version->formula;
+    largest = NULL;
+
+    /* Read the members of every source. */
+    for (index = FIRST_INDEX; index < formula->nameCount; index++) {
+        formula->inputs[index] = version->sources[index]->members;
+
+        if (largest == NULL || formula->inputs[index]->count > largest->count) {
+            largest = formula->inputs[index];
+        }
+    }
+
+    /* Every thread gets a piece, as long as every piece has enough containers of the largest input. */
+    pieceCount = (size_t)countHelpers() + NEXT_INDEX_DIFFERENCE;
+
+    if (largest == NULL || largest->count / PIECE_CONTAINERS < pieceCount) {
+        pieceCount = largest == NULL ? NEXT_INDEX_DIFFERENCE : largest->count / PIECE_CONTAINERS;
+    }
+
+    startTimer(&version->timer);
+
+    if (pieceCount > NEXT_INDEX_DIFFERENCE) {
+        isApplied = splitKernel(version, largest, pieceCount);
+    } else {
+        isApplied = runKernel(version->operation, formula, FIRST_INDEX, (unsigned long)getLargestMember() >> CONTAINER_BITS, &version->result);
+    }
+
+    stopTimer(&version->timer);
+    version->members = isApplied ? &version->result : NULL;
+}
+
+/**
+ * Computes a version on a helper thread (runs as a task).
+ * Waits for every source which another task computes first (or computes it on this thread if no helper has started it yet).
+ * If a source could not be computed, the version is not computed either.
+ *
+ * @param data The version to compute.
+ */
+static void computeTask(void *data) {
+    setversion *version; /* The version to compute. */
+    size_t index;        /* Current index in the sources. */
+    boolean isReady;     /* Have all the sources been computed? */
+
+    version = data;
+    isReady = TRUE;
+
+    for (index = FIRST_INDEX; index < version->formula.nameCount; index++) {
+        waitTask(&version->sources[index]->work);
+
+        if (version->sources[index]->members == NULL) {
+            isReady = FALSE;
+        }
+    }
+
+    if (isReady) {
+        applyKernel(version);
+    }
+}
+
+/**
+ * Records the time the kernel of a computed version took, and releases its sources.
+ * Exits the program if the memory allocation has failed (unless nothing needs the version anymore).
+ *
+ * @param graph The command graph.
+ * @param version The version which has been computed.
+ * @param isNeeded Does anything need the members of the version?
+ */
+static void finishVersion(commandgraph *graph, setversion *version, boolean isNeeded) {
+    recordTimer(&version->timer, KERNEL_PHASE, version->operation);
+
+    if (version->members == NULL) {
+        if (isNeeded) {
+            failAllocation();
+        }
+
+        return;
+    }
+
+    /* The sources are no longer needed (their identifiers are kept, so the version can still be reused). */
+    while (version->sourceCount > EMPTY) {
+        releaseVersion(graph, version->sources[--version->sourceCount]);
+    }
+}
+
+/**
+ * Computes the members of a version whose sources have all been computed, and releases its sources.
+ * Exits the program if the memory allocation fails.
+ *
+ * @param graph The command graph.
+ * @param version The version to compute.
+ */
+static void applyVersion(commandgraph *graph, setversion *version) {
+    applyKernel(version);
+    finishVersion(graph, version, TRUE);
+}
+
+/**
+ * Hands the version to the helper threads, and settles the versions which are done (waiting for the oldest ones while too many are left).
+ * Exits the program if the memory allocation fails.
+ *
+ * @param graph The command graph.
+ * @param version The version to hand to the helper threads (its sources have been read).
+ */
+static void dispatchVersion(commandgraph *graph, setversion *version) {
+    size_t limit; /* The number of versions which may be left to the helper threads. */
+
+    version->isDispatched = TRUE;
+    version->older = graph->newestDispatched;
+    version->newer = NULL;
+
+    if (graph->newestDispatched == NULL) {
+        graph->oldestDispatched = version;
+    } else {
+        graph->newestDispatched->newer = version;
+    }
+
+    graph->newestDispatched = version;
+    graph->dispatchedCount++;
+    submitTask(&version->work);
+    limit = ((size_t)countHelpers() + NEXT_INDEX_DIFFERENCE) * DISPATCHED_PER_THREAD;
+
+    /* Settling releases the sources of the versions, so the memory held by the graph stays bounded. */
+    while (graph->oldestDispatched != NULL && (graph->dispatchedCount > limit || isTaskDone(&graph->oldestDispatched->work))) {
+        settleVersion(graph, graph->oldestDispatched, TRUE);
+    }
+}
+
+/**
+ * Takes back a version which has been handed to the helper threads (nothing happens if it has not been).
+ * If something needs the version, waits for it to be computed (or computes it on this thread), and then records its time and releases its sources.
+ * Otherwise, it is only computed if a helper thread has already started it.
+ * Exits the program if the memory allocation fails (unless nothing needs the version).
+ *
+ * @param graph The command graph.
+ * @param version The version to settle.
+ * @param isNeeded Does anything need the members of the version?
+ */
+static void settleVersion(commandgraph *graph, setversion *version, boolean isNeeded) {
+    if (!version->isDispatched) {
+        return;
+    }
+
+    version->isDispatched = FALSE;
+    graph->dispatchedCount--;
+
+    if (version->older == NULL) {
+        graph->oldestDispatched = version->newer;
+    } else {
+        version->older->newer = version->newer;
+    }
+
+    if (version->newer == NULL) {
+        graph->newestDispatched = version->older;
+    } else {
+        version->newer->older = version->older;
+    }
+
+    version->newer = version->older = NULL;
+
+    if (!isNeeded && cancelTask(&version->work)) {
+        return;
+    }
+
+    waitTask(&version->work);
+    finishVersion(graph, version, isNeeded);
+}
+
+/**
+ * Computes the version, along with every source it needs which has not been computed yet.
+ * Exits the program if the memory allocation fails.
+ *
+ * @param graph The command graph.
+ * @param version The version to compute.
+ */
+static void computeVersion(commandgraph *graph, setversion *version) {
+    size_t bottom;       /* The number of versions in the worklist which belong to the caller. */
+    setversion *current; /* The version on the top of the worklist. */
+    size_t index;        /* Current index in the sources. */
+    boolean isReady;     /* Have all the sources of the current version been computed? */
+
+    bottom = graph->worklistCount;
+    pushWork(graph, version);
+
+    /* Compute the sources of each version before the version itself. */
+    while (graph->worklistCount > bottom) {
+        current = graph->worklist[graph->worklistCount - NEXT_INDEX_DIFFERENCE];
+        settleVersion(graph, current, TRUE);
+        isReady = TRUE;
+
+        for (index = FIRST_INDEX; index < current->sourceCount && isReady; index++) {
+            settleVersion(graph, current->sources[index], TRUE);
+
+            if (current->sources[index]->members == NULL) {
+                pushWork(graph, current->sources[index]);
+                isReady = FALSE;
+            }
+        }
+
+        if (!isReady) {
+            continue;
+        }
+
+        /* The version may have been computed already (e.g. if it is observed again). */
+        if (current->members == NULL) {
+            applyVersion(graph, current);
+        }
+
+        graph->worklistCount--;
+    }
+}
+
+/**
+ * Fills the graph with no versions (its lists are allocated once they are first used).
+ *
+ * @param graph The graph to fill.
+ */
+void initializeGraph(commandgraph *graph) {
+    graph->versionTable = NULL;
+    graph->trackedSets = NULL;
+    graph->worklist = NULL;
+    graph->tableCapacity = graph->tableCount = graph->trackedCount = graph->trackedCapacity = graph->worklistCount = graph->worklistCapacity = EMPTY;
+    graph->cachedCount = EMPTY;
+    graph->cacheHits = graph->cacheMisses = STARTING_VALUE;
+    graph->nextVersionId = EMPTY_GENERATION + NEXT_INDEX_DIFFERENCE;
+    graph->oldestDispatched = graph->newestDispatched = NULL;
+    graph->dispatchedCount = graph->versionCount = EMPTY;
+}
+
+/**
+ * Adds a version of the target set, filled with the given members (read_set).
+ * The given members are swapped with an empty set.
+ * Defines the set if it is not defined yet.
+ * Exits the program if the memory allocation fails.
+ *
+ * @param sets The registry of every defined set.
+ * @param target The name of the set to fill.
+ * @param members The members to fill the set with.
+ */
+void recordMembers(setregistry *sets, const setname *target, set *members) {
+    commandgraph *graph; /* The command graph of the calculator in use. */
+    setversion *created; /* The version with the given members. */
+    namedset *entry;     /* The set to fill. */
+
+    graph = &getCalculator()->graph;
+
+    if ((entry = defineEntry(sets, target)) == NULL) {
+        failAllocation();
+    }
+
+    created = createVersion(graph, READ_SET);
+    read_set(&created->result, members);
+    created->members = &created->result;
+    writeVersion(graph, entry, created);
+}
+
+/**
+ * Adds a version of the target set, computed by applying the given operation (a set operation or EVAL_SET) to the sets of the expression.
+ * Reuses an existing version if it applies the same steps to the same versions of the same sets.
+ * Defines the target set if it is not defined yet.
+ * Exits the program if the memory allocation fails.
+ *
+ * @param sets The registry of every defined set.
+ * @param operation The operation which computes the version.
+ * @param formula The steps which compute the version, along with the names of the sets they read.
+ * @param target The name of the set to store the result in.
+ * @return TRUE if the version has been added, FALSE if one of the sets of the expression is not defined.
+ */
+boolean recordExpression(setregistry *sets, int operation, const expression *formula, const setname *target) {
+    commandgraph *graph; /* The command graph of the calculator in use. */
+    setversion *created; /* The version computed by the expression. */
+    setversion *reused;  /* An existing version which is the same as the created one. */
+    namedset *entry;     /* The current set. */
+    size_t index;        /* Current index in the sets of the expression. */
+
+    graph = &getCalculator()->graph;
+    created = createVersion(graph, operation);
+    created->sources = malloc(formula->nameCount * sizeof(setversion *));
+    created->sourceIds = malloc(formula->nameCount * sizeof(unsigned long));
+
+    if (created->sources == NULL || created->sourceIds == NULL || !copyExpression(&created->formula, formula)) {
+        failAllocation();
+    }
+
+    mixHash(created, (unsigned long)operation);
+
+    /* Hash every step. */
+    for (index = FIRST_INDEX; index < formula->stepCount; index++) {
+        mixHash(created, (unsigned long)formula->steps[index].type);
+        mixHash(created, (unsigned long)formula->steps[index].operand);
+    }
+
+    /* Read the latest version of every set in the expression. */
+    for (index = FIRST_INDEX; index < formula->nameCount; index++) {
+        if ((entry = findEntry(sets, &formula->names[index])) == NULL) {
+            discardVersion(graph, created);
+            return FALSE;
+        }
+
+        created->sources[index] = readVersion(graph, entry);
+        created->sourceIds[index] = created->sources[index]->id;
+        created->sourceCount++;
+        mixHash(created, created->sourceIds[index]);
+    }
+
+    if ((entry = defineEntry(sets, target)) == NULL) {
+        failAllocation();
+    }
+
+    /* Reuse the same version if it is already in the graph (or among the cached results). */
+    if ((reused = reuseVersion(graph, created)) != NULL) {
+        discardVersion(graph, created);
+        created = reused;
+        graph->cacheHits++;
+
+        if (created->references == EMPTY) {
+            uncacheVersion(graph, created);
+        }
+    } else {
+        graph->cacheMisses++;
+    }
+
+    writeVersion(graph, entry, created);
+
+    /* With helper threads, a new version is computed right away, alongside the commands which follow it. */
+    if (reused == NULL && countHelpers() > EMPTY) {
+        dispatchVersion(graph, created);
+    }
+
+    /* Every pending version holds the versions it reads, so a long chain of commands which nothing observes is committed before it grows too large. */
+    if (graph->versionCount > MAXIMUM_GRAPH_VERSIONS) {
+        commitVersions();
+    }
+
+    return TRUE;
+}
+
+/**
+ * Returns the current members of the set with the given name, computing its latest version if needed.
+ * Exits the program if the memory allocation fails.
+ *
+ * @param sets The registry of every defined set.
+ * @param name The name of the set.
+ * @return The members of the set, or NULL if the set is not defined.
+ */
+const set *observeSet(const setregistry *sets, const setname *name) {
+    namedset *entry; /* The set to observe. */
+
+    if ((entry = findEntry(sets, name)) == NULL) {
+        return NULL;
+    }
+
+    /* Check if the members of the set are up to date. */
+    if (entry->latest == NULL) {
+        return &entry->members;
+    }
+
+    computeVersion(&getCalculator()->graph, entry->latest);
+    return entry->latest->members;
+}
+
+/**
+ * Returns the number of commands which have reused an existing result, and the number of commands which have not.
+ *
+ * @param hits Receives the number of commands which have reused an existing result.
+ * @param misses Receives the number of commands which have not.
+ */
+void getCacheStatistics(unsigned long *hits, unsigned long *misses) {
+    commandgraph *graph; /* The command graph of the calculator in use. */
+
+    graph = &getCalculator()->graph;
+    *hits = graph->cacheHits;
+    *misses = graph->cacheMisses;
+}
+
+/**
+ * Computes the latest version of every set in the graph, and stores it in the set itself.
+ * Empties the graph.
+ * Exits the program if the memory allocation fails.
+ */
+void commitVersions() {
+    commandgraph *graph; /* The command graph of the calculator in use. */
+    size_t index;        /* Current index in the tracked sets. */
+    namedset *entry;     /* The current set. */
+    setversion *version; /* The latest version of the current set. */
+
+    graph = &getCalculator()->graph;
+
+    /* Compute every latest version first, since computing may read the previous members of other sets. */
+    for (index = FIRST_INDEX; index < graph->trackedCount; index++) {
+        computeVersion(graph, graph->trackedSets[index]->latest);
+    }
+
+    /* No helper thread may still read the members of a set once they are replaced. */
+    while (graph->oldestDispatched != NULL) {
+        settleVersion(graph, graph->oldestDispatched, TRUE);
+    }
+
+    /* Store every latest version in its set. */
+    for (index = FIRST_INDEX; index < graph->trackedCount; index++) {
+        entry = graph->trackedSets[index];
+        version = entry->latest;
+        entry->latest = NULL;
+
+        /* A version which is the latest version of several sets is copied to all of them but the last. */
+        if (version->operation != STORED_SET && version->references > NEXT_INDEX_DIFFERENCE) {
+            if (!copySet(version->members, &entry->members)) {
+                failAllocation();
+            }
+        } else if (version->operation != STORED_SET) {
+            /* The members are moved into the set, so the version cannot be reused anymore. */
+            if (version->isListed) {
+                removeFromTable(graph, version);
+            }
+
+            read_set(&entry->members, &version->result);
+        }
+
+        entry->generation = version->id;
+        releaseVersion(graph, version);
+    }
+
+    graph->trackedCount = STARTING_VALUE;
+}
+
+/**
+ * Frees every version in the graph without computing it, and the memory used by the graph.
+ * The sets in the registry keep their members from the last commit.
+ */
+void freeVersions() {
+    commandgraph *graph; /* The command graph of the calculator in use. */
+    size_t index;        /* Current index in the tracked sets. */
+    setversion *version; /* The latest version of the current set. */
+
+    graph = &getCalculator()->graph;
+
+    /* Take back every version from the helper threads (only the ones they have started are computed). */
+    while (graph->oldestDispatched != NULL) {
+        settleVersion(graph, graph->oldestDispatched, FALSE);
+    }
+
+    /* Release the latest version of every set (which frees every version in the graph). */
+    for (index = FIRST_INDEX; index < graph->trackedCount; index++) {
+        version = graph->trackedSets[index]->latest;
+        graph->trackedSets[index]->latest = NULL;
+        releaseVersion(graph, version);
+    }
+
+    /* Free the cached results. */
+    while (graph->cachedCount > EMPTY) {
+        discardVersion(graph, graph->cachedResults[--graph->cachedCount]);
+    }
+
+    free(graph->versionTable);
+    free(graph->trackedSets);
+    free(graph->worklist);
+    graph->versionTable = NULL;
+    graph->trackedSets = NULL;
+    graph->worklist = NULL;
+    graph->tableCapacity = graph->tableCount = graph->trackedCount = graph->trackedCapacity = graph->worklistCount = graph->worklistCapacity = EMPTY;
+}
@@ -0,0 +1,141 @@
+/*
+ * graph.h
+ * Includes the prototypes of all the functions in graph.c.
+ * Also, includes the type of a version of a set, and the type of the command graph (every calculator has its own, see calculator.h).
+ *
+ * Commands which write a set are not executed right away. Instead, each of them adds a version of its set to a graph,
+ * which refers to the versions of the sets it reads. A version is only computed once a command observes it (e.g. print_set).
+ * - A version which is replaced before anything reads it is never computed (a dead store).
+ * - A command which repeats an operation on the same versions of the same sets reuses the version which is already in the graph.
+ * - The last few computed results are kept after nothing refers to them, so a repeated command reuses them as long as its sets have not changed.
+ *   Every set carries the generation of its members, so the sets which have not changed since are recognized even after the graph is committed.
+ * - With helper threads (see tasks.h), every version is handed to them as soon as it is added, so commands which do not depend on each other are computed at once,
+ *   while a version which reads another one waits for it. Commands still observe their sets in order, so the output is the same.
+ *   The kernel of a version with large sets is also split by the keys of its containers, and every piece is computed as a separate task.
+ *
+ * Name: Ariel Keren
+ * Course: C Lab, 20465
+ * Semester: 2024B
+ * Date: 18/10/2026
+ */
+
+#ifndef GRAPH_H
+#define GRAPH_H
+
+#include <stddef.h>
+
+#include "expression.h"
+#include "globals.h"
+#include "registry.h"
+#include "set.h"
+#include "stats.h"
+#include "tasks.h"
+
+/* A version of a set, computed by a command which has not necessarily been executed yet. */
+typedef struct setversion {
+    unsigned long id;            /* Identifies the members of the version (a stored set shares the generation of its set). */
+    int operation;               /* The operation which computes the version (READ_SET, a set operation, EVAL_SET or STORED_SET). */
+    expression formula;          /* The steps which compute the version (set operations and eval only). */
+    struct setversion **sources; /* The version of every distinct set the steps read (released once the version is computed). */
+    unsigned long *sourceIds;    /* The identifier of the version of every distinct set the steps read (kept for reuse). */
+    size_t sourceCount;          /* The number of sources which are still held. */
+    set result;                  /* The members of the version, once computed (unless it is a stored set). */
+    const set *members;          /* The members of the version (NULL until the version is computed, set by the thread which computes it). */
+    size_t references;           /* The number of versions which read this one, plus the number of sets it is the latest version of. */
+    unsigned long hash;          /* The hash of the operation, the steps and the sources (for reuse). */
+    struct setversion *next;     /* The next version in the same bucket of the table of reusable versions. */
+    boolean isListed;            /* Is the version in the table of reusable versions? */
+    task work;                   /* Computes the version on a helper thread. */
+    boolean isDispatched;        /* Has the version been handed to the helper threads, without having been settled since? */
+    statstimer timer;            /* Times the kernel (recorded once the version is settled). */
+    struct setversion *newer;    /* The next version handed to the helper threads after this one, which has not been settled. */
+    struct setversion *older;    /* The previous version handed to the helper threads before this one, which has not been settled. */
+} setversion;
+
+/* The versions of the sets which have not been stored in the sets yet, along with the reusable versions and the cached results. */
+typedef struct {
+    setversion **versionTable;                    /* The reusable versions, by their hashes (each bucket is a linked list). */
+    size_t tableCapacity;                         /* The number of buckets in the table (always a power of 2). */
+    size_t tableCount;                            /* The number of versions in the table. */
+    namedset **trackedSets;                       /* Every set which has a latest version in the graph. */
+    size_t trackedCount;                          /* The number of sets which have a latest version in the graph. */
+    size_t trackedCapacity;                       /* The number of sets the list of tracked sets has memory for. */
+    setversion **worklist;                        /* The versions which are being computed or freed (so long chains of versions do not need deep recursion). */
+    size_t worklistCount;                         /* The number of versions in the worklist. */
+    size_t worklistCapacity;                      /* The number of versions the worklist has memory for. */
+    setversion *cachedResults[RESULT_CACHE_SIZE]; /* The computed versions which nothing refers to, from the oldest to the newest. */
+    size_t cachedCount;                           /* The number of cached results. */
+    unsigned long cacheHits;                      /* The number of commands which have reused an existing version. */
+    unsigned long cacheMisses;                    /* The number of commands which have not reused an existing version. */
+    unsigned long nextVersionId;                  /* The identifier of the next version (the generation of a newly defined set comes before it). */
+    setversion *oldestDispatched;                 /* The oldest version handed to the helper threads which has not been settled (NULL if none). */
+    setversion *newestDispatched;                 /* The newest version handed to the helper threads which has not been settled (NULL if none). */
+    size_t dispatchedCount;                       /* The number of versions handed to the helper threads which have not been settled. */
+    size_t versionCount;                          /* The number of versions which have not been freed (including the cached results). */
+} commandgraph;
+
+/**
+ * Fills the graph with no versions (its lists are allocated once they are first used).
+ *
+ * @param graph The graph to fill.
+ */
+void initializeGraph(commandgraph *graph);
+
+/**
+ * Adds a version of the target set, filled with the given members (read_set).
+ * The given members are swapped with an empty set.
+ * Defines the set if it is not defined yet.
+ * Exits the program if the memory allocation fails.
+ *
+ * @param sets The registry of every defined set.
+ * @param target The name of the set to fill.
+ * @param members The members to fill the set with.
+ */
+void recordMembers(setregistry *sets, const setname *target, set *members);
+
+/**
+ * Adds a version of the target set, computed by applying the given operation (a set operation or EVAL_SET) to the sets of the expression.
+ * Reuses an existing version if it applies the same steps to the same versions of the same sets.
+ * Defines the target set if it is not defined yet.
+ * Exits the program if the memory allocation fails.
+ *
+ * @param sets The registry of every defined set.
+ * @param operation The operation which computes the version.
+ * @param formula The steps which compute the version, along with the names of the sets they read.
+ * @param target The name of the set to store the result in.
+ * @return TRUE if the version has been added, FALSE if one of the sets of the expression is not defined.
+ */
+boolean recordExpression(setregistry *sets, int operation, const expression *formula, const setname *target);
+
+/**
+ * Returns the current members of the set with the given name, computing its latest version if needed.
+ * Exits the program if the memory allocation fails.
+ *
+ * @param sets The registry of every defined set.
+ * @param name The name of the set.
+ * @return The members of the set, or NULL if the set is not defined.
+ */
+const set *observeSet(const setregistry *sets, const setname *name);
+
+/**
+ * Returns the number of commands which have reused an existing result, and the number of commands which have not.
+ *
+ * @param hits Receives the number of commands which have reused an existing result.
+ * @param misses Receives the number of commands which have not.
+ */
+void getCacheStatistics(unsigned long *hits, unsigned long *misses);
+
+/**
+ * Computes the latest version of every set in the graph, and stores it in the set itself.
+ * Empties the graph.
+ * Exits the program if the memory allocation fails.
+ */
+void commitVersions();
+
+/**
+ * Frees every version in the graph without computing it (along with the cached results), and the memory used by the graph.
+ * The sets in the registry keep their members from the last commit.
+ */
+void freeVersions();
+
+#endif
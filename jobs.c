@@ -0,0 +1,448 @@
+/*
+ * jobs.c
+ * Includes the functions which run many independent scripts at once, each with its own calculator, on a pool of worker threads.
+ * Every worker has a deque of scripts (dealt out in turn, so every worker starts with the earliest ones).
+ * A worker runs the scripts of its own deque from the front, and once it is empty, steals from the back of the deque of another worker.
+ * The output of the earliest script which has not finished is written right away, and the output of every later script is kept until its turn,
+ * so the output is the same as running the scripts one after another.
+ *
+ * Name: Ariel Keren
+ * Course: C Lab, 20465
+ * Semester: 2024B
+ * Date: 18/10/2026
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include "jobs.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "calculator.h"
+#include "globals.h"
+#include "mysetUtils.h"
+#include "reader.h"
+
+/* Text a script has written before its turn to be written out. */
+typedef struct {
+    char *text;      /* The characters (NULL until the first ones are written). */
+    size_t length;   /* The number of characters. */
+    size_t capacity; /* The number of characters there is memory for. */
+} jobbuffer;
+
+/* A script, along with everything known about its run. */
+typedef struct {
+    const char *path;       /* The path of the script. */
+    pthread_mutex_t lock;   /* Guards the buffers and isHead. */
+    jobbuffer output;       /* The output of the script, until its turn to be written out. */
+    jobbuffer errors;       /* The errors of the script, until its turn to be written out. */
+    boolean isHead;         /* Is it the earliest script which has not finished (so its output is written right away)? */
+    boolean isDone;         /* Has the script finished (guarded by the lock of the pool)? */
+    unsigned long lines;    /* The number of lines which have run. */
+    unsigned long failures; /* The number of lines which have been invalid or could not be executed (and a missing stop command). */
+    double seconds;         /* The time the script has taken. */
+    int ending;             /* How the script has ended (e.g. STOPPED_ENDING). */
+} scriptjob;
+
+/* The scripts a worker has left, from the first one to the one before the end. */
+typedef struct {
+    pthread_mutex_t lock; /* Guards the deque. */
+    size_t *scripts;      /* The indices of the scripts, in the order they were dealt out. */
+    size_t first;         /* The index (in the scripts) of the first script which has not been taken. */
+    size_t end;           /* The index (in the scripts) after the last script which has not been taken. */
+} jobdeque;
+
+/* Everything the workers share. */
+typedef struct {
+    scriptjob *jobs;       /* Every script, in the order of the command line. */
+    size_t jobCount;       /* The number of scripts. */
+    jobdeque *deques;      /* The deque of every worker. */
+    long workerCount;      /* The number of workers. */
+    pthread_mutex_t lock;  /* Guards nextOutput and isDone of every script. */
+    size_t nextOutput;     /* The index of the earliest script whose output has not been written out in full. */
+    long universe;         /* The number of potential members in every set. */
+    const char *statePath; /* The saved state every script starts from (NULL for none). */
+} jobpool;
+
+/* A worker thread, along with the pool it takes the scripts from. */
+typedef struct {
+    pthread_t thread; /* The thread. */
+    jobpool *pool;    /* The pool. */
+    long index;       /* The index of the worker (and of its deque). */
+} jobworker;
+
+/**
+ * Returns the current time, from a clock which never goes back.
+ *
+ * @return The current time, in seconds.
+ */
+static double getTime() {
+    struct timespec now; /* The current time. */
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + (double)now.tv_nsec / NANOSECONDS_PER_SECOND;
+}
+
+/**
+ * Writes text of a script: right away if it is the script's turn, and otherwise into the given buffer.
+ * If the memory allocation fails, the text is written right away (out of order) instead of being lost.
+ *
+ * @param job The script.
+ * @param buffer The buffer to keep the text in until the script's turn.
+ * @param stream The stream to write the text to.
+ * @param text The text to write.
+ * @param length The number of characters to write.
+ */
+static void writeJobText(scriptjob *job, jobbuffer *buffer, FILE *stream, const char text[], size_t length) {
+    size_t capacity; /* The new capacity of the buffer. */
+    char *larger;    /* The buffer with more memory. */
+
+    /* Allocate more memory if necessary. */
+    if (!job->isHead && buffer->length + length > buffer->capacity) {
+        capacity = buffer->capacity == EMPTY ? INITIAL_PRINT_BUFFER : buffer->capacity;
+
+        while (buffer->length + length > capacity) {
+            capacity *= GROWTH_FACTOR;
+        }
+
+        if ((larger = realloc(buffer->text, capacity)) != NULL) {
+            buffer->text = larger;
+            buffer->capacity = capacity;
+        }
+    }
+
+    if (job->isHead || buffer->length + length > buffer->capacity) {
+        fwrite(text, sizeof(char), length, stream);
+    } else {
+        memcpy(buffer->text + buffer->length, text, length);
+        buffer->length += length;
+    }
+}
+
+/**
+ * Writes text the commands of a script have printed (the output sink of its calculator).
+ *
+ * @param data The script.
+ * @param text The text to write.
+ * @param length The number of characters to write.
+ */
+static void writeJobOutput(void *data, const char text[], size_t length) {
+    scriptjob *job; /* The script. */
+
+    job = data;
+    pthread_mutex_lock(&job->lock);
+    writeJobText(job, &job->output, stdout, text, length);
+    pthread_mutex_unlock(&job->lock);
+}
+
+/**
+ * Writes an error of a script, after the path of the script (the error sink of its calculator).
+ *
+ * @param data The script.
+ * @param text The error to write (a whole line).
+ * @param length The number of characters to write.
+ */
+static void writeJobErrors(void *data, const char text[], size_t length) {
+    scriptjob *job; /* The script. */
+
+    job = data;
+    pthread_mutex_lock(&job->lock);
+    writeJobText(job, &job->errors, stderr, job->path, strlen(job->path));
+    writeJobText(job, &job->errors, stderr, JOB_ERROR_SEPARATOR, strlen(JOB_ERROR_SEPARATOR));
+    writeJobText(job, &job->errors, stderr, text, length);
+    pthread_mutex_unlock(&job->lock);
+}
+
+/**
+ * Writes out (and frees) everything a script has kept until its turn.
+ * Assumes the lock of the script is held.
+ *
+ * @param job The script.
+ */
+static void writeKeptText(scriptjob *job) {
+    if (job->output.length != EMPTY) {
+        fwrite(job->output.text, sizeof(char), job->output.length, stdout);
+    }
+
+    if (job->errors.length != EMPTY) {
+        fwrite(job->errors.text, sizeof(char), job->errors.length, stderr);
+    }
+
+    free(job->output.text);
+    free(job->errors.text);
+    job->output.text = job->errors.text = NULL;
+    job->output.length = job->output.capacity = job->errors.length = job->errors.capacity = EMPTY;
+}
+
+/**
+ * Marks that a script has finished.
+ * Then, writes out every finished script whose turn has come, and lets the earliest script which has not finished write its output right away.
+ *
+ * @param pool The pool.
+ * @param job The script.
+ */
+static void finishJob(jobpool *pool, scriptjob *job) {
+    scriptjob *next; /* The earliest script whose output has not been written out in full. */
+
+    pthread_mutex_lock(&pool->lock);
+    job->isDone = TRUE;
+
+    for (; pool->nextOutput < pool->jobCount && pool->jobs[pool->nextOutput].isDone; pool->nextOutput++) {
+        next = &pool->jobs[pool->nextOutput];
+        pthread_mutex_lock(&next->lock);
+        writeKeptText(next);
+        pthread_mutex_unlock(&next->lock);
+    }
+
+    if (pool->nextOutput < pool->jobCount) {
+        next = &pool->jobs[pool->nextOutput];
+        pthread_mutex_lock(&next->lock);
+        writeKeptText(next);
+        next->isHead = TRUE;
+        pthread_mutex_unlock(&next->lock);
+    }
+
+    pthread_mutex_unlock(&pool->lock);
+}
+
+/**
+ * Runs a script in a calculator of its own, and counts its lines and errors.
+ * Exits the program if a memory allocation fails while reading the script.
+ *
+ * @param pool The pool.
+ * @param job The script.
+ */
+static void runScript(jobpool *pool, scriptjob *job) {
+    calculator *context; /* The calculator which runs the script. */
+    FILE *input;         /* The script. */
+    linereader reader;                                  /* Reads the script a block at a time. */
+    char *line;                                         /* The current line of the script. */
+    size_t length;                                      /* The length of the current line. */
+    boolean isComplete;                                 /* Has the whole current line been read? */
+    const char *error;                                  /* The reason the saved state could not be loaded. */
+    char text[ERROR_TEXT_LENGTH + ERROR_PREFIX_LENGTH]; /* An error which is not about a line of the script. */
+    int result;                                         /* The result of the current line. */
+    double start;                                       /* The time at which the script started. */
+
+    start = getTime();
+    input = NULL;
+    result = CALCULATOR_SUCCESS;
+
+    if ((context = createCalculator(pool->universe, writeJobOutput, writeJobErrors, job)) == NULL) {
+        job->ending = OUT_OF_MEMORY_ENDING;
+    } else if ((input = fopen(job->path, "r")) == NULL) {
+        strcpy(text, "Error: Failed to open the script.\n");
+        writeJobErrors(job, text, strlen(text));
+        job->ending = OPEN_FAILED_ENDING;
+    } else if (pool->statePath != NULL && (error = loadCalculatorState(context, pool->statePath)) != NULL) {
+        sprintf(text, "Error: Failed to load the state: %.*s\n", ERROR_TEXT_LENGTH, error);
+        writeJobErrors(job, text, strlen(text));
+        job->ending = STATE_FAILED_ENDING;
+    } else if (!createReader(&reader, input)) {
+        job->ending = OUT_OF_MEMORY_ENDING;
+    } else {
+        /* Run every line (blank ones included, so the errors have the same line numbers as in batch mode) until stop. */
+        while (result != CALCULATOR_STOPPED && result != CALCULATOR_OUT_OF_MEMORY && nextLine(&reader, LINE_PREFIX_LENGTH, &line, &length, &isComplete)) {
+            if (!isComplete) {
+                finishLine(&reader, &line, &length);
+            }
+
+            result = executeLine(context, line, length);
+            job->lines++;
+
+            if (result == CALCULATOR_INVALID || result == CALCULATOR_FAILED) {
+                job->failures++;
+            }
+        }
+
+        if (result == CALCULATOR_STOPPED) {
+            job->ending = STOPPED_ENDING;
+        } else if (result == CALCULATOR_OUT_OF_MEMORY) {
+            job->ending = OUT_OF_MEMORY_ENDING;
+        } else {
+            reportMissingStop(context);
+            job->failures++;
+            job->ending = MISSING_STOP_ENDING;
+        }
+
+        freeReader(&reader);
+    }
+
+    if (input != NULL) {
+        fclose(input);
+    }
+
+    if (context != NULL) {
+        freeCalculator(context);
+    }
+
+    job->seconds = getTime() - start;
+    finishJob(pool, job);
+}
+
+/**
+ * Takes the next script for a worker: the first one in its own deque, or else the last one in the deque of another worker.
+ *
+ * @param pool The pool.
+ * @param worker The index of the worker.
+ * @param script Set to the index of the script.
+ * @return TRUE if a script has been taken, FALSE if every deque is empty.
+ */
+static boolean takeJob(jobpool *pool, long worker, size_t *script) {
+    jobdeque *deque; /* The current deque. */
+    long offset;     /* The distance of the current deque from the worker's own one. */
+    boolean isTaken; /* Has a script been taken? */
+
+    isTaken = FALSE;
+
+    for (offset = STARTING_VALUE; offset < pool->workerCount && !isTaken; offset++) {
+        deque = &pool->deques[(worker + offset) % pool->workerCount];
+        pthread_mutex_lock(&deque->lock);
+
+        if (deque->first < deque->end) {
+            *script = offset == STARTING_VALUE ? deque->scripts[deque->first++] : deque->scripts[--deque->end];
+            isTaken = TRUE;
+        }
+
+        pthread_mutex_unlock(&deque->lock);
+    }
+
+    return isTaken;
+}
+
+/**
+ * Runs scripts until there are none left (the function of every worker thread).
+ *
+ * @param data The worker.
+ * @return NULL.
+ */
+static void *runWorker(void *data) {
+    jobworker *worker; /* The worker. */
+    size_t script;     /* The index of the current script. */
+
+    worker = data;
+
+    while (takeJob(worker->pool, worker->index, &script)) {
+        runScript(worker->pool, &worker->pool->jobs[script]);
+    }
+
+    return NULL;
+}
+
+/**
+ * Runs every script given on the command line in batch mode, several at once, each with its own sets (starting from the saved state, if any).
+ * The output of every script is written to the standard output, and its errors (after its path) to the standard error,
+ * in the order of the scripts on the command line, the same as running them one after another.
+ * Then, writes a summary of every script to the standard error: its number of lines and errors, its runtime and how it ended.
+ *
+ * @param programOptions The options the program has been run with.
+ * @return 0 if every script has run until stop, 1 otherwise.
+ */
+int runJobs(const options *programOptions) {
+    jobpool pool;       /* Everything the workers share. */
+    jobworker *workers; /* The worker threads. */
+    scriptjob *job;     /* The current script. */
+    size_t index;       /* Current index in the scripts. */
+    long worker;        /* Current index in the workers. */
+    int status;         /* The exit code. */
+    double start;       /* The time at which the first script started. */
+
+    pool.jobCount = programOptions->scriptCount;
+    pool.workerCount = programOptions->jobs < (long)pool.jobCount ? programOptions->jobs : (long)pool.jobCount;
+    pool.jobs = malloc(pool.jobCount * sizeof(scriptjob));
+    pool.deques = malloc(pool.workerCount * sizeof(jobdeque));
+    workers = malloc(pool.workerCount * sizeof(jobworker));
+
+    /* Check for an error in the memory allocation. */
+    if (pool.jobs == NULL || pool.deques == NULL || workers == NULL) {
+        /* Exit the program. */
+        fprintf(stderr, "Failed to allocate memory for the scripts.\n");
+        exit(ERROR);
+    }
+
+    pool.nextOutput = FIRST_INDEX;
+    pool.universe = programOptions->universe;
+    pool.statePath = programOptions->statePath;
+    pthread_mutex_init(&pool.lock, NULL);
+
+    /* Deal the scripts out in turn, so every worker starts with the earliest ones. */
+    for (worker = FIRST_INDEX; worker < pool.workerCount; worker++) {
+        pool.deques[worker].first = pool.deques[worker].end = FIRST_INDEX;
+
+        /* Check for an error in the memory allocation. */
+        if ((pool.deques[worker].scripts = malloc((pool.jobCount / pool.workerCount + NEXT_INDEX_DIFFERENCE) * sizeof(size_t))) == NULL) {
+            /* Exit the program. */
+            fprintf(stderr, "Failed to allocate memory for the scripts.\n");
+            exit(ERROR);
+        }
+
+        pthread_mutex_init(&pool.deques[worker].lock, NULL);
+    }
+
+    for (index = FIRST_INDEX; index < pool.jobCount; index++) {
+        job = &pool.jobs[index];
+        job->path = programOptions->scriptPaths[index];
+        pthread_mutex_init(&job->lock, NULL);
+        job->output.text = job->errors.text = NULL;
+        job->output.length = job->output.capacity = job->errors.length = job->errors.capacity = EMPTY;
+        job->isHead = index == FIRST_INDEX;
+        job->isDone = FALSE;
+        job->lines = job->failures = STARTING_VALUE;
+        job->seconds = STARTING_VALUE;
+        job->ending = STOPPED_ENDING;
+        pool.deques[index % pool.workerCount].scripts[pool.deques[index % pool.workerCount].end++] = index;
+    }
+
+    /* Only flush the output when the buffer is full or when the program ends. */
+    setvbuf(stdout, NULL, _IOFBF, OUTPUT_BUFFER_SIZE);
+    start = getTime();
+
+    for (worker = FIRST_INDEX; worker < pool.workerCount; worker++) {
+        workers[worker].pool = &pool;
+        workers[worker].index = worker;
+
+        if (pthread_create(&workers[worker].thread, NULL, runWorker, &workers[worker]) != SUCCESS) {
+            /* Exit the program. */
+            fprintf(stderr, "Failed to start the worker threads.\n");
+            exit(ERROR);
+        }
+    }
+
+    for (worker = FIRST_INDEX; worker < pool.workerCount; worker++) {
+        pthread_join(workers[worker].thread, NULL);
+    }
+
+    /* The summary comes after the output of every script. */
+    fflush(stdout);
+    status = SUCCESS;
+    fprintf(stderr, "%-40s %10s %10s %12s  %s\n", "script", "lines", "errors", "time (ms)", "result");
+
+    for (index = FIRST_INDEX; index < pool.jobCount; index++) {
+        job = &pool.jobs[index];
+        fprintf(stderr, "%-40s %10lu %10lu %12.3f  %s\n", job->path, job->lines, job->failures, job->seconds * MILLISECONDS_PER_SECOND, ENDINGS[job->ending]);
+
+        if (job->ending != STOPPED_ENDING) {
+            status = ERROR;
+        }
+
+        pthread_mutex_destroy(&job->lock);
+    }
+
+    fprintf(stderr, "Scripts: %lu, jobs: %ld, time: %.3f s\n", (unsigned long)pool.jobCount, pool.workerCount, getTime() - start);
+
+    /* Everything the scripts used is no longer used. */
+    for (worker = FIRST_INDEX; worker < pool.workerCount; worker++) {
+        pthread_mutex_destroy(&pool.deques[worker].lock);
+        free(pool.deques[worker].scripts);
+    }
+
+    pthread_mutex_destroy(&pool.lock);
+    free(pool.jobs);
+    free(pool.deques);
+    free(workers);
+    return status;
+}
@@ -0,0 +1,27 @@
+/*
+ * jobs.h
+ * Includes the prototypes of all the functions in jobs.c.
+ *
+ * Name: Ariel Keren
+ * Course: C Lab, 20465
+ * Semester: 2024B
+ * Date: 18/10/2026
+ */
+
+#ifndef JOBS_H
+#define JOBS_H
+
+#include "mysetUtils.h"
+
+/**
+ * Runs every script given on the command line in batch mode, several at once, each with its own sets (starting from the saved state, if any).
+ * The output of every script is written to the standard output, and its errors (after its path) to the standard error,
+ * in the order of the scripts on the command line, the same as running them one after another.
+ * Then, writes a summary of every script to the standard error: its number of lines and errors, its runtime and how it ended.
+ *
+ * @param programOptions The options the program has been run with.
+ * @return 0 if every script has run until stop, 1 otherwise.
+ */
+int runJobs(const options *programOptions);
+
+#endif
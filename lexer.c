@@ -0,0 +1,172 @@
+/*
+ * lexer.c
+ * Includes a reentrant lexer, which walks over an input line a single time.
+ * The tokens are spans (offsets and lengths) of the line, so the line is never copied or changed.
+ * Also, includes functions for handling lists of tokens.
+ *
+ * Name: Ariel Keren
+ * Course: C Lab, 20465
+ * Semester: 2024B
+ * Date: 18/10/2026
+ */
+
+#include "lexer.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "calculator.h"
+#include "globals.h"
+
+/**
+ * Prepares the lexer to walk over the given line.
+ * The line does not have to be null-terminated.
+ *
+ * @param lineLexer The lexer to prepare.
+ * @param line The line to walk over.
+ * @param length The length of the line.
+ */
+void initializeLexer(lexer *lineLexer, const char line[], size_t length) {
+    lineLexer->line = line;
+    lineLexer->length = length;
+    lineLexer->position = FIRST_INDEX;
+}
+
+/**
+ * Finds the next token in the line.
+ * Words are separated by whitespace characters and commas. Every comma is a token of its own.
+ *
+ * @param lineLexer The lexer walking over the line.
+ * @param nextToken The token to fill.
+ * @return TRUE if a token has been found, FALSE if the end of the line has been reached.
+ */
+boolean getNextToken(lexer *lineLexer, token *nextToken) {
+    const char *line; /* The line being walked over. */
+    size_t position;  /* The current position in the line. */
+
+    line = lineLexer->line;
+    position = lineLexer->position;
+
+    /* Skip the whitespace characters before the token. */
+    while (position < lineLexer->length && isspace((unsigned char)line[position])) {
+        position++;
+    }
+
+    /* Check if the end of the line has been reached. */
+    if (position == lineLexer->length) {
+        lineLexer->position = position;
+        return FALSE;
+    }
+
+    nextToken->offset = position;
+
+    /* A comma is always a token of its own. */
+    if (line[position] == ',') {
+        nextToken->type = COMMA_TOKEN;
+        nextToken->length = SINGLE_CHARACTER;
+        lineLexer->position = position + NEXT_INDEX_DIFFERENCE;
+        return TRUE;
+    }
+
+    /* A word continues until a whitespace character, a comma or the end of the line. */
+    while (position < lineLexer->length && line[position] != ',' && !isspace((unsigned char)line[position])) {
+        position++;
+    }
+
+    nextToken->type = WORD_TOKEN;
+    nextToken->length = position - nextToken->offset;
+    lineLexer->position = position;
+    return TRUE;
+}
+
+/**
+ * Initializes an empty token list.
+ *
+ * @param tokens The token list to initialize.
+ */
+void initializeTokenList(tokenlist *tokens) {
+    tokens->tokens = NULL;
+    tokens->count = STARTING_VALUE;
+    tokens->capacity = STARTING_VALUE;
+}
+
+/**
+ * Frees the memory used by the token list.
+ *
+ * @param tokens The token list to free.
+ */
+void freeTokenList(tokenlist *tokens) {
+    free(tokens->tokens);
+    initializeTokenList(tokens);
+}
+
+/**
+ * Walks over the line once and fills the token list with all of its tokens.
+ * Exits the program if the list cannot grow.
+ *
+ * @param line The line to tokenize.
+ * @param length The length of the line.
+ * @param tokens The token list to fill (its previous tokens are discarded).
+ */
+void tokenizeLine(const char line[], size_t length, tokenlist *tokens) {
+    lexer lineLexer;      /* The lexer walking over the line. */
+    token currentToken;   /* The current token in the line. */
+    token *grownTokens;   /* The tokens after growing the list. */
+    size_t grownCapacity; /* The capacity of the list after growing it. */
+
+    tokens->count = STARTING_VALUE;
+    initializeLexer(&lineLexer, line, length);
+
+    /* Loop over all the tokens in the line. */
+    while (getNextToken(&lineLexer, &currentToken)) {
+        /* Grow the list (geometrically) if it is full. */
+        if (tokens->count == tokens->capacity) {
+            grownCapacity = tokens->capacity == EMPTY ? INITIAL_TOKENS : tokens->capacity * GROWTH_FACTOR;
+            grownTokens = realloc(tokens->tokens, grownCapacity * sizeof(token));
+
+            /* Check for an error in the memory allocation. */
+            if (grownTokens == NULL) {
+                failMemory("Failed to allocate memory for the tokens of the input.");
+            }
+
+            tokens->tokens = grownTokens;
+            tokens->capacity = grownCapacity;
+        }
+
+        tokens->tokens[tokens->count++] = currentToken;
+    }
+}
+
+/**
+ * Removes the comma tokens from the token list, keeping the order of the words.
+ *
+ * @param tokens The token list to remove the commas from.
+ */
+void removeCommas(tokenlist *tokens) {
+    size_t index;  /* Current index in the token list. */
+    size_t insert; /* The position to insert the next word into. */
+
+    /* Move every word back to the next free position. */
+    for (index = insert = FIRST_INDEX; index < tokens->count; index++) {
+        if (tokens->tokens[index].type == WORD_TOKEN) {
+            tokens->tokens[insert++] = tokens->tokens[index];
+        }
+    }
+
+    tokens->count = insert;
+}
+
+/**
+ * Checks if the given token's text is the given word.
+ * Assumes the word is null-terminated.
+ *
+ * @param line The line the token belongs to.
+ * @param wordToken The token to check.
+ * @param word The word to compare to.
+ * @return TRUE if the token's text is the word, FALSE otherwise.
+ */
+boolean tokenEquals(const char line[], const token *wordToken, const char word[]) {
+    return strlen(word) == wordToken->length && !memcmp(line + wordToken->offset, word, wordToken->length);
+}
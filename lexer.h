@@ -0,0 +1,106 @@
+/*
+ * lexer.h
+ * Includes the prototypes of all the functions in lexer.c.
+ * Also, includes the types of the tokens the lexer produces.
+ *
+ * Name: Ariel Keren
+ * Course: C Lab, 20465
+ * Semester: 2024B
+ * Date: 18/10/2026
+ */
+
+#ifndef LEXER_H
+#define LEXER_H
+
+#include <stddef.h>
+
+#include "globals.h"
+
+/* The kinds of tokens in an input line. */
+typedef enum { WORD_TOKEN,
+               COMMA_TOKEN } tokentype;
+
+/* A token is a span of the input line (the line itself is never copied or changed). */
+typedef struct {
+    tokentype type; /* The kind of the token. */
+    size_t offset;  /* The offset of the token's first character in the line. */
+    size_t length;  /* The number of characters in the token. */
+} token;
+
+/* A growing list of tokens, which can be reused for every input line. */
+typedef struct {
+    token *tokens;   /* The tokens of the line. */
+    size_t count;    /* The number of tokens in the list. */
+    size_t capacity; /* The number of tokens the list has memory for. */
+} tokenlist;
+
+/* The state of the lexer while walking over a line. */
+typedef struct {
+    const char *line; /* The line being walked over. */
+    size_t length;    /* The length of the line. */
+    size_t position;  /* The offset of the next character to check. */
+} lexer;
+
+/**
+ * Prepares the lexer to walk over the given line.
+ * The line does not have to be null-terminated.
+ *
+ * @param lineLexer The lexer to prepare.
+ * @param line The line to walk over.
+ * @param length The length of the line.
+ */
+void initializeLexer(lexer *lineLexer, const char line[], size_t length);
+
+/**
+ * Finds the next token in the line.
+ * Words are separated by whitespace characters and commas. Every comma is a token of its own.
+ *
+ * @param lineLexer The lexer walking over the line.
+ * @param nextToken The token to fill.
+ * @return TRUE if a token has been found, FALSE if the end of the line has been reached.
+ */
+boolean getNextToken(lexer *lineLexer, token *nextToken);
+
+/**
+ * Initializes an empty token list.
+ *
+ * @param tokens The token list to initialize.
+ */
+void initializeTokenList(tokenlist *tokens);
+
+/**
+ * Frees the memory used by the token list.
+ *
+ * @param tokens The token list to free.
+ */
+void freeTokenList(tokenlist *tokens);
+
+/**
+ * Walks over the line once and fills the token list with all of its tokens.
+ * Exits the program if the list cannot grow.
+ *
+ * @param line The line to tokenize.
+ * @param length The length of the line.
+ * @param tokens The token list to fill (its previous tokens are discarded).
+ */
+void tokenizeLine(const char line[], size_t length, tokenlist *tokens);
+
+/**
+ * Removes the comma tokens from the token list, keeping the order of the words.
+ *
+ * @param tokens The token list to remove the commas from.
+ */
+void removeCommas(tokenlist *tokens);
+
+/**
+ * Checks if the given token's text is the given word.
+ * Assumes the word is null-terminated.
+ *
+ * @param line The line the token belongs to.
+ * @param wordToken The token to check.
+ * @param word The word to compare to.
+ * @return TRUE if the token's text is the word, FALSE otherwise.
+ */
+boolean tokenEquals(const char line[], const token *wordToken, const char word[]);
+
+#endif
@@ -8,32 +8,84 @@
  * Date: 07/06/2024
  */
 
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "calculator.h"
 #include "globals.h"
+#include "jobs.h"
 #include "mysetUtils.h"
-#include "set.h"
+#include "pipeline.h"
+#include "server.h"
+#include "stats.h"
+#include "tasks.h"
 
 /**
- * Initializes the 6 sets to be used in the program.
- * Prints an explanation of the program.
+ * Creates the calculator which runs the commands, with the 6 sets which exist when the program starts.
+ * Prints an explanation of the program (unless in batch mode).
  * Runs the program.
  *
+ * @param argc The number of command line arguments.
+ * @param argv The command line arguments.
  * @return 0 when run successfully.
  */
-int main() {
-    /* The 6 sets used in the program. */
-    set SETA, SETB, SETC, SETD, SETE, SETF;
-    /* An array containing all the sets, so they can be passed more easily to functions. */
-    setptr sets[NUMBER_OF_SETS];
+int main(int argc, char *argv[]) {
+    /* The calculator which runs the commands (its sets, command graph and statistics). */
+    calculator *context;
+    /* The options the program has been run with. */
+    options programOptions;
+    /* The input to read the commands from. */
+    FILE *input;
+
+    parseArguments(argc, argv, &programOptions);
+
+    /* Serve many clients over a socket (each with its own sets) instead of running a single stream of commands. */
+    if (programOptions.servePath != NULL) {
+        return runServer(&programOptions);
+    }
+
+    /* Run many scripts at once (each with its own sets) instead of a single one. */
+    if (programOptions.jobs != NO_JOBS) {
+        return runJobs(&programOptions);
+    }
+
+    input = openInput(&programOptions);
+
+    /* Every set covers the universe chosen on the command line, and everything is printed to the standard output (or the standard error). */
+    if ((context = createCalculator(programOptions.universe, writeStandardOutput, writeStandardError, NULL)) == NULL) {
+        /* Exit the program. */
+        fprintf(stderr, "Failed to allocate memory for the sets.\n");
+        exit(ERROR);
+    }
+
+    /* The program uses the same calculator from start to end (a failed memory allocation exits the program). */
+    useCalculator(context);
+
+    /* Compute the sets on the number of threads given on the command line (this thread runs the commands, and helps while it waits). */
+    startHelpers(programOptions.threads - NEXT_INDEX_DIFFERENCE);
+
+    /* Write the statistics to the file given on the command line on exit (and on SIGUSR1). */
+    watchStatistics(programOptions.statsPath);
+
+    /* Start from the saved state given on the command line (if any). */
+    loadStartingState(&context->sets, &programOptions);
 
-    initializeSets(sets, SETA, SETB, SETC, SETD, SETE, SETF);
+    /* Print an explanation of the program, along with every valid command (a script does not need it). */
+    if (!programOptions.isBatch) {
+        printExplanation();
+    }
 
-    /* Reset all the sets. */
-    resetSets(sets);
+    /* Start the program (a script can be read, validated and executed at once, on separate threads). */
+    if (programOptions.isBatch && programOptions.isPipelined) {
+        runPipeline(&context->sets, input);
+    } else {
+        readInput(&context->sets, input, programOptions.isBatch);
+    }
 
-    /* Print an explanation of the program, along with every valid command. */
-    printExplanation();
-    /* Start the program. */
-    readInput(sets);
+    /* The statistics are written one last time, and the calculator (along with every set in it) is no longer used. */
+    closeStatistics();
+    freeCalculator(context);
+    stopHelpers();
 
     /* Return 0 when run successfully. */
     return SUCCESS;
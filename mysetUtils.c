@@ -18,60 +18,343 @@
 
 #include "execution.h"
 #include "globals.h"
+#include "graph.h"
+#include "lexer.h"
+#include "registry.h"
 #include "set.h"
+#include "setUtils.h"
+#include "snapshot.h"
+#include "stats.h"
 #include "utils.h"
 #include "validation.h"
 
+/**
+ * Prints the usage of the program and exits it.
+ *
+ * @param program The name of the program (the first command line argument).
+ */
+static void failUsage(const char program[]) {
+    fprintf(stderr, "Usage: %s [%s <size>] [%s <file>] [%s <file>] [[%s <count>] [[%s] %s [<script>]] | %s <socket> [%s <count>] | %s <count> <script>...]\n", program, UNIVERSE_FLAG, STATE_FLAG, STATS_FLAG,
+            THREADS_FLAG, PIPELINE_FLAG, BATCH_FLAG, SERVE_FLAG, WORKERS_FLAG, JOBS_FLAG);
+    fprintf(stderr, "The options can be given in any order, except for the scripts after %s, which come last.\n", JOBS_FLAG);
+    exit(ERROR);
+}
+
+/**
+ * Parses the command line arguments into the given options.
+ * Prints the usage and exits the program if the arguments are invalid.
+ *
+ * @param argc The number of command line arguments.
+ * @param argv The command line arguments.
+ * @param programOptions The options to fill.
+ */
+void parseArguments(int argc, char *argv[], options *programOptions) {
+    int index;             /* Current index in the arguments. */
+    char *end;             /* The end of a number argument. */
+    boolean isScriptGiven; /* Has the path of the script been given? */
+
+    programOptions->isBatch = FALSE;
+    programOptions->scriptPath = STANDARD_INPUT_PATH;
+    programOptions->isPipelined = FALSE;
+    programOptions->universe = DEFAULT_UNIVERSE;
+    programOptions->statePath = NULL;
+    programOptions->statsPath = NULL;
+    programOptions->servePath = NULL;
+    programOptions->workers = DEFAULT_WORKERS;
+    programOptions->threads = DEFAULT_THREADS;
+    programOptions->jobs = NO_JOBS;
+    programOptions->scriptPaths = NULL;
+    programOptions->scriptCount = EMPTY;
+    isScriptGiven = FALSE;
+
+    /* Loop over all the arguments. */
+    for (index = FIRST_ARGUMENT; index < argc; index++) {
+        /* Check for batch mode. */
+        if (!strcmp(argv[index], BATCH_FLAG)) {
+            programOptions->isBatch = TRUE;
+
+            continue;
+        }
+
+        /* Check for running the stages of every line at once. */
+        if (!strcmp(argv[index], PIPELINE_FLAG)) {
+            programOptions->isPipelined = TRUE;
+            continue;
+        }
+
+        /* Check for the size of the universe. */
+        if (!strcmp(argv[index], UNIVERSE_FLAG) && index + NEXT_INDEX_DIFFERENCE < argc) {
+            programOptions->universe = strtol(argv[++index], &end, DECIMAL_BASE);
+
+            /* The size should be a whole number in the valid range. */
+            if (*end != '\0' || programOptions->universe < MINIMUM_UNIVERSE || programOptions->universe > MAXIMUM_UNIVERSE) {
+                fprintf(stderr, "Error: The size of the universe should be an integer in the range %d-%ld.\n", MINIMUM_UNIVERSE, MAXIMUM_UNIVERSE);
+                exit(ERROR);
+            }
+
+            continue;
+        }
+
+        /* Check for a saved state to start from. */
+        if (!strcmp(argv[index], STATE_FLAG) && index + NEXT_INDEX_DIFFERENCE < argc) {
+            programOptions->statePath = argv[++index];
+            continue;
+        }
+
+        /* Check for a file to write the statistics to. */
+        if (!strcmp(argv[index], STATS_FLAG) && index + NEXT_INDEX_DIFFERENCE < argc) {
+            programOptions->statsPath = argv[++index];
+            continue;
+        }
+
+        /* Check for server mode. */
+        if (!strcmp(argv[index], SERVE_FLAG) && index + NEXT_INDEX_DIFFERENCE < argc) {
+            programOptions->servePath = argv[++index];
+            continue;
+        }
+
+        /* Check for the number of worker threads in server mode. */
+        if (!strcmp(argv[index], WORKERS_FLAG) && index + NEXT_INDEX_DIFFERENCE < argc) {
+            programOptions->workers = strtol(argv[++index], &end, DECIMAL_BASE);
+
+            /* The number should be a whole number in the valid range. */
+            if (*end != '\0' || programOptions->workers < MINIMUM_WORKERS || programOptions->workers > MAXIMUM_WORKERS) {
+                fprintf(stderr, "Error: The number of worker threads should be an integer in the range %d-%d.\n", MINIMUM_WORKERS, MAXIMUM_WORKERS);
+                exit(ERROR);
+            }
+
+            continue;
+        }
+
+        /* Check for the number of threads which compute the sets. */
+        if (!strcmp(argv[index], THREADS_FLAG) && index + NEXT_INDEX_DIFFERENCE < argc) {
+            programOptions->threads = strtol(argv[++index], &end, DECIMAL_BASE);
+
+            /* The number should be a whole number in the valid range. */
+            if (*end != '\0' || programOptions->threads < DEFAULT_THREADS || programOptions->threads > MAXIMUM_THREADS) {
+                fprintf(stderr, "Error: The number of threads should be an integer in the range %d-%d.\n", DEFAULT_THREADS, MAXIMUM_THREADS);
+                exit(ERROR);
+            }
+
+            continue;
+        }
+
+        /* Check for scripts to run at once (every argument after the number of worker threads is a script). */
+        if (!strcmp(argv[index], JOBS_FLAG) && index + NEXT_INDEX_DIFFERENCE < argc) {
+            programOptions->jobs = strtol(argv[++index], &end, DECIMAL_BASE);
+
+            /* The number should be a whole number in the valid range, and there should be at least one script. */
+            if (*end != '\0' || programOptions->jobs < MINIMUM_WORKERS || programOptions->jobs > MAXIMUM_WORKERS || index + NEXT_INDEX_DIFFERENCE == argc) {
+                fprintf(stderr, "Error: %s should be followed by an integer in the range %d-%d, and then by at least one script.\n", JOBS_FLAG, MINIMUM_WORKERS, MAXIMUM_WORKERS);
+                exit(ERROR);
+            }
+
+            programOptions->scriptPaths = argv + index + NEXT_INDEX_DIFFERENCE;
+            programOptions->scriptCount = argc - index - NEXT_INDEX_DIFFERENCE;
+            break;
+        }
+
+        /* Check for the script of batch mode (the only argument which is not a flag, anywhere among the flags). */
+        if (!isScriptGiven && strncmp(argv[index], FLAG_PREFIX, FLAG_PREFIX_LENGTH)) {
+            programOptions->scriptPath = argv[index];
+            isScriptGiven = TRUE;
+            continue;
+        }
+
+        /* Unknown argument. */
+        fprintf(stderr, "Error: Unknown argument %s.\n", argv[index]);
+        failUsage(argv[FIRST_INDEX]);
+    }
+
+    /* The helper threads only compute the sets of a single stream of commands (sessions and scripts run on their own worker threads). */
+    if (programOptions->threads != DEFAULT_THREADS && (programOptions->servePath != NULL || programOptions->jobs != NO_JOBS)) {
+        fprintf(stderr, "Error: %s cannot be used with %s or %s.\n", THREADS_FLAG, SERVE_FLAG, JOBS_FLAG);
+        failUsage(argv[FIRST_INDEX]);
+    }
+
+    /* A script is only run in batch mode (without it, the standard input is). */
+    if (isScriptGiven && !programOptions->isBatch) {
+        fprintf(stderr, "Error: The script %s is only run with %s.\n", programOptions->scriptPath, BATCH_FLAG);
+        failUsage(argv[FIRST_INDEX]);
+    }
+}
+
+/**
+ * Opens the input the commands should be read from.
+ * In batch mode, this is the script file (unless it is "-"). Otherwise, this is the standard input.
+ * In batch mode, also gives the standard output a large buffer.
+ * Exits the program if the script cannot be opened.
+ *
+ * @param programOptions The options the program has been run with.
+ * @return The input to read the commands from.
+ */
+FILE *openInput(const options *programOptions) {
+    FILE *input; /* The input to read the commands from. */
+
+    /* Interactive mode always reads from the standard input. */
+    if (!programOptions->isBatch) {
+        return stdin;
+    }
+
+    /* Only flush the output when the buffer is full or when the program ends. */
+    setvbuf(stdout, NULL, _IOFBF, OUTPUT_BUFFER_SIZE);
+
+    /* Check if the script should be read from the standard input. */
+    if (!strcmp(programOptions->scriptPath, STANDARD_INPUT_PATH)) {
+        return stdin;
+    }
+
+    input = fopen(programOptions->scriptPath, "r");
+
+    /* Check for an error in opening the script. */
+    if (input == NULL) {
+        fprintf(stderr, "Error: Failed to open the script %s.\n", programOptions->scriptPath);
+        exit(ERROR);
+    }
+
+    return input;
+}
+
 /**
  * Runs the program.
  * First, reads a line as input from the user.
  * Second, checks if the line is valid.
  * Third, executes the input.
  * Repeats these steps until the end of the program.
+ * In batch mode, does not print any prompts or messages, and reports errors with line numbers.
  *
- * @param sets An array of sets.
+ * @param sets The registry of every defined set.
+ * @param input The input to read the commands from.
+ * @param isBatch TRUE if the program runs in batch mode, FALSE otherwise.
  */
-void readInput(setptr sets[]) {
-    boolean isStopped; /* Is the program stopped? */
-    char *line;        /* Current line as input from the user. */
+void readInput(setregistry *sets, FILE *input, boolean isBatch) {
+    boolean isStopped;        /* Is the program stopped? */
+    boolean isValid;          /* Is the current line valid? */
+    boolean isComplete;       /* Has the whole current line been read? */
+    boolean isStreamed;       /* Is the current line a read_set line which is checked a chunk at a time? */
+    char *line;               /* Current line as input from the user (only its start if it is streamed). */
+    size_t length;            /* The length of the current line. */
+    unsigned long lineNumber; /* The number of the current line. */
+    tokenlist tokens;         /* The tokens of the current line (reused for every line). */
+    instruction command;      /* The current line, compiled into an instruction. */
+    readsetstream stream;     /* The validation of the current line, if it is streamed. */
+    const char *part;         /* The next characters of a streamed line. */
+    linereader reader;        /* Reads the input a block at a time. */
+    statstimer readTimer;     /* Times reading the current line. */
+    statstimer timer;         /* Times validating or executing the current line. */
 
     isStopped = FALSE;
+    lineNumber = STARTING_VALUE;
+    setBatchMode(isBatch);
+    initializeTokenList(&tokens);
+
+    /* The input is read in large blocks, and lines are handed out in place. */
+    if (!createReader(&reader, input)) {
+        /* Exit the program. */
+        fprintf(stderr, "Failed to allocate memory for the input.\n");
+        exit(ERROR);
+    }
+
+    /* The instruction is reused for every line. */
+    if (!createInstruction(&command)) {
+        /* Exit the program. */
+        fprintf(stderr, "Failed to allocate memory for the instructions.\n");
+        exit(ERROR);
+    }
 
     /* Loop until the program is stopped. */
     while (!isStopped) {
-        printf("\nPlease enter a command:\n");
+        /* Write the statistics if they have been requested during the last command. */
+        checkStatistics();
+        printMessage("\nPlease enter a command:");
+
+        lineNumber++;
+
+        /* Errors are only reported with line numbers in batch mode. */
+        if (isBatch) {
+            setLineNumber(lineNumber);
+        }
 
         /* Read the command from the user. */
-        line = readLine();
+        startTimer(&readTimer);
+        line = readLine(&reader, &length, &isComplete);
 
         /* Skip blank lines. */
         if (line == NULL) {
-            printf("Skipping empty line...\n");
+            printMessage("Skipping empty line...");
             continue;
         }
 
-        /* Print the line that was entered. */
-        printf("Your input: %s\n", line);
+        /* A long read_set line is checked as it is read, and any other long line is read in full. */
+        isStreamed = !isComplete && startReadSetStream(&stream, line, length, &command);
+
+        if (!isComplete && !isStreamed) {
+            finishLine(&reader, &line, &length);
+        }
+
+        stopTimer(&readTimer);
+
+        /* Print the line that was entered (only its start if it is streamed). */
+        if (!isBatch) {
+            printf(isStreamed ? "Your input: %s...\n" : "Your input: %s\n", line);
+        }
+
+        /* Validate the line and compile it into an instruction (reading the rest of a streamed line along the way). */
+        startTimer(&timer);
+
+        if (isStreamed) {
+            do {
+                part = nextLinePart(&reader, &length, &isComplete);
+                feedReadSetStream(&stream, part, length);
+            } while (!isComplete);
+
+            isValid = finishReadSetStream(&stream);
+        } else {
+            isValid = compileLine(line, length, &tokens, &command);
+        }
+
+        stopTimer(&timer);
+        /* Lines which are not valid commands are recorded apart from every operation. */
+        recordTimer(&readTimer, READ_PHASE, isValid ? command.operation : INVALID_OPERATION);
+        recordTimer(&timer, VALIDATE_PHASE, isValid ? command.operation : INVALID_OPERATION);
 
         /* Skip to the next input line if the current line is invalid. */
-        if (!isLineValid(line)) {
-            free(line);
+        if (!isValid) {
+            /* Blank lines are skipped without an error. */
+            if (command.error == NULL) {
+                printMessage("Skipping empty line...");
+            } else {
+                printError(command.error);
+            }
+
             continue;
         }
 
-        /* Execute the user's command. */
-        if (executeLine(line, sets)) {
+        /* Execute the user's command (the instruction refers to the input line, so the next line is only read afterwards). */
+        startTimer(&timer);
+
+        if (executeInstruction(&command, sets)) {
             /* Stop the program if the command was stop. */
             isStopped = TRUE;
         }
 
-        /* The input line is no longer used. */
-        free(line);
+        stopTimer(&timer);
+        recordTimer(&timer, EXECUTE_PHASE, command.operation);
+
+        /* Check if the command could not be executed (e.g. it refers to a set which is not defined). */
+        if (command.error != NULL) {
+            printError(command.error);
+            continue;
+        }
 
-        printf("Command executed successfully!\n");
+        printMessage("Command executed successfully!");
     }
 
-    printf("Goodbye!\n");
+    /* The token list, the reader and the instruction are no longer used. */
+    freeTokenList(&tokens);
+    freeReader(&reader);
+    freeInstruction(&command);
+    printMessage("Goodbye!");
 }
 
 /**
@@ -86,116 +369,96 @@ void printExplanation() {
     printf("These are the possible commands:\n");
     printf("\nread_set <set>, <number>, <number>, ..., -1 --- Fills the set with the given numbers.\n");
     printf("print_set <set> --- Prints the set.\n");
-    printf("union_set <set>, <set>, <set> --- Sets the third set to the union of the first two sets.\n");
-    printf("intersect_set <set>, <set>, <set> --- Sets the third set to the intersection of the first two sets.\n");
+    printf("union_set <set>, <set>, ..., <set> --- Sets the last set to the union of all the other sets.\n");
+    printf("intersect_set <set>, <set>, ..., <set> --- Sets the last set to the intersection of all the other sets.\n");
     printf("sub_set <set>, <set>, <set> --- Sets the third set to the difference of the first two sets.\n");
-    printf("symdiff_set <set>, <set>, <set> --- Sets the third set to the symmetric difference of the first two sets.\n");
+    printf("symdiff_set <set>, <set>, ..., <set> --- Sets the last set to the symmetric difference of all the other sets.\n");
+    printf("drop_set <set> --- Removes the set.\n");
+    printf("count_set <set> --- Prints the number of members in the set.\n");
+    printf("min_set <set> --- Prints the smallest member in the set.\n");
+    printf("max_set <set> --- Prints the largest member in the set.\n");
+    printf("eval <set> = <expression> --- Sets the set to the result of the expression (e.g. eval SETF = (SETA | SETB) & ~SETC).\n");
+    printf("cache_stats --- Prints how many set operations have reused an earlier result, and how many have not.\n");
+    printf("save_state <file> --- Saves every set to the file.\n");
+    printf("load_state <file> --- Replaces every set with the sets saved in the file.\n");
+    printf("load_set <set>, <file>, <format> --- Fills the set with the members in the binary file (the format is bitmap or array, and bitmap if omitted).\n");
+    printf("dump_set <set>, <file>, <format> --- Writes the members of the set to the binary file (the format is bitmap or array, and bitmap if omitted).\n");
+    printf("stats --- Prints how many commands have run and how long each phase of them has taken, by operation.\n");
     printf("stop --- Ends the program.\n");
 
     /* Valid operands. */
     printf("\nIn all commands:\n");
-    printf("\n<set> is one of SETA, SETB, SETC, SETD, SETE, SETF.\n");
-    printf("<number> is an integer in the range 0-127.\n\n");
+    printf("\n<set> is a name made of letters, digits and underscores (not starting with a digit).\n");
+    printf("SETA, SETB, SETC, SETD, SETE and SETF always start out empty. Other sets are created by read_set, eval, or as the last set of an operation.\n");
+    printf("<expression> combines sets with | (union), ^ (symmetric difference), & (intersection), - (difference) and ~ (complement), from the lowest precedence to the highest, and parentheses.\n");
+    printf("<number> is an integer in the range %d-%ld.\n\n", SMALLEST_MEMBER, getLargestMember());
 }
 
 /**
- * Initializes the array containing all the sets.
+ * Loads the saved state given on the command line (if any) into the registry of sets.
+ * Exits the program if the file is not a valid saved state.
  *
- * @param sets An array of sets to populate.
- * @param setA The first set.
- * @param setB The second set.
- * @param setC The third set.
- * @param setD The fourth set.
- * @param setE The fifth set.
- * @param setF The sixth set.
+ * @param sets The registry of sets.
+ * @param programOptions The options the program has been run with.
  */
-void initializeSets(setptr sets[], set setA, set setB, set setC, set setD, set setE, set setF) {
-    /* Populate each position in the array with the right set. */
-    sets[FIRST_INDEX] = setA;
-    sets[SECOND_INDEX] = setB;
-    sets[THIRD_INDEX] = setC;
-    sets[FOURTH_INDEX] = setD;
-    sets[FIFTH_INDEX] = setE;
-    sets[SIXTH_INDEX] = setF;
+void loadStartingState(setregistry *sets, const options *programOptions) {
+    const char *error; /* The reason the saved state could not be loaded. */
+
+    /* Check if the program should start from a saved state. */
+    if (programOptions->statePath == NULL) {
+        return;
+    }
+
+    if ((error = loadState(sets, programOptions->statePath)) != NULL) {
+        fprintf(stderr, "Error: Failed to load the state %s: %s\n", programOptions->statePath, error);
+        exit(ERROR);
+    }
 }
 
 /**
- * Resets all the sets in the given set array.
- * Sets every section of every set to 0.
+ * Writes text to the standard output (the output sink of the program's calculator).
  *
- * @param sets An array of sets.
+ * @param data Not used.
+ * @param text The text to write.
+ * @param length The number of characters to write.
  */
-void resetSets(setptr sets[]) {
-    size_t index;             /* Current index in the set array. */
-    setindex currentSetIndex; /* Current index of the set. */
+void writeStandardOutput(void *data, const char text[], size_t length) {
+    (void)data;
+    fwrite(text, sizeof(char), length, stdout);
+}
 
-    /* Loop over each set. */
-    for (index = FIRST_INDEX; index < NUMBER_OF_SETS; index++) {
-        /* Loop over each section of the set. */
-        for (currentSetIndex = FIRST_INDEX; currentSetIndex < SET_SIZE; currentSetIndex++) {
-            /* Reset the current section. */
-            sets[index][currentSetIndex] = EMPTY;
-        }
-    }
+/**
+ * Writes text to the standard error (the error sink of the program's calculator).
+ *
+ * @param data Not used.
+ * @param text The text to write.
+ * @param length The number of characters to write.
+ */
+void writeStandardError(void *data, const char text[], size_t length) {
+    (void)data;
+    fwrite(text, sizeof(char), length, stderr);
 }
 
 /**
- * Reads and returns a line as input from the user.
+ * Reads and returns the start of a line as input from the user (at most LINE_PREFIX_LENGTH characters, unless the whole line has already been read).
+ * The rest of a longer line is left in the reader, to be read with finishLine or nextLinePart.
  * Exits the program if an error occurs or if end of file is reached.
  *
- * @return The line as input from the user.
+ * @param reader The reader to read the line from.
+ * @param length Set to the length of the start of the line.
+ * @param isComplete Set to TRUE if the whole line has been read, FALSE otherwise.
+ * @return The start of the line as input from the user (NULL if the line is empty), valid until the next line is read.
  */
-char *readLine() {
-    int character;  /* Current character of the input line. */
-    char *line;     /* Input line from the user. */
-    char *lastLine; /* The last input line. */
-    size_t index;   /* Size of the input line. */
+char *readLine(linereader *reader, size_t *length, boolean *isComplete) {
+    char *line; /* Input line from the user. */
 
     /* Exit the program if the end of file is reached. */
-    if ((character = getchar()) == EOF) {
-        fprintf(stderr, "Error: Missing stop command.\n");
-        printf("Exiting the program...\n");
+    if (!nextLine(reader, LINE_PREFIX_LENGTH, &line, length, isComplete)) {
+        printError("Missing stop command.");
+        printMessage("Exiting the program...");
         exit(ERROR);
     }
 
-    index = FIRST_INDEX;
-    line = NULL;
-
-    /* Loop over the characters until the end of the line or the file. */
-    while (character != '\n' && character != EOF) {
-        /* Allocate more memory if necessary. */
-        if (index % INITIAL_SIZE == NO_REMAINDER) {
-            /* Keep the pointer to the last line. */
-            lastLine = line;
-            /* Allocate more memory for the new line. */
-            line = malloc((index + INITIAL_SIZE) * sizeof(char));
-
-            /* Check for an error in the memory allocation. */
-            if (line == NULL) {
-                /* Exit the program. */
-                fprintf(stderr, "Failed to allocate memory for the input.\n");
-                exit(ERROR);
-            }
-
-            /* Copy the last line to the new line (if it is not the first time). */
-            if (lastLine != NULL) {
-                strcpy(line, lastLine);
-                /* The last line is no longer used. */
-                free(lastLine);
-            }
-        }
-
-        /* Insert the current character and increment the index. */
-        line[index++] = character;
-        character = getchar();
-    }
-
-    /* Check if memory has been actually allocated. */
-    if (index != FIRST_INDEX) {
-        /* Insert the terminating null character. */
-        line[index] = '\0';
-    }
-
-    /* Return the whole input line as it has been read. */
-    return line;
+    /* Return the start of the input line as it has been read. */
+    return *length == EMPTY ? NULL : line;
 }
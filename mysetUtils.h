@@ -13,18 +13,60 @@
 
 #include <stdio.h>
 
+#include "reader.h"
+#include "registry.h"
 #include "set.h"
 
+/* The options the program has been run with (from the command line). */
+typedef struct {
+    boolean isBatch;        /* Should the program run a script without any interaction? */
+    const char *scriptPath; /* The path of the script to run in batch mode ("-" for the standard input). */
+    boolean isPipelined;    /* Should the lines of the script be read, validated and executed on separate threads (batch mode only)? */
+    long universe;          /* The number of potential members in every set. */
+    const char *statePath;  /* The path of the saved state to load before the first command (NULL for none). */
+    const char *statsPath;  /* The path of the file to write the statistics to on exit (NULL for none). */
+    const char *servePath;  /* The path of the Unix domain socket to serve clients on (NULL to run a single stream of commands). */
+    long workers;           /* The number of worker threads in server mode (DEFAULT_WORKERS for one per processor). */
+    long threads;           /* The number of threads which compute the sets of a single stream of commands (including the one which runs it). */
+    long jobs;              /* The number of worker threads to run the scripts after --jobs on (NO_JOBS to run a single stream of commands). */
+    char **scriptPaths;     /* The paths of the scripts to run with --jobs. */
+    int scriptCount;        /* The number of scripts to run with --jobs. */
+} options;
+
+/**
+ * Parses the command line arguments into the given options.
+ * Prints the usage and exits the program if the arguments are invalid.
+ *
+ * @param argc The number of command line arguments.
+ * @param argv The command line arguments.
+ * @param programOptions The options to fill.
+ */
+void parseArguments(int argc, char *argv[], options *programOptions);
+
+/**
+ * Opens the input the commands should be read from.
+ * In batch mode, this is the script file (unless it is "-"). Otherwise, this is the standard input.
+ * In batch mode, also gives the standard output a large buffer.
+ * Exits the program if the script cannot be opened.
+ *
+ * @param programOptions The options the program has been run with.
+ * @return The input to read the commands from.
+ */
+FILE *openInput(const options *programOptions);
+
 /**
  * Runs the program.
  * First, reads a line as input from the user.
  * Second, checks if the line is valid.
  * Third, executes the input.
  * Repeats these steps until the end of the program.
+ * In batch mode, does not print any prompts or messages, and reports errors with line numbers.
  *
- * @param sets An array of sets.
+ * @param sets The registry of every defined set.
+ * @param input The input to read the commands from.
+ * @param isBatch TRUE if the program runs in batch mode, FALSE otherwise.
  */
-void readInput(setptr sets[]);
+void readInput(setregistry *sets, FILE *input, boolean isBatch);
 
 /**
  * Prints an explanation of the program.
@@ -33,32 +75,42 @@ void readInput(setptr sets[]);
 void printExplanation();
 
 /**
- * Initializes the array containing all the sets.
+ * Loads the saved state given on the command line (if any) into the registry of sets.
+ * Exits the program if the file is not a valid saved state.
+ *
+ * @param sets The registry of sets.
+ * @param programOptions The options the program has been run with.
+ */
+void loadStartingState(setregistry *sets, const options *programOptions);
+
+/**
+ * Writes text to the standard output (the output sink of the program's calculator).
  *
- * @param sets An array of sets to populate.
- * @param setA The first set.
- * @param setB The second set.
- * @param setC The third set.
- * @param setD The fourth set.
- * @param setE The fifth set.
- * @param setF The sixth set.
+ * @param data Not used.
+ * @param text The text to write.
+ * @param length The number of characters to write.
  */
-void initializeSets(setptr sets[], set setA, set setB, set setC, set setD, set setE, set setF);
+void writeStandardOutput(void *data, const char text[], size_t length);
 
 /**
- * Resets all the sets in the given set array.
- * Sets every section of every set to 0.
+ * Writes text to the standard error (the error sink of the program's calculator).
  *
- * @param sets An array of sets.
+ * @param data Not used.
+ * @param text The text to write.
+ * @param length The number of characters to write.
  */
-void resetSets(setptr sets[]);
+void writeStandardError(void *data, const char text[], size_t length);
 
 /**
- * Reads and returns a line as input from the user.
+ * Reads and returns the start of a line as input from the user (at most LINE_PREFIX_LENGTH characters, unless the whole line has already been read).
+ * The rest of a longer line is left in the reader, to be read with finishLine or nextLinePart.
  * Exits the program if an error occurs or if end of file is reached.
  *
- * @return The line as input from the user.
+ * @param reader The reader to read the line from.
+ * @param length Set to the length of the start of the line.
+ * @param isComplete Set to TRUE if the whole line has been read, FALSE otherwise.
+ * @return The start of the line as input from the user (NULL if the line is empty), valid until the next line is read.
  */
-char *readLine();
+char *readLine(linereader *reader, size_t *length, boolean *isComplete);
 
 #endif
@@ -0,0 +1,383 @@
+/*
+ * pipeline.c
+ * Includes the functions which run a script in 3 stages: reading its lines, validating them, and executing them.
+ * The lines move between the stages in a fixed number of slots. Every slot holds a copy of its line along with its instruction,
+ * and the index of the slot is passed on through single-producer, single-consumer rings (reader to validator, validator to executor,
+ * and executor back to reader), so the stages never lock each other out, and the lines are executed in the order they are read.
+ * A stage whose ring is empty yields the processor for a while, and then naps until its ring has an entry.
+ *
+ * Name: Ariel Keren
+ * Course: C Lab, 20465
+ * Semester: 2024B
+ * Date: 18/10/2026
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include "pipeline.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "calculator.h"
+#include "execution.h"
+#include "globals.h"
+#include "lexer.h"
+#include "reader.h"
+#include "stats.h"
+#include "utils.h"
+#include "validation.h"
+
+/* A line on its way through the stages. */
+typedef struct {
+    char *text;               /* A copy of the line (null-terminated), which the instruction refers to. */
+    size_t length;            /* The number of characters in the line (0 for a blank line). */
+    size_t capacity;          /* The number of characters the copy has room for. */
+    unsigned long lineNumber; /* The number of the line. */
+    boolean isEnd;            /* Has the end of the input been reached instead of reading a line? */
+    boolean isValid;          /* Is the line a valid command? */
+    instruction command;      /* The line, compiled into an instruction. */
+    statstimer readTimer;     /* Times reading the line. */
+    statstimer validateTimer; /* Times validating the line. */
+} pipelineslot;
+
+/* Passes the indices of slots from one stage to the next (only a single thread adds to it, and only a single thread takes from it). */
+typedef struct {
+    size_t entries[PIPELINE_SLOTS]; /* The indices of the slots, by their position in the ring. */
+    unsigned long head;             /* The number of entries taken so far (written by the consumer only). */
+    char padding[CACHE_LINE_SIZE];  /* Keeps the two counters apart, so the producer and the consumer do not share a cache line. */
+    unsigned long tail;             /* The number of entries added so far (written by the producer only). */
+} slotring;
+
+/* Everything the stages share. */
+typedef struct {
+    pipelineslot slots[PIPELINE_SLOTS]; /* The slots the lines move in. */
+    slotring lines;                     /* The lines which have been read, waiting to be validated. */
+    slotring commands;                  /* The lines which have been validated, waiting to be executed. */
+    slotring freed;                     /* The slots which have been executed, waiting to be read into. */
+    linereader reader;                  /* Reads the input a block at a time (the reading stage only). */
+    calculator *context;                /* The calculator the lines run in. */
+    unsigned long isStopped;            /* Has the stop command been executed (so the other stages should end)? */
+    pthread_mutex_t lock;               /* Guards the number of owners (and the counters, without atomic operations). */
+    int owners;                         /* The number of threads which still use the pipeline. */
+} pipeline;
+
+/**
+ * Reads a counter which another thread writes (everything written before the counter is visible afterwards).
+ *
+ * @param shared The pipeline.
+ * @param counter The counter to read.
+ * @return The value of the counter.
+ */
+static unsigned long loadCounter(pipeline *shared, unsigned long *counter) {
+#ifdef __GNUC__
+    (void)shared;
+    return __atomic_load_n(counter, __ATOMIC_ACQUIRE);
+#else
+    unsigned long value; /* The value of the counter. */
+
+    pthread_mutex_lock(&shared->lock);
+    value = *counter;
+    pthread_mutex_unlock(&shared->lock);
+    return value;
+#endif
+}
+
+/**
+ * Writes a counter which another thread reads (after everything written before it).
+ *
+ * @param shared The pipeline.
+ * @param counter The counter to write.
+ * @param value The new value of the counter.
+ */
+static void storeCounter(pipeline *shared, unsigned long *counter, unsigned long value) {
+#ifdef __GNUC__
+    (void)shared;
+    __atomic_store_n(counter, value, __ATOMIC_RELEASE);
+#else
+    pthread_mutex_lock(&shared->lock);
+    *counter = value;
+    pthread_mutex_unlock(&shared->lock);
+#endif
+}
+
+/**
+ * Adds the index of a slot to the end of a ring.
+ * There are only as many slots as entries in a ring, so a ring always has room.
+ *
+ * @param shared The pipeline.
+ * @param ring The ring to add to (only the current thread adds to it).
+ * @param index The index of the slot.
+ */
+static void putSlot(pipeline *shared, slotring *ring, size_t index) {
+    ring->entries[ring->tail & (PIPELINE_SLOTS - NEXT_INDEX_DIFFERENCE)] = index;
+    storeCounter(shared, &ring->tail, ring->tail + NEXT_INDEX_DIFFERENCE);
+}
+
+/**
+ * Takes the index of the slot at the front of a ring, waiting until there is one.
+ * Stops waiting if the stop command has been executed (unless the current thread is the one which executes the commands).
+ *
+ * @param shared The pipeline.
+ * @param ring The ring to take from (only the current thread takes from it).
+ * @param isStoppable Should the thread stop waiting once the stop command has been executed?
+ * @param index Set to the index of the slot.
+ * @return TRUE if a slot has been taken, FALSE if the stop command has been executed.
+ */
+static boolean takeSlot(pipeline *shared, slotring *ring, boolean isStoppable, size_t *index) {
+    struct timespec nap; /* The time to nap while the ring is empty. */
+    unsigned spins;      /* The number of times the processor has been yielded so far. */
+
+    spins = STARTING_VALUE;
+    nap.tv_sec = STARTING_VALUE;
+    nap.tv_nsec = PIPELINE_NAP_NANOSECONDS;
+
+    /* Wait until the producer has added an entry after the one taken last. */
+    while (loadCounter(shared, &ring->tail) == ring->head) {
+        if (isStoppable && loadCounter(shared, &shared->isStopped)) {
+            return FALSE;
+        }
+
+        if (spins < PIPELINE_SPINS) {
+            sched_yield();
+            spins++;
+        } else {
+            nanosleep(&nap, NULL);
+        }
+    }
+
+    *index = ring->entries[ring->head & (PIPELINE_SLOTS - NEXT_INDEX_DIFFERENCE)];
+    storeCounter(shared, &ring->head, ring->head + NEXT_INDEX_DIFFERENCE);
+    return TRUE;
+}
+
+/**
+ * Frees the pipeline once the last thread which uses it is done with it.
+ *
+ * @param shared The pipeline.
+ */
+static void leavePipeline(pipeline *shared) {
+    int owners;   /* The number of threads which still use the pipeline. */
+    size_t index; /* Current index in the slots. */
+
+    pthread_mutex_lock(&shared->lock);
+    owners = --shared->owners;
+    pthread_mutex_unlock(&shared->lock);
+
+    if (owners != EMPTY) {
+        return;
+    }
+
+    for (index = FIRST_INDEX; index < PIPELINE_SLOTS; index++) {
+        free(shared->slots[index].text);
+        freeInstruction(&shared->slots[index].command);
+    }
+
+    freeReader(&shared->reader);
+    pthread_mutex_destroy(&shared->lock);
+    free(shared);
+}
+
+/**
+ * Reads the lines of the input into free slots, and passes them on to be validated (runs on its own thread).
+ * Ends once the end of the input has been passed on, or once the stop command has been executed.
+ *
+ * @param data The pipeline.
+ * @return Nothing.
+ */
+static void *readLines(void *data) {
+    pipeline *shared;         /* The pipeline. */
+    pipelineslot *slot;       /* The slot the current line is read into. */
+    size_t index;             /* The index of the slot. */
+    unsigned long lineNumber; /* The number of the current line. */
+    char *line;               /* The current line, in the reader. */
+    size_t length;            /* The length of the current line. */
+    boolean isComplete;       /* Has the whole current line been handed out? */
+    boolean isEnd;            /* Has the end of the input been reached? */
+
+    shared = data;
+    lineNumber = STARTING_VALUE;
+    isEnd = FALSE;
+
+    while (!isEnd && !loadCounter(shared, &shared->isStopped) && takeSlot(shared, &shared->freed, TRUE, &index)) {
+        slot = &shared->slots[index];
+        slot->lineNumber = ++lineNumber;
+        startTimer(&slot->readTimer);
+        isEnd = !nextLine(&shared->reader, LINE_PREFIX_LENGTH, &line, &length, &isComplete);
+
+        /* A long line is read in full, since the slot keeps it until it is executed. */
+        if (!isEnd && !isComplete) {
+            finishLine(&shared->reader, &line, &length);
+        }
+
+        slot->isEnd = isEnd;
+        slot->length = isEnd ? EMPTY : length;
+
+        /* Copy the line, since the reader reuses its memory for the next lines. */
+        if (slot->length >= slot->capacity) {
+            free(slot->text);
+            slot->capacity = slot->length + NEXT_INDEX_DIFFERENCE;
+
+            if ((slot->text = malloc(slot->capacity)) == NULL) {
+                failMemory("Failed to allocate memory for the input.");
+            }
+        }
+
+        memcpy(slot->text, isEnd ? "" : line, slot->length);
+        slot->text[slot->length] = '\0';
+        stopTimer(&slot->readTimer);
+        putSlot(shared, &shared->lines, index);
+    }
+
+    leavePipeline(shared);
+    return NULL;
+}
+
+/**
+ * Validates the lines which have been read, compiles them into their instructions, and passes them on to be executed (runs on its own thread).
+ * Ends once the end of the input has been passed on, or once the stop command has been executed.
+ *
+ * @param data The pipeline.
+ * @return Nothing.
+ */
+static void *validateLines(void *data) {
+    pipeline *shared;   /* The pipeline. */
+    pipelineslot *slot; /* The slot of the current line. */
+    size_t index;       /* The index of the slot. */
+    tokenlist tokens;   /* The tokens of the current line (reused for every line). */
+    boolean isEnd;      /* Has the end of the input been reached? */
+
+    shared = data;
+    isEnd = FALSE;
+    initializeTokenList(&tokens);
+
+    /* Validating reads the size of the universe from the calculator. */
+    useCalculator(shared->context);
+
+    while (!isEnd && takeSlot(shared, &shared->lines, TRUE, &index)) {
+        slot = &shared->slots[index];
+        isEnd = slot->isEnd;
+
+        /* Blank lines are skipped before they are validated. */
+        if (!isEnd && slot->length != EMPTY) {
+            startTimer(&slot->validateTimer);
+            slot->isValid = compileLine(slot->text, slot->length, &tokens, &slot->command);
+            stopTimer(&slot->validateTimer);
+        }
+
+        putSlot(shared, &shared->commands, index);
+    }
+
+    freeTokenList(&tokens);
+    return NULL;
+}
+
+/**
+ * Runs a script in batch mode, the same as readInput, but in 3 stages which work at once:
+ * a thread which reads the lines, a thread which validates them and compiles them into instructions, and the current thread, which executes them in order.
+ * The output (and every error, with its line number) is the same as running the script with readInput.
+ * Exits the program if the end of the input is reached before the stop command, or if a memory allocation fails.
+ *
+ * @param sets The registry of every defined set.
+ * @param input The input to read the commands from.
+ */
+void runPipeline(setregistry *sets, FILE *input) {
+    pipeline *shared;     /* The pipeline. */
+    pipelineslot *slot;   /* The slot of the current line. */
+    size_t index;         /* Current index in the slots (then, the index of the slot of the current line). */
+    boolean isStopped;    /* Is the program stopped? */
+    boolean isCreated;    /* Has everything been allocated so far? */
+    pthread_t reading;    /* The thread which reads the lines. */
+    pthread_t validating; /* The thread which validates the lines. */
+    statstimer timer;     /* Times executing the current line. */
+
+    setBatchMode(TRUE);
+    shared = malloc(sizeof(pipeline));
+    isCreated = shared != NULL && createReader(&shared->reader, input);
+
+    /* Every slot starts out free, with no copy of a line yet. */
+    for (index = FIRST_INDEX; index < PIPELINE_SLOTS && isCreated; index++) {
+        shared->slots[index].text = NULL;
+        shared->slots[index].capacity = EMPTY;
+        isCreated = createInstruction(&shared->slots[index].command);
+        shared->freed.entries[index] = index;
+    }
+
+    if (!isCreated) {
+        /* Exit the program. */
+        fprintf(stderr, "Failed to allocate memory for the input.\n");
+        exit(ERROR);
+    }
+
+    shared->lines.head = shared->lines.tail = shared->commands.head = shared->commands.tail = shared->freed.head = STARTING_VALUE;
+    shared->freed.tail = PIPELINE_SLOTS;
+    shared->context = getCalculator();
+    shared->isStopped = FALSE;
+    shared->owners = PIPELINE_OWNERS;
+    pthread_mutex_init(&shared->lock, NULL);
+
+    if (pthread_create(&reading, NULL, readLines, shared) != SUCCESS || pthread_create(&validating, NULL, validateLines, shared) != SUCCESS) {
+        /* Exit the program. */
+        fprintf(stderr, "Failed to start the pipeline threads.\n");
+        exit(ERROR);
+    }
+
+    isStopped = FALSE;
+
+    /* Execute the lines in the order they have been read, until the program is stopped. */
+    while (!isStopped) {
+        /* Write the statistics if they have been requested during the last command. */
+        checkStatistics();
+        takeSlot(shared, &shared->commands, FALSE, &index);
+        slot = &shared->slots[index];
+        setLineNumber(slot->lineNumber);
+
+        /* Exit the program if the end of file is reached (both other stages end once they pass it on). */
+        if (slot->isEnd) {
+            pthread_join(reading, NULL);
+            pthread_join(validating, NULL);
+            printError("Missing stop command.");
+            exit(ERROR);
+        }
+
+        /* Blank lines are skipped, and invalid lines are reported (lines which are not valid commands are recorded apart from every operation). */
+        if (slot->length != EMPTY) {
+            recordTimer(&slot->readTimer, READ_PHASE, slot->isValid ? slot->command.operation : INVALID_OPERATION);
+            recordTimer(&slot->validateTimer, VALIDATE_PHASE, slot->isValid ? slot->command.operation : INVALID_OPERATION);
+
+            if (!slot->isValid) {
+                if (slot->command.error != NULL) {
+                    printError(slot->command.error);
+                }
+            } else {
+                startTimer(&timer);
+
+                if (executeInstruction(&slot->command, sets)) {
+                    /* Stop the program if the command was stop. */
+                    isStopped = TRUE;
+                }
+
+                stopTimer(&timer);
+                recordTimer(&timer, EXECUTE_PHASE, slot->command.operation);
+
+                /* Check if the command could not be executed (e.g. it refers to a set which is not defined). */
+                if (slot->command.error != NULL) {
+                    printError(slot->command.error);
+                }
+            }
+        }
+
+        /* The slot can be read into again. */
+        putSlot(shared, &shared->freed, index);
+    }
+
+    /* The validating thread only waits for the reading thread, which may be waiting for more input (the pipeline is freed by whichever ends last). */
+    storeCounter(shared, &shared->isStopped, TRUE);
+    pthread_join(validating, NULL);
+    pthread_detach(reading);
+    leavePipeline(shared);
+}
@@ -0,0 +1,29 @@
+/*
+ * pipeline.h
+ * Includes the prototypes of all the functions in pipeline.c.
+ *
+ * Name: Ariel Keren
+ * Course: C Lab, 20465
+ * Semester: 2024B
+ * Date: 18/10/2026
+ */
+
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <stdio.h>
+
+#include "registry.h"
+
+/**
+ * Runs a script in batch mode, the same as readInput, but in 3 stages which work at once:
+ * a thread which reads the lines, a thread which validates them and compiles them into instructions, and the current thread, which executes them in order.
+ * The output (and every error, with its line number) is the same as running the script with readInput.
+ * Exits the program if the end of the input is reached before the stop command, or if a memory allocation fails.
+ *
+ * @param sets The registry of every defined set.
+ * @param input The input to read the commands from.
+ */
+void runPipeline(setregistry *sets, FILE *input);
+
+#endif
@@ -0,0 +1,241 @@
+/*
+ * reader.c
+ * Includes functions for reading input lines a block at a time.
+ * Newlines are found with memchr, and complete lines are handed out in place (the newline is replaced with a null character).
+ * The start of a line which is too long to be kept is held in a separate string, which grows by doubling its capacity.
+ *
+ * Name: Ariel Keren
+ * Course: C Lab, 20465
+ * Semester: 2024B
+ * Date: 18/10/2026
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include "reader.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "calculator.h"
+#include "globals.h"
+
+/**
+ * Reads the next block of the input into the reader.
+ * First, moves the characters which have not been handed out yet (part of a single line) to the start of the block.
+ *
+ * @param reader The reader to read the block into.
+ * @return TRUE if any characters have been read, FALSE if the end of the input has been reached.
+ */
+static boolean fillBlock(linereader *reader) {
+    ssize_t count; /* The number of characters read. */
+
+    if (reader->isEnd) {
+        return FALSE;
+    }
+
+    /* Only a line which straddles two blocks is ever moved. */
+    if (reader->start != FIRST_INDEX) {
+        memmove(reader->block, reader->block + reader->start, reader->end - reader->start);
+        reader->end -= reader->start;
+        reader->start = FIRST_INDEX;
+    }
+
+    /* Read as much as the block has room for (again if interrupted by a signal). */
+    do {
+        count = read(reader->descriptor, reader->block + reader->end, reader->capacity - reader->end);
+    } while (count < EMPTY && errno == EINTR);
+
+    /* An error is treated the same as the end of the input. */
+    if (count <= EMPTY) {
+        reader->isEnd = TRUE;
+        return FALSE;
+    }
+
+    reader->end += count;
+    return TRUE;
+}
+
+/**
+ * Appends characters to the held line, and null-terminates it.
+ * Exits the program if the memory allocation fails.
+ *
+ * @param reader The reader which holds the line.
+ * @param characters The characters to append.
+ * @param count The number of characters to append.
+ * @param length The length of the held line so far.
+ */
+static void holdCharacters(linereader *reader, const char characters[], size_t count, size_t length) {
+    size_t size;  /* The number of characters the held line needs room for. */
+    char *larger; /* The held line with more memory. */
+
+    size = length + count + NEXT_INDEX_DIFFERENCE;
+
+    /* Allocate more memory if necessary. */
+    if (size > reader->heldSize) {
+        while (size > reader->heldSize) {
+            reader->heldSize = reader->heldSize == EMPTY ? INITIAL_SIZE : reader->heldSize * GROWTH_FACTOR;
+        }
+
+        /* Check for an error in the memory allocation. */
+        if ((larger = realloc(reader->held, reader->heldSize * sizeof(char))) == NULL) {
+            failMemory("Failed to allocate memory for the input.");
+        }
+
+        reader->held = larger;
+    }
+
+    memcpy(reader->held + length, characters, count);
+    reader->held[length + count] = '\0';
+}
+
+/**
+ * Creates a reader for the given input.
+ * The input should not be read in any other way afterwards.
+ *
+ * @param reader The reader to create.
+ * @param input The input to read the lines from.
+ * @return TRUE if the reader has been created, FALSE if the memory allocation fails.
+ */
+boolean createReader(linereader *reader, FILE *input) {
+    /* Keep a character for the terminating null character of the last line. */
+    if ((reader->block = malloc((READ_BLOCK_SIZE + NEXT_INDEX_DIFFERENCE) * sizeof(char))) == NULL) {
+        return FALSE;
+    }
+
+    reader->descriptor = fileno(input);
+    reader->capacity = READ_BLOCK_SIZE;
+    reader->start = reader->end = reader->scanned = FIRST_INDEX;
+    reader->isEnd = FALSE;
+    reader->held = NULL;
+    reader->heldSize = EMPTY;
+    return TRUE;
+}
+
+/**
+ * Hands out the next line, without its newline.
+ * A line longer than the given limit is cut at the limit if its end has not been read yet, and the rest of it is left to nextLinePart.
+ * The line is null-terminated, and stays valid until the next call.
+ * Exits the program if the memory allocation fails.
+ *
+ * @param reader The reader to read the line from.
+ * @param limit The number of characters at which to cut a line whose end has not been read yet.
+ * @param line Set to the line (or its start).
+ * @param length Set to the length of the line (or of its start).
+ * @param isComplete Set to TRUE if the whole line has been handed out, FALSE otherwise.
+ * @return TRUE if a line has been handed out, FALSE if the end of the input has been reached.
+ */
+boolean nextLine(linereader *reader, size_t limit, char **line, size_t *length, boolean *isComplete) {
+    char *newline;    /* The newline at the end of the line. */
+    size_t available; /* The number of characters which have not been handed out yet. */
+
+    /* Read the next block until the line ends (or until the end of the input). */
+    do {
+        available = reader->end - reader->start;
+        /* Only look for the newline after the characters which have already been searched. */
+        newline = memchr(reader->block + reader->start + reader->scanned, '\n', available - reader->scanned);
+
+        /* Hand out a complete line in place. */
+        if (newline != NULL) {
+            *newline = '\0';
+            *line = reader->block + reader->start;
+            *length = newline - *line;
+            *isComplete = TRUE;
+            reader->start += *length + NEXT_INDEX_DIFFERENCE;
+            reader->scanned = FIRST_INDEX;
+            return TRUE;
+        }
+
+        reader->scanned = available;
+
+        /* Cut a line which is too long (or which fills the whole block), and hold its start. */
+        if (available >= limit || available == reader->capacity) {
+            *length = available < limit ? available : limit;
+            holdCharacters(reader, reader->block + reader->start, *length, FIRST_INDEX);
+            *line = reader->held;
+            *isComplete = FALSE;
+            reader->start += *length;
+            reader->scanned -= *length;
+            return TRUE;
+        }
+    } while (fillBlock(reader));
+
+    /* Check if there are no more lines. */
+    if (available == EMPTY) {
+        return FALSE;
+    }
+
+    /* The last line has no newline. */
+    reader->block[reader->end] = '\0';
+    *line = reader->block + reader->start;
+    *length = available;
+    *isComplete = TRUE;
+    reader->start = reader->end;
+    reader->scanned = FIRST_INDEX;
+    return TRUE;
+}
+
+/**
+ * Hands out the next characters of a line which has been cut by nextLine (as many as have been read, until the end of the line).
+ * The characters are not null-terminated, and stay valid until the next call.
+ *
+ * @param reader The reader to read the characters from.
+ * @param length Set to the number of characters handed out.
+ * @param isComplete Set to TRUE if the end of the line has been reached, FALSE otherwise.
+ * @return The characters.
+ */
+const char *nextLinePart(linereader *reader, size_t *length, boolean *isComplete) {
+    const char *part; /* The characters handed out. */
+    char *newline;    /* The newline at the end of the line. */
+
+    reader->scanned = FIRST_INDEX;
+
+    /* Read the next block if every character read has been handed out (the end of the input ends the line). */
+    if (reader->start == reader->end && !fillBlock(reader)) {
+        *length = EMPTY;
+        *isComplete = TRUE;
+        return reader->block;
+    }
+
+    part = reader->block + reader->start;
+    newline = memchr(part, '\n', reader->end - reader->start);
+    *isComplete = newline != NULL;
+    *length = *isComplete ? (size_t)(newline - part) : reader->end - reader->start;
+    reader->start += *isComplete ? *length + NEXT_INDEX_DIFFERENCE : *length;
+    return part;
+}
+
+/**
+ * Reads the rest of a line which has been cut by nextLine, and appends it to the start of the line.
+ * Exits the program if the memory allocation fails.
+ *
+ * @param reader The reader to read the rest of the line from.
+ * @param line Set to the whole line (null-terminated, valid until the next call).
+ * @param length The length of the start of the line (set to the length of the whole line).
+ */
+void finishLine(linereader *reader, char **line, size_t *length) {
+    const char *part;   /* The next characters of the line. */
+    size_t partLength;  /* The number of characters in the part. */
+    boolean isComplete; /* Has the end of the line been reached? */
+
+    do {
+        part = nextLinePart(reader, &partLength, &isComplete);
+        holdCharacters(reader, part, partLength, *length);
+        *length += partLength;
+    } while (!isComplete);
+
+    *line = reader->held;
+}
+
+/**
+ * Frees the memory of the reader.
+ *
+ * @param reader The reader to free.
+ */
+void freeReader(linereader *reader) {
+    free(reader->block);
+    free(reader->held);
+}
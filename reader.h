@@ -0,0 +1,87 @@
+/*
+ * reader.h
+ * Includes the prototypes of all the functions in reader.c.
+ *
+ * Input lines are read in large blocks, and handed out in place (as spans of the block) whenever possible.
+ * Only a line which does not fit in what is left of the block is moved, to the start of the block, before the next block is read.
+ *
+ * Name: Ariel Keren
+ * Course: C Lab, 20465
+ * Semester: 2024B
+ * Date: 18/10/2026
+ */
+
+#ifndef READER_H
+#define READER_H
+
+#include <stdio.h>
+
+#include "globals.h"
+
+/* Reads lines from an input, a block at a time. */
+typedef struct {
+    int descriptor;  /* The file descriptor of the input. */
+    char *block;     /* The characters read so far (with room for a terminating null character). */
+    size_t capacity; /* The number of characters the block has room for. */
+    size_t start;    /* The index of the first character which has not been handed out yet. */
+    size_t end;      /* The index after the last character read. */
+    size_t scanned;  /* The number of characters after the start which are known not to be newlines. */
+    boolean isEnd;   /* Has the end of the input been reached? */
+    char *held;      /* A line whose start has been handed out before its end has been read. */
+    size_t heldSize; /* The number of characters the held line has room for. */
+} linereader;
+
+/**
+ * Creates a reader for the given input.
+ * The input should not be read in any other way afterwards.
+ *
+ * @param reader The reader to create.
+ * @param input The input to read the lines from.
+ * @return TRUE if the reader has been created, FALSE if the memory allocation fails.
+ */
+boolean createReader(linereader *reader, FILE *input);
+
+/**
+ * Hands out the next line, without its newline.
+ * A line longer than the given limit is cut at the limit if its end has not been read yet, and the rest of it is left to nextLinePart.
+ * The line is null-terminated, and stays valid until the next call.
+ * Exits the program if the memory allocation fails.
+ *
+ * @param reader The reader to read the line from.
+ * @param limit The number of characters at which to cut a line whose end has not been read yet.
+ * @param line Set to the line (or its start).
+ * @param length Set to the length of the line (or of its start).
+ * @param isComplete Set to TRUE if the whole line has been handed out, FALSE otherwise.
+ * @return TRUE if a line has been handed out, FALSE if the end of the input has been reached.
+ */
+boolean nextLine(linereader *reader, size_t limit, char **line, size_t *length, boolean *isComplete);
+
+/**
+ * Hands out the next characters of a line which has been cut by nextLine (as many as have been read, until the end of the line).
+ * The characters are not null-terminated, and stay valid until the next call.
+ *
+ * @param reader The reader to read the characters from.
+ * @param length Set to the number of characters handed out.
+ * @param isComplete Set to TRUE if the end of the line has been reached, FALSE otherwise.
+ * @return The characters.
+ */
+const char *nextLinePart(linereader *reader, size_t *length, boolean *isComplete);
+
+/**
+ * Reads the rest of a line which has been cut by nextLine, and appends it to the start of the line.
+ * Exits the program if the memory allocation fails.
+ *
+ * @param reader The reader to read the rest of the line from.
+ * @param line Set to the whole line (null-terminated, valid until the next call).
+ * @param length The length of the start of the line (set to the length of the whole line).
+ */
+void finishLine(linereader *reader, char **line, size_t *length);
+
+/**
+ * Frees the memory of the reader.
+ *
+ * @param reader The reader to free.
+ */
+void freeReader(linereader *reader);
+
+#endif
@@ -0,0 +1,316 @@
+/*
+ * registry.c
+ * Includes functions for defining, finding and dropping sets by their names.
+ * Names are hashed once (when their line is compiled), so finding a set only compares the names in its probe sequence.
+ * Dropped sets leave a marker in their slot, so the probe sequences of other sets are not broken.
+ * The markers are cleared whenever the table is rebuilt.
+ *
+ * Name: Ariel Keren
+ * Course: C Lab, 20465
+ * Semester: 2024B
+ * Date: 18/10/2026
+ */
+
+#include "registry.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "globals.h"
+#include "set.h"
+#include "setUtils.h"
+
+/* Marks the slot of a dropped set. */
+static namedset droppedSet;
+
+/**
+ * Fills the set name with the given name and its hash.
+ * The name does not have to be null-terminated, and is not copied.
+ *
+ * @param result The set name to fill.
+ * @param name The name of the set.
+ * @param length The number of characters in the name.
+ */
+void nameSet(setname *result, const char name[], size_t length) {
+    size_t index;       /* Current index in the name. */
+    unsigned long hash; /* The hash of the characters so far (FNV-1a). */
+
+    hash = HASH_OFFSET_BASIS;
+
+    /* Mix every character into the hash. */
+    for (index = FIRST_INDEX; index < length; index++) {
+        hash = (hash ^ (unsigned char)name[index]) * HASH_PRIME;
+    }
+
+    result->name = name;
+    result->length = length;
+    result->hash = hash;
+}
+
+/**
+ * Allocates an empty registry.
+ *
+ * @param registry The registry to allocate.
+ * @return TRUE if the registry has been allocated, FALSE if the memory allocation failed.
+ */
+boolean createRegistry(setregistry *registry) {
+    registry->count = STARTING_VALUE;
+    registry->used = STARTING_VALUE;
+    registry->slots = calloc(INITIAL_REGISTRY_CAPACITY, sizeof(namedset *));
+    /* A registry which could not be allocated has no slots, so it can still be freed. */
+    registry->capacity = registry->slots == NULL ? EMPTY : INITIAL_REGISTRY_CAPACITY;
+    return registry->slots != NULL;
+}
+
+/**
+ * Frees the memory used by the registry, including every set in it.
+ *
+ * @param registry The registry to free.
+ */
+void freeRegistry(setregistry *registry) {
+    size_t index; /* Current index in the table. */
+
+    /* Free every set in the table. */
+    for (index = FIRST_INDEX; index < registry->capacity; index++) {
+        if (registry->slots[index] != NULL && registry->slots[index] != &droppedSet) {
+            freeSet(&registry->slots[index]->members);
+            free(registry->slots[index]);
+        }
+    }
+
+    free(registry->slots);
+    registry->slots = NULL;
+    registry->capacity = registry->count = registry->used = STARTING_VALUE;
+}
+
+/**
+ * Finds the slot of the set with the given name.
+ * Also finds the first slot the set could be put in, if it is not in the table.
+ *
+ * @param registry The registry to search in.
+ * @param target The name of the set.
+ * @param freeSlot Receives the first slot in the probe sequence which is empty or marks a dropped set.
+ * @return The index of the set's slot, or the capacity of the table if the set is not in it.
+ */
+static size_t findSlot(const setregistry *registry, const setname *target, size_t *freeSlot) {
+    size_t mask;             /* Used to wrap the probe sequence around the table. */
+    size_t index;            /* Current index in the probe sequence. */
+    const namedset *current; /* The set in the current slot. */
+
+    mask = registry->capacity - NEXT_INDEX_DIFFERENCE;
+    *freeSlot = registry->capacity;
+
+    /* Probe the slots one by one, until an empty slot is reached (the table is never full). */
+    for (index = target->hash & mask; (current = registry->slots[index]) != NULL; index = (index + NEXT_INDEX_DIFFERENCE) & mask) {
+        /* Remember the first dropped set's slot, so it can be reused. */
+        if (current == &droppedSet) {
+            if (*freeSlot == registry->capacity) {
+                *freeSlot = index;
+            }
+
+            continue;
+        }
+
+        /* Compare the names only if their hashes match. */
+        if (current->hash == target->hash && current->length == target->length && !memcmp(current->name, target->name, target->length)) {
+            return index;
+        }
+    }
+
+    if (*freeSlot == registry->capacity) {
+        *freeSlot = index;
+    }
+
+    return registry->capacity;
+}
+
+/**
+ * Rebuilds the table, clearing the markers of dropped sets.
+ * Doubles the number of slots if the table is at least half full of sets.
+ *
+ * @param registry The registry to rebuild.
+ * @return TRUE if the table has been rebuilt, FALSE if the memory allocation failed.
+ */
+static boolean rebuildRegistry(setregistry *registry) {
+    size_t capacity;  /* The number of slots in the rebuilt table. */
+    namedset **slots; /* The slots of the rebuilt table. */
+    size_t index;     /* Current index in the previous table. */
+    size_t slot;      /* Current index in the rebuilt table. */
+
+    capacity = registry->count * GROWTH_FACTOR >= registry->capacity ? registry->capacity * GROWTH_FACTOR : registry->capacity;
+    slots = calloc(capacity, sizeof(namedset *));
+
+    if (slots == NULL) {
+        return FALSE;
+    }
+
+    /* Move every set to its first empty slot in the rebuilt table. */
+    for (index = FIRST_INDEX; index < registry->capacity; index++) {
+        if (registry->slots[index] == NULL || registry->slots[index] == &droppedSet) {
+            continue;
+        }
+
+        slot = registry->slots[index]->hash & (capacity - NEXT_INDEX_DIFFERENCE);
+
+        while (slots[slot] != NULL) {
+            slot = (slot + NEXT_INDEX_DIFFERENCE) & (capacity - NEXT_INDEX_DIFFERENCE);
+        }
+
+        slots[slot] = registry->slots[index];
+    }
+
+    free(registry->slots);
+    registry->slots = slots;
+    registry->capacity = capacity;
+    registry->used = registry->count;
+    return TRUE;
+}
+
+/**
+ * Returns the entry of the set with the given name.
+ *
+ * @param registry The registry to search in.
+ * @param target The name of the set.
+ * @return The entry of the set with the given name, or NULL if there is none.
+ */
+namedset *findEntry(const setregistry *registry, const setname *target) {
+    size_t index;    /* The index of the set's slot. */
+    size_t freeSlot; /* The first free slot in the probe sequence (unused). */
+
+    index = findSlot(registry, target, &freeSlot);
+    return index == registry->capacity ? NULL : registry->slots[index];
+}
+
+/**
+ * Returns the entry of the set with the given name, creating it (with an empty set) if there is none.
+ *
+ * @param registry The registry to search in.
+ * @param target The name of the set.
+ * @return The entry of the set with the given name, or NULL if the memory allocation failed.
+ */
+namedset *defineEntry(setregistry *registry, const setname *target) {
+    size_t index;      /* The index of the set's slot. */
+    size_t freeSlot;   /* The first free slot in the probe sequence. */
+    namedset *created; /* The set, if it has to be created. */
+
+    index = findSlot(registry, target, &freeSlot);
+
+    /* Check if the set already exists. */
+    if (index != registry->capacity) {
+        return registry->slots[index];
+    }
+
+    /* Rebuild the table before it becomes too full (so probe sequences stay short). */
+    if ((registry->used + NEXT_INDEX_DIFFERENCE) * MAXIMUM_LOAD_DENOMINATOR > registry->capacity * MAXIMUM_LOAD_NUMERATOR) {
+        if (!rebuildRegistry(registry)) {
+            return NULL;
+        }
+
+        findSlot(registry, target, &freeSlot);
+    }
+
+    /* Allocate the set along with its name. */
+    created = malloc(sizeof(namedset) + target->length + NEXT_INDEX_DIFFERENCE);
+
+    if (created == NULL) {
+        return NULL;
+    }
+
+    if (!createSet(&created->members)) {
+        free(created);
+        return NULL;
+    }
+
+    created->name = (char *)(created + NEXT_INDEX_DIFFERENCE);
+    memcpy(created->name, target->name, target->length);
+    created->name[target->length] = '\0';
+    created->length = target->length;
+    created->hash = target->hash;
+    created->generation = EMPTY_GENERATION;
+    created->latest = NULL;
+
+    /* Only an empty slot adds to the used slots (a dropped set's slot is already counted). */
+    if (registry->slots[freeSlot] == NULL) {
+        registry->used++;
+    }
+
+    registry->slots[freeSlot] = created;
+    registry->count++;
+    return created;
+}
+
+/**
+ * Returns the set with the given name.
+ *
+ * @param registry The registry to search in.
+ * @param target The name of the set.
+ * @return The set with the given name, or NULL if there is none.
+ */
+set *findSet(const setregistry *registry, const setname *target) {
+    namedset *found; /* The entry of the set. */
+
+    found = findEntry(registry, target);
+    return found == NULL ? NULL : &found->members;
+}
+
+/**
+ * Returns the set with the given name, creating it (empty) if there is none.
+ *
+ * @param registry The registry to search in.
+ * @param target The name of the set.
+ * @return The set with the given name, or NULL if the memory allocation failed.
+ */
+set *defineSet(setregistry *registry, const setname *target) {
+    namedset *defined; /* The entry of the set. */
+
+    defined = defineEntry(registry, target);
+    return defined == NULL ? NULL : &defined->members;
+}
+
+/**
+ * Returns the next set in the registry, starting from the given slot (used to visit every set, in no particular order).
+ *
+ * @param registry The registry to visit the sets of.
+ * @param slot The slot to start from (0 for the first set). Receives the slot after the returned set's slot.
+ * @return The entry of the next set, or NULL if there are no more sets.
+ */
+namedset *nextEntry(const setregistry *registry, size_t *slot) {
+    namedset *current; /* The set in the current slot. */
+
+    /* Skip the empty slots and the slots of dropped sets. */
+    while (*slot < registry->capacity) {
+        current = registry->slots[(*slot)++];
+
+        if (current != NULL && current != &droppedSet) {
+            return current;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Removes the set with the given name from the registry and frees it.
+ *
+ * @param registry The registry to remove the set from.
+ * @param target The name of the set.
+ * @return TRUE if the set has been removed, FALSE if there is no set with the given name.
+ */
+boolean dropSet(setregistry *registry, const setname *target) {
+    size_t index;    /* The index of the set's slot. */
+    size_t freeSlot; /* The first free slot in the probe sequence (unused). */
+
+    index = findSlot(registry, target, &freeSlot);
+
+    /* Check if the set does not exist. */
+    if (index == registry->capacity) {
+        return FALSE;
+    }
+
+    /* Free the set and mark its slot. */
+    freeSet(&registry->slots[index]->members);
+    free(registry->slots[index]);
+    registry->slots[index] = &droppedSet;
+    registry->count--;
+    return TRUE;
+}
@@ -0,0 +1,127 @@
+/*
+ * registry.h
+ * Includes the prototypes of all the functions in registry.c.
+ * Also, includes the types of the set registry, which maps every set name to its set.
+ *
+ * The registry is an open-addressing hash table (with linear probing) of pointers to named sets.
+ * Every set is allocated separately, so pointers to sets stay valid while the table grows.
+ *
+ * Name: Ariel Keren
+ * Course: C Lab, 20465
+ * Semester: 2024B
+ * Date: 18/10/2026
+ */
+
+#ifndef REGISTRY_H
+#define REGISTRY_H
+
+#include <stddef.h>
+
+#include "globals.h"
+#include "set.h"
+
+/* The name of a set, as it appears in an input line, along with its precomputed hash. */
+typedef struct {
+    const char *name;   /* The first character of the name (not null-terminated). */
+    size_t length;      /* The number of characters in the name. */
+    unsigned long hash; /* The hash of the name. */
+} setname;
+
+/* A set along with its name. */
+typedef struct {
+    char *name;                /* The name of the set (null-terminated, allocated along with the set). */
+    size_t length;             /* The number of characters in the name. */
+    unsigned long hash;        /* The hash of the name. */
+    set members;               /* The members of the set. */
+    unsigned long generation;  /* Identifies the current members of the set (the identifier of the version they were computed as). */
+    struct setversion *latest; /* The latest version of the set in the command graph (NULL if the members are up to date). */
+} namedset;
+
+/* Every set which has been defined, by its name. */
+typedef struct {
+    namedset **slots; /* The slots of the table (NULL for empty slots). */
+    size_t capacity;  /* The number of slots (always a power of 2). */
+    size_t count;     /* The number of sets in the table. */
+    size_t used;      /* The number of slots which are not empty (sets and dropped sets). */
+} setregistry;
+
+/**
+ * Fills the set name with the given name and its hash.
+ * The name does not have to be null-terminated, and is not copied.
+ *
+ * @param result The set name to fill.
+ * @param name The name of the set.
+ * @param length The number of characters in the name.
+ */
+void nameSet(setname *result, const char name[], size_t length);
+
+/**
+ * Allocates an empty registry.
+ *
+ * @param registry The registry to allocate.
+ * @return TRUE if the registry has been allocated, FALSE if the memory allocation failed.
+ */
+boolean createRegistry(setregistry *registry);
+
+/**
+ * Frees the memory used by the registry, including every set in it.
+ *
+ * @param registry The registry to free.
+ */
+void freeRegistry(setregistry *registry);
+
+/**
+ * Returns the entry of the set with the given name.
+ *
+ * @param registry The registry to search in.
+ * @param target The name of the set.
+ * @return The entry of the set with the given name, or NULL if there is none.
+ */
+namedset *findEntry(const setregistry *registry, const setname *target);
+
+/**
+ * Returns the entry of the set with the given name, creating it (with an empty set) if there is none.
+ *
+ * @param registry The registry to search in.
+ * @param target The name of the set.
+ * @return The entry of the set with the given name, or NULL if the memory allocation failed.
+ */
+namedset *defineEntry(setregistry *registry, const setname *target);
+
+/**
+ * Returns the set with the given name.
+ *
+ * @param registry The registry to search in.
+ * @param target The name of the set.
+ * @return The set with the given name, or NULL if there is none.
+ */
+set *findSet(const setregistry *registry, const setname *target);
+
+/**
+ * Returns the set with the given name, creating it (empty) if there is none.
+ *
+ * @param registry The registry to search in.
+ * @param target The name of the set.
+ * @return The set with the given name, or NULL if the memory allocation failed.
+ */
+set *defineSet(setregistry *registry, const setname *target);
+
+/**
+ * Returns the next set in the registry, starting from the given slot (used to visit every set, in no particular order).
+ *
+ * @param registry The registry to visit the sets of.
+ * @param slot The slot to start from (0 for the first set). Receives the slot after the returned set's slot.
+ * @return The entry of the next set, or NULL if there are no more sets.
+ */
+namedset *nextEntry(const setregistry *registry, size_t *slot);
+
+/**
+ * Removes the set with the given name from the registry and frees it.
+ *
+ * @param registry The registry to remove the set from.
+ * @param target The name of the set.
+ * @return TRUE if the set has been removed, FALSE if there is no set with the given name.
+ */
+boolean dropSet(setregistry *registry, const setname *target);
+
+#endif
@@ -0,0 +1,797 @@
+/*
+ * server.c
+ * Includes the functions of the server mode, which runs the commands of many clients at once over a Unix domain socket.
+ * Every client (a session) has its own calculator, so no client ever sees the sets of another one.
+ * The main thread accepts the connections, receives the commands and sends the output, without ever waiting for a single client.
+ * A fixed pool of worker threads runs the commands, a session at a time, and moves on to the next session after SESSION_TURN_LINES lines.
+ * A session whose output is not read fast enough stops running commands (and then stops being read) until its client catches up.
+ *
+ * Name: Ariel Keren
+ * Course: C Lab, 20465
+ * Semester: 2024B
+ * Date: 18/10/2026
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include "server.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "calculator.h"
+#include "globals.h"
+#include "mysetUtils.h"
+
+/* Text received from a client, or waiting to be sent to it. */
+typedef struct {
+    char *text;      /* The characters (NULL until the first ones arrive). */
+    size_t start;    /* The index of the first character which has not been used yet. */
+    size_t length;   /* The number of characters which have not been used yet. */
+    size_t capacity; /* The number of characters there is memory for. */
+} sessionbuffer;
+
+/* A connection to a client, along with its own calculator. */
+typedef struct session {
+    int socket;           /* The connection to the client. */
+    calculator *context;  /* Everything the commands of the client change. */
+    pthread_mutex_t lock; /* Guards every field below. */
+    sessionbuffer input;  /* The commands which have been received, and not run yet. */
+    sessionbuffer output; /* The output of the commands which has not been sent yet. */
+    size_t lines;         /* The number of complete lines in the input. */
+    boolean isQueued;     /* Is the session waiting for a worker, or being run by one? */
+    boolean isEnded;      /* Has the client shut down its side of the connection? */
+    boolean isFinished;   /* Are no more commands run (after stop, the end of the input, or a failed memory allocation)? */
+    boolean isBroken;     /* Has the connection failed (so the output is thrown away)? */
+    struct session *next; /* The next session in the queue of the workers. */
+} session;
+
+/* Everything the threads of the server share. */
+typedef struct {
+    pthread_mutex_t lock;     /* Guards the queue and isStopping (taken after the lock of a session, never before it). */
+    pthread_cond_t isWaiting; /* Signalled when a session is queued, or when the server stops. */
+    session *first;           /* The first session in the queue of the workers (NULL if none). */
+    session *last;            /* The last session in the queue of the workers. */
+    boolean isStopping;       /* Should the workers stop? */
+    int wakeup[PIPE_ENDS];    /* Written to by the workers (and by the signal handler), so the main thread stops waiting. */
+    const char *statePath;    /* The saved state every session starts from (NULL for none). */
+    long universe;            /* The number of potential members in every set. */
+} serverstate;
+
+/* Has SIGINT or SIGTERM been received? */
+static volatile sig_atomic_t isInterrupted = FALSE;
+/* The end of the wakeup pipe the signal handler writes to. */
+static int interruptDescriptor = INVALID_DESCRIPTOR;
+
+/**
+ * Marks that the server should stop, and wakes the main thread (the handler of SIGINT and SIGTERM).
+ *
+ * @param signalNumber The signal which has been received.
+ */
+static void requestStop(int signalNumber) {
+    (void)signalNumber;
+    isInterrupted = TRUE;
+
+    /* A full pipe is already enough to wake the main thread. */
+    if (write(interruptDescriptor, WAKEUP_TEXT, SINGLE_CHARACTER) < EMPTY) {
+        return;
+    }
+}
+
+/**
+ * Wakes the main thread, so it checks every session again.
+ *
+ * @param server The server.
+ */
+static void wakeServer(serverstate *server) {
+    /* A full pipe is already enough to wake the main thread. */
+    if (write(server->wakeup[WRITE_END], WAKEUP_TEXT, SINGLE_CHARACTER) < EMPTY) {
+        return;
+    }
+}
+
+/**
+ * Makes room for more characters at the end of a buffer.
+ * First, moves the characters which have not been used yet to the start of the buffer. Then, doubles its capacity if necessary.
+ *
+ * @param buffer The buffer.
+ * @param count The number of characters to make room for.
+ * @return TRUE if there is room, FALSE if the memory allocation failed.
+ */
+static boolean reserveText(sessionbuffer *buffer, size_t count) {
+    size_t capacity; /* The new capacity of the buffer. */
+    char *larger;    /* The buffer with more memory. */
+
+    if (buffer->start + buffer->length + count <= buffer->capacity) {
+        return TRUE;
+    }
+
+    /* Only the characters which have not been used yet are kept. */
+    if (buffer->start != FIRST_INDEX) {
+        memmove(buffer->text, buffer->text + buffer->start, buffer->length);
+        buffer->start = FIRST_INDEX;
+    }
+
+    if (buffer->length + count <= buffer->capacity) {
+        return TRUE;
+    }
+
+    capacity = buffer->capacity == EMPTY ? SESSION_READ_SIZE : buffer->capacity;
+
+    while (buffer->length + count > capacity) {
+        capacity *= GROWTH_FACTOR;
+    }
+
+    /* Check for an error in the memory allocation. */
+    if ((larger = realloc(buffer->text, capacity)) == NULL) {
+        return FALSE;
+    }
+
+    buffer->text = larger;
+    buffer->capacity = capacity;
+    return TRUE;
+}
+
+/**
+ * Adds text to the output of a session (the output sink and the error sink of its calculator).
+ * If the memory allocation fails, the text is lost and the session is finished.
+ *
+ * @param data The session.
+ * @param text The text to add.
+ * @param length The number of characters to add.
+ */
+static void writeToSession(void *data, const char text[], size_t length) {
+    session *client; /* The session the text is written to. */
+
+    client = data;
+    pthread_mutex_lock(&client->lock);
+
+    if (reserveText(&client->output, length)) {
+        memcpy(client->output.text + client->output.start + client->output.length, text, length);
+        client->output.length += length;
+    } else {
+        client->isFinished = TRUE;
+    }
+
+    pthread_mutex_unlock(&client->lock);
+}
+
+/**
+ * Checks if a session has commands a worker could run right now.
+ * Assumes the lock of the session is held.
+ *
+ * @param client The session.
+ * @return TRUE if the session has a command to run (or the end of its input to report), FALSE otherwise.
+ */
+static boolean isRunnable(const session *client) {
+    return !client->isFinished && client->output.length < SESSION_OUTPUT_LIMIT && (client->lines != EMPTY || client->isEnded);
+}
+
+/**
+ * Adds a session to the end of the queue of the workers, and wakes one of them.
+ * Assumes the lock of the session is held, and that the session has been marked as queued.
+ *
+ * @param server The server.
+ * @param client The session.
+ */
+static void pushSession(serverstate *server, session *client) {
+    pthread_mutex_lock(&server->lock);
+    client->next = NULL;
+
+    if (server->first == NULL) {
+        server->first = client;
+    } else {
+        server->last->next = client;
+    }
+
+    server->last = client;
+    pthread_cond_signal(&server->isWaiting);
+    pthread_mutex_unlock(&server->lock);
+}
+
+/**
+ * Queues a session for the workers if it has commands to run and it is not queued already.
+ * Assumes the lock of the session is held.
+ *
+ * @param server The server.
+ * @param client The session.
+ */
+static void queueSession(serverstate *server, session *client) {
+    if (!client->isQueued && isRunnable(client)) {
+        client->isQueued = TRUE;
+        pushSession(server, client);
+    }
+}
+
+/**
+ * Takes the next line out of the input of a session, and copies it (without its newline character) to the given line.
+ * A last line without a newline character is only taken once the client has shut down its side of the connection.
+ * Assumes the lock of the session is held.
+ *
+ * @param client The session.
+ * @param line The line to copy to (grows as necessary).
+ * @param capacity The number of characters there is memory for in the line.
+ * @param length Set to the length of the line.
+ * @return TRUE if a line has been taken, FALSE if there is none, or the session should not run any more commands right now.
+ */
+static boolean takeLine(session *client, char **line, size_t *capacity, size_t *length) {
+    char *start;   /* The start of the line in the input. */
+    char *newline; /* The end of the line in the input (NULL for a last line without one). */
+    size_t size;   /* The new capacity of the line. */
+    char *larger;  /* The line with more memory. */
+
+    if (client->isFinished || client->output.length >= SESSION_OUTPUT_LIMIT || (client->lines == EMPTY && (!client->isEnded || client->input.length == EMPTY))) {
+        return FALSE;
+    }
+
+    start = client->input.text + client->input.start;
+    newline = client->lines == EMPTY ? NULL : memchr(start, '\n', client->input.length);
+    *length = newline == NULL ? client->input.length : (size_t)(newline - start);
+
+    /* Allocate more memory if necessary. */
+    if (*length > *capacity) {
+        size = *capacity == EMPTY ? INITIAL_SIZE : *capacity;
+
+        while (*length > size) {
+            size *= GROWTH_FACTOR;
+        }
+
+        /* Check for an error in the memory allocation. */
+        if ((larger = realloc(*line, size)) == NULL) {
+            client->isFinished = TRUE;
+            return FALSE;
+        }
+
+        *line = larger;
+        *capacity = size;
+    }
+
+    memcpy(*line, start, *length);
+
+    /* The newline character is used up along with the line. */
+    if (newline != NULL) {
+        client->lines--;
+        client->input.start += *length + NEXT_INDEX_DIFFERENCE;
+        client->input.length -= *length + NEXT_INDEX_DIFFERENCE;
+    } else {
+        client->input.start = FIRST_INDEX;
+        client->input.length = EMPTY;
+    }
+
+    return TRUE;
+}
+
+/**
+ * Runs the next lines of a session (a worker's turn on it), up to SESSION_TURN_LINES of them.
+ * Then, queues the session again if it still has commands to run, and wakes the main thread so it sends the output.
+ *
+ * @param server The server.
+ * @param client The session.
+ * @param line The line the worker copies every command to (grows as necessary).
+ * @param capacity The number of characters there is memory for in the line.
+ */
+static void runSession(serverstate *server, session *client, char **line, size_t *capacity) {
+    size_t length; /* The length of the current line. */
+    int result;    /* The result of the current line. */
+    int count;     /* The number of lines which have been run in this turn. */
+
+    pthread_mutex_lock(&client->lock);
+
+    for (count = STARTING_VALUE; count < SESSION_TURN_LINES && takeLine(client, line, capacity, &length); count++) {
+        /* The output of the line is added to the session as it is printed. */
+        pthread_mutex_unlock(&client->lock);
+        result = executeLine(client->context, *line, length);
+        pthread_mutex_lock(&client->lock);
+
+        /* The session ends with stop, and a calculator whose memory has run out can only be freed. */
+        if (result == CALCULATOR_STOPPED || result == CALCULATOR_OUT_OF_MEMORY) {
+            client->isFinished = TRUE;
+        }
+    }
+
+    /* A session which reaches the end of its input without stop gets the same error as a script. */
+    if (!client->isFinished && client->isEnded && client->lines == EMPTY && client->input.length == EMPTY) {
+        client->isFinished = TRUE;
+        pthread_mutex_unlock(&client->lock);
+        reportMissingStop(client->context);
+        pthread_mutex_lock(&client->lock);
+    }
+
+    /* The session goes to the end of the queue, so every other session gets a turn first. */
+    if (isRunnable(client)) {
+        pushSession(server, client);
+    } else {
+        client->isQueued = FALSE;
+    }
+
+    pthread_mutex_unlock(&client->lock);
+    wakeServer(server);
+}
+
+/**
+ * Runs sessions from the queue until the server stops (the function of every worker thread).
+ *
+ * @param data The server.
+ * @return NULL.
+ */
+static void *runWorker(void *data) {
+    serverstate *server; /* The server. */
+    session *client;     /* The session which is run. */
+    char *line;          /* The current line of the session (reused for every line). */
+    size_t capacity;     /* The number of characters there is memory for in the line. */
+
+    server = data;
+    line = NULL;
+    capacity = EMPTY;
+    pthread_mutex_lock(&server->lock);
+
+    while (!server->isStopping) {
+        /* Wait for a session to run. */
+        if (server->first == NULL) {
+            pthread_cond_wait(&server->isWaiting, &server->lock);
+            continue;
+        }
+
+        client = server->first;
+        server->first = client->next;
+        pthread_mutex_unlock(&server->lock);
+        runSession(server, client, &line, &capacity);
+        pthread_mutex_lock(&server->lock);
+    }
+
+    pthread_mutex_unlock(&server->lock);
+    free(line);
+    return NULL;
+}
+
+/**
+ * Allocates a session for a new connection, with its own calculator (starting from the saved state, if any).
+ * If the state cannot be loaded, the session only sends the error to the client.
+ *
+ * @param server The server.
+ * @param connection The connection to the client.
+ * @return The session, or NULL if the memory allocation failed.
+ */
+static session *openSession(serverstate *server, int connection) {
+    session *client;                                    /* The new session. */
+    const char *error;                                  /* The reason the saved state could not be loaded. */
+    char text[ERROR_TEXT_LENGTH + ERROR_PREFIX_LENGTH]; /* The error, as it is sent to the client. */
+
+    if ((client = malloc(sizeof(session))) == NULL) {
+        return NULL;
+    }
+
+    client->socket = connection;
+    client->input.text = NULL;
+    client->input.start = client->input.length = client->input.capacity = EMPTY;
+    client->output = client->input;
+    client->lines = EMPTY;
+    client->isQueued = client->isEnded = client->isFinished = client->isBroken = FALSE;
+    client->next = NULL;
+
+    /* Both the printed sets and the errors go to the client, in order. */
+    if ((client->context = createCalculator(server->universe, writeToSession, writeToSession, client)) == NULL) {
+        free(client);
+        return NULL;
+    }
+
+    pthread_mutex_init(&client->lock, NULL);
+
+    if (server->statePath != NULL && (error = loadCalculatorState(client->context, server->statePath)) != NULL) {
+        sprintf(text, "Error: Failed to load the state: %.*s\n", ERROR_TEXT_LENGTH, error);
+        writeToSession(client, text, strlen(text));
+        client->isFinished = TRUE;
+    }
+
+    return client;
+}
+
+/**
+ * Closes the connection of a session, and frees it (along with its calculator).
+ * Assumes no worker runs the session.
+ *
+ * @param client The session.
+ */
+static void closeSession(session *client) {
+    close(client->socket);
+    freeCalculator(client->context);
+    pthread_mutex_destroy(&client->lock);
+    free(client->input.text);
+    free(client->output.text);
+    free(client);
+}
+
+/**
+ * Marks that the connection of a session has failed: its output is thrown away, and no more commands are run.
+ * Assumes the lock of the session is held.
+ *
+ * @param client The session.
+ */
+static void breakSession(session *client) {
+    client->isBroken = client->isEnded = client->isFinished = TRUE;
+    client->output.start = client->output.length = EMPTY;
+}
+
+/**
+ * Receives the commands a client has sent, and queues its session if it has a complete line.
+ *
+ * @param server The server.
+ * @param client The session.
+ */
+static void receiveInput(serverstate *server, session *client) {
+    ssize_t count; /* The number of characters received. */
+    char *start;   /* The first character received. */
+    char *end;     /* The end of the received characters. */
+
+    pthread_mutex_lock(&client->lock);
+
+    /* A session which runs out of memory for its input is ended the same way as a failed connection. */
+    if (!reserveText(&client->input, SESSION_READ_SIZE)) {
+        breakSession(client);
+        pthread_mutex_unlock(&client->lock);
+        return;
+    }
+
+    start = client->input.text + client->input.start + client->input.length;
+
+    do {
+        count = read(client->socket, start, client->input.capacity - client->input.start - client->input.length);
+    } while (count < EMPTY && errno == EINTR);
+
+    if (count > EMPTY) {
+        client->input.length += count;
+
+        /* Count the complete lines which have been received. */
+        for (end = start + count; (start = memchr(start, '\n', end - start)) != NULL; start++) {
+            client->lines++;
+        }
+    } else if (count == EMPTY) {
+        client->isEnded = TRUE;
+    } else if (errno != EAGAIN && errno != EWOULDBLOCK) {
+        breakSession(client);
+    }
+
+    queueSession(server, client);
+    pthread_mutex_unlock(&client->lock);
+}
+
+/**
+ * Sends as much of the output of a session as the connection takes right now.
+ * Queues the session again if its output had paused its commands, and has now been sent.
+ *
+ * @param server The server.
+ * @param client The session.
+ */
+static void sendOutput(serverstate *server, session *client) {
+    ssize_t count; /* The number of characters sent. */
+
+    pthread_mutex_lock(&client->lock);
+
+    do {
+        count = write(client->socket, client->output.text + client->output.start, client->output.length);
+    } while (count < EMPTY && errno == EINTR);
+
+    if (count > EMPTY) {
+        client->output.start += count;
+        client->output.length -= count;
+
+        if (client->output.length == EMPTY) {
+            client->output.start = FIRST_INDEX;
+        }
+    } else if (errno != EAGAIN && errno != EWOULDBLOCK) {
+        breakSession(client);
+    }
+
+    queueSession(server, client);
+    pthread_mutex_unlock(&client->lock);
+}
+
+/**
+ * Makes a descriptor non-blocking.
+ *
+ * @param descriptor The descriptor.
+ * @return TRUE if the descriptor is non-blocking, FALSE otherwise.
+ */
+static boolean setNonBlocking(int descriptor) {
+    int flags; /* The flags of the descriptor. */
+
+    return (flags = fcntl(descriptor, F_GETFL)) >= EMPTY && fcntl(descriptor, F_SETFL, flags | O_NONBLOCK) >= EMPTY;
+}
+
+/**
+ * Creates the Unix domain socket the server listens on.
+ * Prints an error if the socket could not be created (e.g. the path is already in use).
+ *
+ * @param path The path of the socket.
+ * @return The descriptor of the socket, or INVALID_DESCRIPTOR if it could not be created.
+ */
+static int openListener(const char path[]) {
+    struct sockaddr_un address; /* The address of the socket. */
+    int listener;               /* The socket. */
+
+    if (strlen(path) >= sizeof(address.sun_path)) {
+        fprintf(stderr, "Error: The socket path %s is too long.\n", path);
+        return INVALID_DESCRIPTOR;
+    }
+
+    memset(&address, EMPTY, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, path);
+
+    if ((listener = socket(AF_UNIX, SOCK_STREAM, EMPTY)) < EMPTY) {
+        fprintf(stderr, "Error: Failed to create the socket %s: %s\n", path, strerror(errno));
+        return INVALID_DESCRIPTOR;
+    }
+
+    /* An existing file is never replaced (a socket left by a server which has not stopped cleanly should be removed by hand). */
+    if (bind(listener, (struct sockaddr *)&address, sizeof(address)) < EMPTY || listen(listener, SERVER_BACKLOG) < EMPTY || !setNonBlocking(listener)) {
+        fprintf(stderr, "Error: Failed to listen on the socket %s: %s\n", path, strerror(errno));
+        close(listener);
+        return INVALID_DESCRIPTOR;
+    }
+
+    return listener;
+}
+
+/**
+ * Returns the number of worker threads to run: the number given on the command line, or one for every processor.
+ *
+ * @param programOptions The options the program has been run with.
+ * @return The number of worker threads.
+ */
+static long countWorkers(const options *programOptions) {
+    long processors; /* The number of processors which are online. */
+
+    if (programOptions->workers != DEFAULT_WORKERS) {
+        return programOptions->workers;
+    }
+
+#ifdef _SC_NPROCESSORS_ONLN
+    processors = sysconf(_SC_NPROCESSORS_ONLN);
+#else
+    processors = FALLBACK_WORKERS;
+#endif
+
+    if (processors < MINIMUM_WORKERS) {
+        return FALLBACK_WORKERS;
+    }
+
+    return processors < MAXIMUM_WORKERS ? processors : MAXIMUM_WORKERS;
+}
+
+/**
+ * Runs the server mode: listens on the Unix domain socket given on the command line, and runs the commands of every client which connects to it.
+ * Every client has its own sets (starting from the saved state given on the command line, if any), and its commands run as a script in batch mode.
+ * The printed sets and the errors are sent back to the client, in the order of its commands.
+ * A client ends its session with stop, or by shutting down its side of the connection (which is reported as a missing stop command).
+ * Runs until SIGINT or SIGTERM is received.
+ *
+ * @param programOptions The options the program has been run with.
+ * @return 0 when run successfully, 1 if the socket could not be opened.
+ */
+int runServer(const options *programOptions) {
+    serverstate server;               /* Everything the threads share. */
+    calculator *probe;                /* Checks the saved state once, before any client connects. */
+    const char *error;                /* The reason the saved state could not be loaded. */
+    int listener;                     /* The socket the server listens on. */
+    int connection;                   /* A new connection. */
+    pthread_t *workers;               /* The worker threads. */
+    long workerCount;                 /* The number of worker threads. */
+    long index;                       /* Current index in the worker threads. */
+    session **sessions;               /* Every open session. */
+    session **largerSessions;         /* The sessions with more memory. */
+    session *client;                  /* The current session. */
+    struct pollfd *descriptors;       /* What the main thread waits for: the socket, the wakeup pipe, and then every session. */
+    struct pollfd *largerDescriptors; /* The descriptors with more memory. */
+    size_t sessionCount;              /* The number of open sessions. */
+    size_t capacity;                  /* The number of sessions there is memory for. */
+    size_t current;                   /* Current index in the sessions. */
+    size_t kept;                      /* The number of sessions which are kept open. */
+    short events;                     /* What to wait for on the current session. */
+    char drained[WAKEUP_DRAIN_SIZE];  /* What has been written to the wakeup pipe (thrown away). */
+    struct sigaction action;          /* The handler of SIGINT and SIGTERM (and ignoring SIGPIPE). */
+    sigset_t blocked;                 /* SIGINT and SIGTERM, which only the main thread handles. */
+    sigset_t previousMask;            /* The signals which have been blocked before the workers were started. */
+
+    server.statePath = programOptions->statePath;
+    server.universe = programOptions->universe;
+
+    /* A saved state which cannot be loaded is reported right away, instead of to every client. */
+    if (server.statePath != NULL) {
+        if ((probe = createCalculator(server.universe, writeStandardOutput, writeStandardError, NULL)) == NULL) {
+            /* Exit the program. */
+            fprintf(stderr, "Failed to allocate memory for the sets.\n");
+            exit(ERROR);
+        }
+
+        error = loadCalculatorState(probe, server.statePath);
+        freeCalculator(probe);
+
+        if (error != NULL) {
+            fprintf(stderr, "Error: Failed to load the state %s: %s\n", server.statePath, error);
+            return ERROR;
+        }
+    }
+
+    if ((listener = openListener(programOptions->servePath)) == INVALID_DESCRIPTOR) {
+        return ERROR;
+    }
+
+    workerCount = countWorkers(programOptions);
+    capacity = INITIAL_SESSIONS;
+    sessionCount = EMPTY;
+    sessions = malloc(capacity * sizeof(session *));
+    descriptors = malloc((capacity + FIRST_SESSION_DESCRIPTOR) * sizeof(struct pollfd));
+    workers = malloc(workerCount * sizeof(pthread_t));
+
+    /* Check for an error in the memory allocation (or in creating the wakeup pipe). */
+    if (sessions == NULL || descriptors == NULL || workers == NULL || pipe(server.wakeup) < EMPTY || !setNonBlocking(server.wakeup[READ_END]) || !setNonBlocking(server.wakeup[WRITE_END])) {
+        /* Exit the program. */
+        fprintf(stderr, "Failed to allocate memory for the server.\n");
+        unlink(programOptions->servePath);
+        exit(ERROR);
+    }
+
+    pthread_mutex_init(&server.lock, NULL);
+    pthread_cond_init(&server.isWaiting, NULL);
+    server.first = server.last = NULL;
+    server.isStopping = FALSE;
+
+    /* A client which disconnects while its output is sent is only a failed write. */
+    action.sa_handler = SIG_IGN;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = EMPTY;
+    sigaction(SIGPIPE, &action, NULL);
+
+    /* The workers never handle SIGINT and SIGTERM, so the signals always wake the main thread. */
+    sigemptyset(&blocked);
+    sigaddset(&blocked, SIGINT);
+    sigaddset(&blocked, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &blocked, &previousMask);
+
+    for (index = FIRST_INDEX; index < workerCount; index++) {
+        if (pthread_create(&workers[index], NULL, runWorker, &server) != SUCCESS) {
+            /* Exit the program. */
+            fprintf(stderr, "Failed to start the worker threads.\n");
+            unlink(programOptions->servePath);
+            exit(ERROR);
+        }
+    }
+
+    interruptDescriptor = server.wakeup[WRITE_END];
+    action.sa_handler = requestStop;
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+    pthread_sigmask(SIG_SETMASK, &previousMask, NULL);
+
+    descriptors[LISTENER_DESCRIPTOR].fd = listener;
+    descriptors[LISTENER_DESCRIPTOR].events = POLLIN;
+    descriptors[WAKEUP_DESCRIPTOR].fd = server.wakeup[READ_END];
+    descriptors[WAKEUP_DESCRIPTOR].events = POLLIN;
+
+    /* Loop until SIGINT or SIGTERM is received. */
+    while (!isInterrupted) {
+        /* Close the sessions which are done, and choose what to wait for on every other one. */
+        for (current = kept = FIRST_INDEX; current < sessionCount; current++) {
+            client = sessions[current];
+            pthread_mutex_lock(&client->lock);
+
+            if (client->isFinished && !client->isQueued && (client->output.length == EMPTY || client->isBroken)) {
+                pthread_mutex_unlock(&client->lock);
+                closeSession(client);
+                continue;
+            }
+
+            /* A session stops being read while it has enough complete lines waiting (its output is not read fast enough). */
+            events = !client->isEnded && (client->lines == EMPTY || client->input.length < SESSION_INPUT_LIMIT) ? POLLIN : EMPTY;
+
+            if (client->output.length != EMPTY && !client->isBroken) {
+                events |= POLLOUT;
+            }
+
+            pthread_mutex_unlock(&client->lock);
+            sessions[kept] = client;
+            /* A broken connection is no longer waited for (it is closed once no worker runs it). */
+            descriptors[kept + FIRST_SESSION_DESCRIPTOR].fd = client->isBroken ? INVALID_DESCRIPTOR : client->socket;
+            descriptors[kept + FIRST_SESSION_DESCRIPTOR].events = events;
+            descriptors[kept + FIRST_SESSION_DESCRIPTOR].revents = EMPTY;
+            kept++;
+        }
+
+        sessionCount = kept;
+        descriptors[LISTENER_DESCRIPTOR].revents = descriptors[WAKEUP_DESCRIPTOR].revents = EMPTY;
+
+        /* Wait for something to happen (an interrupted wait checks for SIGINT and SIGTERM). */
+        if (poll(descriptors, sessionCount + FIRST_SESSION_DESCRIPTOR, NO_TIMEOUT) < EMPTY) {
+            continue;
+        }
+
+        if (descriptors[WAKEUP_DESCRIPTOR].revents & POLLIN) {
+            while (read(server.wakeup[READ_END], drained, sizeof(drained)) > EMPTY) {
+                continue;
+            }
+        }
+
+        for (current = FIRST_INDEX; current < sessionCount; current++) {
+            events = descriptors[current + FIRST_SESSION_DESCRIPTOR].revents;
+
+            if (events & POLLOUT) {
+                sendOutput(&server, sessions[current]);
+            }
+
+            /* A connection which has been closed on both sides (or has failed) is broken once everything has been received. */
+            if (events & POLLIN) {
+                receiveInput(&server, sessions[current]);
+            } else if (events & (POLLHUP | POLLERR)) {
+                pthread_mutex_lock(&sessions[current]->lock);
+                breakSession(sessions[current]);
+                pthread_mutex_unlock(&sessions[current]->lock);
+            }
+        }
+
+        /* Accept every new connection. */
+        if (descriptors[LISTENER_DESCRIPTOR].revents & POLLIN) {
+            while ((connection = accept(listener, NULL, NULL)) >= EMPTY) {
+                /* Allocate more memory if necessary. */
+                if (sessionCount == capacity) {
+                    if ((largerSessions = realloc(sessions, capacity * GROWTH_FACTOR * sizeof(session *))) != NULL) {
+                        sessions = largerSessions;
+                    }
+
+                    if ((largerDescriptors = realloc(descriptors, (capacity * GROWTH_FACTOR + FIRST_SESSION_DESCRIPTOR) * sizeof(struct pollfd))) != NULL) {
+                        descriptors = largerDescriptors;
+                    }
+
+                    if (largerSessions != NULL && largerDescriptors != NULL) {
+                        capacity *= GROWTH_FACTOR;
+                    }
+                }
+
+                /* A connection the server has no memory for is closed right away. */
+                if (sessionCount == capacity || !setNonBlocking(connection) || (client = openSession(&server, connection)) == NULL) {
+                    close(connection);
+                    continue;
+                }
+
+                sessions[sessionCount++] = client;
+            }
+        }
+    }
+
+    /* Stop the workers once their current turn is done. */
+    pthread_mutex_lock(&server.lock);
+    server.isStopping = TRUE;
+    pthread_cond_broadcast(&server.isWaiting);
+    pthread_mutex_unlock(&server.lock);
+
+    for (index = FIRST_INDEX; index < workerCount; index++) {
+        pthread_join(workers[index], NULL);
+    }
+
+    /* Everything the server used is no longer used. */
+    for (current = FIRST_INDEX; current < sessionCount; current++) {
+        closeSession(sessions[current]);
+    }
+
+    close(listener);
+    unlink(programOptions->servePath);
+    close(server.wakeup[READ_END]);
+    close(server.wakeup[WRITE_END]);
+    pthread_mutex_destroy(&server.lock);
+    pthread_cond_destroy(&server.isWaiting);
+    free(sessions);
+    free(descriptors);
+    free(workers);
+
+    /* Return 0 when run successfully. */
+    return SUCCESS;
+}
@@ -0,0 +1,28 @@
+/*
+ * server.h
+ * Includes the prototypes of all the functions in server.c.
+ *
+ * Name: Ariel Keren
+ * Course: C Lab, 20465
+ * Semester: 2024B
+ * Date: 18/10/2026
+ */
+
+#ifndef SERVER_H
+#define SERVER_H
+
+#include "mysetUtils.h"
+
+/**
+ * Runs the server mode: listens on the Unix domain socket given on the command line, and runs the commands of every client which connects to it.
+ * Every client has its own sets (starting from the saved state given on the command line, if any), and its commands run as a script in batch mode.
+ * The printed sets and the errors are sent back to the client, in the order of its commands.
+ * A client ends its session with stop, or by shutting down its side of the connection (which is reported as a missing stop command).
+ * Runs until SIGINT or SIGTERM is received.
+ *
+ * @param programOptions The options the program has been run with.
+ * @return 0 when run successfully, 1 if the socket could not be opened.
+ */
+int runServer(const options *programOptions);
+
+#endif
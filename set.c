@@ -2,6 +2,8 @@
  * set.c
  * Includes one function for each of the possible commands in the program.
  * Every function assumes the inputs are valid.
+ * The set operations walk over the containers of both sets by their keys, combining containers with the same key.
+ * Their cost grows with the number of containers, rather than with the size of the universe.
  *
  * Name: Ariel Keren
  * Course: C Lab, 20465
@@ -12,36 +14,36 @@
 #include "set.h"
 
 #include <stdio.h>
+#include <string.h>
 
+#include "calculator.h"
+#include "container.h"
 #include "globals.h"
 #include "setUtils.h"
 
 /**
- * Reads the given numbers to the set (excluding the terminator).
- * Assumes the numbers array is terminated by -1.
+ * Fills the set with the given members (which have already been decoded from the command).
+ * The containers of the members are moved to the set, and the previous members of the set are moved to the members.
  *
  * @param setA The set to fill.
- * @param numbers The numbers to add to the set.
+ * @param members The members to fill the set with.
  */
-void read_set(set setA, const operand numbers[]) {
-    setindex index;           /* Current index in the set. */
-    setindex setPosition;     /* Current number's section index. */
-    unsigned sectionPosition; /* Current number's position in its section. */
-
-    /* Reset every section in the set. */
-    for (index = FIRST_INDEX; index < SET_SIZE; index++) {
-        setA[index] = EMPTY;
-    }
+void read_set(set *setA, set *members) {
+    set previous; /* The previous members of the set. */
 
-    /* Add each number to the set. */
-    for (index = FIRST_INDEX; numbers[index] != TERMINATOR; index++) {
-        /* Find the number's section in the set. */
-        setPosition = numbers[index] / (sizeof(setsection) * BITS_PER_BYTE);
-        /* Find the number's position in its section. */
-        sectionPosition = numbers[index] % (sizeof(setsection) * BITS_PER_BYTE);
-        /* Shift a bit by the number's position in its section, then apply OR to the number's section. */
-        setA[setPosition] |= SINGLE_BIT << sectionPosition;
-    }
+    /* Swap the containers, instead of copying them. */
+    previous = *setA;
+    *setA = *members;
+    *members = previous;
+}
+
+/**
+ * Prints the given text to the output sink of the calculator in use.
+ *
+ * @param text The text to print (null-terminated).
+ */
+static void printText(const char text[]) {
+    writeOutput(text, strlen(text));
 }
 
 /**
@@ -51,10 +53,10 @@ void read_set(set setA, const operand numbers[]) {
  *
  * @param setA The set to print.
  */
-void print_set(const set setA) {
+void print_set(const set *setA) {
     /* Check if the set is empty. */
     if (isSetEmpty(setA)) {
-        printf("The set is empty.\n");
+        printText("The set is empty.\n");
         return;
     }
 
@@ -62,6 +64,134 @@ void print_set(const set setA) {
     printSetAsString(setA);
 }
 
+/**
+ * Prints the number of members in the given set.
+ * Every container keeps its number of members, so the members are not enumerated.
+ *
+ * @param setA The set to count the members of.
+ */
+void count_set(const set *setA) {
+    char text[NUMBER_TEXT_LENGTH]; /* The number of members, as printed. */
+
+    sprintf(text, "%lu\n", getCardinality(setA));
+    printText(text);
+}
+
+/**
+ * Prints the smallest member in the given set.
+ * If the set is empty, prints "The set is empty."
+ *
+ * @param setA The set to check.
+ */
+void min_set(const set *setA) {
+    char text[NUMBER_TEXT_LENGTH]; /* The smallest member, as printed. */
+
+    /* Check if the set is empty. */
+    if (isSetEmpty(setA)) {
+        printText("The set is empty.\n");
+        return;
+    }
+
+    sprintf(text, "%ld\n", getMinimum(setA));
+    printText(text);
+}
+
+/**
+ * Prints the largest member in the given set.
+ * If the set is empty, prints "The set is empty."
+ *
+ * @param setA The set to check.
+ */
+void max_set(const set *setA) {
+    char text[NUMBER_TEXT_LENGTH]; /* The largest member, as printed. */
+
+    /* Check if the set is empty. */
+    if (isSetEmpty(setA)) {
+        printText("The set is empty.\n");
+        return;
+    }
+
+    sprintf(text, "%ld\n", getMaximum(setA));
+    printText(text);
+}
+
+/**
+ * Applies a set operation to set A and set B, container by container.
+ * Containers whose key is only in one of the sets are copied when the operation keeps them.
+ * Containers whose key is in both sets are combined.
+ * The result is built separately, so set C may also be set A or set B.
+ *
+ * @param setA The first set to apply the operation to.
+ * @param setB The second set to apply the operation to.
+ * @param setC The set to store the result in.
+ * @param operation The operation to apply (UNION_SET, INTERSECT_SET, SUB_SET or SYMDIFF_SET).
+ * @return TRUE if the operation has been applied, FALSE if the memory allocation failed.
+ */
+static boolean combineSets(const set *setA, const set *setB, set *setC, int operation) {
+    set result;                  /* The result of the operation. */
+    size_t indexA;               /* Current index in set A. */
+    size_t indexB;               /* Current index in set B. */
+    const container *containerA; /* The current container of set A. */
+    const container *containerB; /* The current container of set B. */
+    container output;            /* The current container of the result. */
+    boolean keepOnlyA;           /* Should containers which are only in set A be kept? */
+    boolean keepOnlyB;           /* Should containers which are only in set B be kept? */
+
+    if (!createSet(&result)) {
+        return FALSE;
+    }
+
+    keepOnlyA = operation != INTERSECT_SET;
+    keepOnlyB = operation == UNION_SET || operation == SYMDIFF_SET;
+    indexA = indexB = FIRST_INDEX;
+
+    /* Walk over the containers of both sets together, in order of their keys. */
+    while (indexA < setA->count || indexB < setB->count) {
+        containerA = indexA < setA->count ? &setA->containers[indexA] : NULL;
+        containerB = indexB < setB->count ? &setB->containers[indexB] : NULL;
+        output.cardinality = STARTING_VALUE;
+
+        if (containerB == NULL || (containerA != NULL && containerA->key < containerB->key)) {
+            /* The key is only in set A. */
+            if (keepOnlyA && !copyContainer(containerA, &output)) {
+                freeSet(&result);
+                return FALSE;
+            }
+
+            indexA++;
+        } else if (containerA == NULL || containerB->key < containerA->key) {
+            /* The key is only in set B. */
+            if (keepOnlyB && !copyContainer(containerB, &output)) {
+                freeSet(&result);
+                return FALSE;
+            }
+
+            indexB++;
+        } else {
+            /* The key is in both sets. */
+            if (!combineContainers(containerA, containerB, &output, operation)) {
+                freeSet(&result);
+                return FALSE;
+            }
+
+            indexA++;
+            indexB++;
+        }
+
+        /* Add the container to the result, unless it is empty. */
+        if (output.cardinality != EMPTY && !appendContainer(&result, &output)) {
+            freeContainer(&output);
+            freeSet(&result);
+            return FALSE;
+        }
+    }
+
+    /* Replace the previous members of set C with the result. */
+    freeSet(setC);
+    *setC = result;
+    return TRUE;
+}
+
 /**
  * Applies the union operation to set A and set B.
  * The result is every element in set A and/or in set B.
@@ -70,14 +200,10 @@ void print_set(const set setA) {
  * @param setA The first set to apply the operation to.
  * @param setB The second set to apply the operation to.
  * @param setC The set to store the result in.
+ * @return TRUE if the operation has been applied, FALSE if the memory allocation failed.
  */
-void union_set(const set setA, const set setB, set setC) {
-    setindex index; /* Current index in the set. */
-
-    /* Apply OR to set A and set B's sections. Store in set C. */
-    for (index = FIRST_INDEX; index < SET_SIZE; index++) {
-        setC[index] = setA[index] | setB[index];
-    }
+boolean union_set(const set *setA, const set *setB, set *setC) {
+    return combineSets(setA, setB, setC, UNION_SET);
 }
 
 /**
@@ -88,14 +214,10 @@ void union_set(const set setA, const set setB, set setC) {
  * @param setA The first set to apply the operation to.
  * @param setB The second set to apply the operation to.
  * @param setC The set to store the result in.
+ * @return TRUE if the operation has been applied, FALSE if the memory allocation failed.
  */
-void intersect_set(const set setA, const set setB, set setC) {
-    setindex index; /* Current index in the set. */
-
-    /* Apply AND to set A and set B's sections. Store in set C. */
-    for (index = FIRST_INDEX; index < SET_SIZE; index++) {
-        setC[index] = setA[index] & setB[index];
-    }
+boolean intersect_set(const set *setA, const set *setB, set *setC) {
+    return combineSets(setA, setB, setC, INTERSECT_SET);
 }
 
 /**
@@ -106,14 +228,10 @@ void intersect_set(const set setA, const set setB, set setC) {
  * @param setA The first set to apply the operation to.
  * @param setB The second set to apply the operation to.
  * @param setC The set to store the result in.
+ * @return TRUE if the operation has been applied, FALSE if the memory allocation failed.
  */
-void sub_set(const set setA, const set setB, set setC) {
-    setindex index; /* Current index in the set. */
-
-    /* Apply AND to set A and set B's sections, after applying NOT to set B's sections. Store in set C. */
-    for (index = FIRST_INDEX; index < SET_SIZE; index++) {
-        setC[index] = setA[index] & ~setB[index];
-    }
+boolean sub_set(const set *setA, const set *setB, set *setC) {
+    return combineSets(setA, setB, setC, SUB_SET);
 }
 
 /**
@@ -124,12 +242,8 @@ void sub_set(const set setA, const set setB, set setC) {
  * @param setA The first set to apply the operation to.
  * @param setB The second set to apply the operation to.
  * @param setC The set to store the result in.
+ * @return TRUE if the operation has been applied, FALSE if the memory allocation failed.
  */
-void symdiff_set(const set setA, const set setB, set setC) {
-    setindex index; /* Current index in the set. */
-
-    /* Apply XOR to set A and set B's sections. Store in set C. */
-    for (index = FIRST_INDEX; index < SET_SIZE; index++) {
-        setC[index] = setA[index] ^ setB[index];
-    }
+boolean symdiff_set(const set *setA, const set *setB, set *setC) {
+    return combineSets(setA, setB, setC, SYMDIFF_SET);
 }
@@ -12,23 +12,28 @@
 #ifndef SET_H
 #define SET_H
 
+#include <stddef.h>
+
+#include "container.h"
 #include "globals.h"
 
-/* Each set section represents 8 numbers in the set. */
-typedef unsigned char setsection;
-/* A set is an array of 16 (128 numbers / 8 in each section) set sections. */
-typedef setsection set[SET_SIZE];
+/* A set is a sorted array of containers, one for each chunk of the universe which has at least one member. */
+typedef struct {
+    container *containers; /* The containers of the set, sorted by their keys. */
+    size_t count;          /* The number of containers in the set. */
+    size_t capacity;       /* The number of containers the set has memory for. */
+} set;
 /* Used as a pointer to a set when a set cannot be passed. */
-typedef setsection *setptr;
+typedef set *setptr;
 
 /**
- * Reads the given numbers to the set (excluding the terminator).
- * Assumes the numbers array is terminated by -1.
+ * Fills the set with the given members (which have already been decoded from the command).
+ * The containers of the members are moved to the set, and the previous members of the set are moved to the members.
  *
  * @param setA The set to fill.
- * @param numbers The numbers to add to the set.
+ * @param members The members to fill the set with.
  */
-void read_set(set setA, const operand numbers[]);
+void read_set(set *setA, set *members);
 
 /**
  * Converts and prints the given set's string representation.
@@ -37,7 +42,31 @@ void read_set(set setA, const operand numbers[]);
  *
  * @param setA The set to print.
  */
-void print_set(const set setA);
+void print_set(const set *setA);
+
+/**
+ * Prints the number of members in the given set.
+ * Every container keeps its number of members, so the members are not enumerated.
+ *
+ * @param setA The set to count the members of.
+ */
+void count_set(const set *setA);
+
+/**
+ * Prints the smallest member in the given set.
+ * If the set is empty, prints "The set is empty."
+ *
+ * @param setA The set to check.
+ */
+void min_set(const set *setA);
+
+/**
+ * Prints the largest member in the given set.
+ * If the set is empty, prints "The set is empty."
+ *
+ * @param setA The set to check.
+ */
+void max_set(const set *setA);
 
 /**
  * Applies the union operation to set A and set B.
@@ -47,8 +76,9 @@ void print_set(const set setA);
  * @param setA The first set to apply the operation to.
  * @param setB The second set to apply the operation to.
  * @param setC The set to store the result in.
+ * @return TRUE if the operation has been applied, FALSE if the memory allocation failed.
  */
-void union_set(const set setA, const set setB, set setC);
+boolean union_set(const set *setA, const set *setB, set *setC);
 
 /**
  * Applies the intersection operation to set A and set B.
@@ -58,8 +88,9 @@ void union_set(const set setA, const set setB, set setC);
  * @param setA The first set to apply the operation to.
  * @param setB The second set to apply the operation to.
  * @param setC The set to store the result in.
+ * @return TRUE if the operation has been applied, FALSE if the memory allocation failed.
  */
-void intersect_set(const set setA, const set setB, set setC);
+boolean intersect_set(const set *setA, const set *setB, set *setC);
 
 /**
  * Applies the difference operation to set A and set B.
@@ -69,8 +100,9 @@ void intersect_set(const set setA, const set setB, set setC);
  * @param setA The first set to apply the operation to.
  * @param setB The second set to apply the operation to.
  * @param setC The set to store the result in.
+ * @return TRUE if the operation has been applied, FALSE if the memory allocation failed.
  */
-void sub_set(const set setA, const set setB, set setC);
+boolean sub_set(const set *setA, const set *setB, set *setC);
 
 /**
  * Applies the symmetric difference operation to set A and set B.
@@ -80,7 +112,8 @@ void sub_set(const set setA, const set setB, set setC);
  * @param setA The first set to apply the operation to.
  * @param setB The second set to apply the operation to.
  * @param setC The set to store the result in.
+ * @return TRUE if the operation has been applied, FALSE if the memory allocation failed.
  */
-void symdiff_set(const set setA, const set setB, set setC);
+boolean symdiff_set(const set *setA, const set *setB, set *setC);
 
 #endif
@@ -1,6 +1,7 @@
 /*
  * setUtils.c
  * Includes functions to be used in set.c, mainly for printing sets.
+ * Also, includes functions for choosing the size of the universe, allocating sets and filling them with containers.
  *
  * Name: Ariel Keren
  * Course: C Lab, 20465
@@ -11,87 +12,463 @@
 #include "setUtils.h"
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
+#include "calculator.h"
+#include "container.h"
 #include "globals.h"
 #include "set.h"
 
+/* The two digits of every number from 0 to 99. */
+static const char DIGIT_TABLE[] = "00010203040506070809"
+                                  "10111213141516171819"
+                                  "20212223242526272829"
+                                  "30313233343536373839"
+                                  "40414243444546474849"
+                                  "50515253545556575859"
+                                  "60616263646566676869"
+                                  "70717273747576777879"
+                                  "80818283848586878889"
+                                  "90919293949596979899";
+
+/**
+ * Returns the largest potential member in every set of the calculator in use.
+ *
+ * @return The largest potential member.
+ */
+long getLargestMember() {
+    return getCalculator()->largestMember;
+}
+
+/**
+ * Allocates the given set with no members.
+ * Only the array of containers is allocated; every container is allocated once it has members.
+ *
+ * @param setA The set to allocate.
+ * @return TRUE if the set has been allocated, FALSE if the memory allocation failed.
+ */
+boolean createSet(set *setA) {
+    setA->count = STARTING_VALUE;
+    setA->capacity = INITIAL_CONTAINERS;
+    setA->containers = malloc(INITIAL_CONTAINERS * sizeof(container));
+    return setA->containers != NULL;
+}
+
+/**
+ * Frees the memory used by the given set.
+ *
+ * @param setA The set to free.
+ */
+void freeSet(set *setA) {
+    clearSet(setA);
+    free(setA->containers);
+    setA->containers = NULL;
+    setA->capacity = STARTING_VALUE;
+}
+
+/**
+ * Replaces the members of the given set with a copy of the members of another set.
+ * The copy is built separately, so the previous members are only freed once it is complete.
+ *
+ * @param source The set to copy.
+ * @param result The set to store the copy in.
+ * @return TRUE if the set has been copied, FALSE if the memory allocation failed.
+ */
+boolean copySet(const set *source, set *result) {
+    set copy;          /* The copy of the set. */
+    size_t index;      /* Current index in the containers. */
+    container current; /* The copy of the current container. */
+
+    if (!createSet(&copy)) {
+        return FALSE;
+    }
+
+    /* Copy every container, in order. */
+    for (index = FIRST_INDEX; index < source->count; index++) {
+        if (!copyContainer(&source->containers[index], &current)) {
+            freeSet(&copy);
+            return FALSE;
+        }
+
+        if (!appendContainer(&copy, &current)) {
+            freeContainer(&current);
+            freeSet(&copy);
+            return FALSE;
+        }
+    }
+
+    /* Replace the previous members of the set with the copy. */
+    freeSet(result);
+    *result = copy;
+    return TRUE;
+}
+
 /**
  * Checks if the given set is empty.
  *
  * @param setA The set to check.
  * @return TRUE if the set is empty, FALSE otherwise.
  */
-boolean isSetEmpty(const set setA) {
-    setindex index; /* Current index in the set. */
+boolean isSetEmpty(const set *setA) {
+    /* Only containers with members are kept. */
+    return setA->count == EMPTY;
+}
+
+/**
+ * Returns the number of members in the given set.
+ *
+ * @param setA The set to count the members of.
+ * @return The number of members in the set.
+ */
+unsigned long getCardinality(const set *setA) {
+    size_t index;          /* Current index in the set. */
+    unsigned long members; /* The number of members counted so far. */
+
+    members = STARTING_VALUE;
+
+    /* Add up the number of members in every container. */
+    for (index = FIRST_INDEX; index < setA->count; index++) {
+        members += setA->containers[index].cardinality;
+    }
+
+    return members;
+}
+
+/**
+ * Returns the smallest member in the given set.
+ * Assumes the set is not empty.
+ *
+ * @param setA The set to check.
+ * @return The smallest member in the set.
+ */
+long getMinimum(const set *setA) {
+    const container *first; /* The container with the smallest key. */
+
+    first = &setA->containers[FIRST_INDEX];
+    return (long)first->key << CONTAINER_BITS | findMinimumValue(first);
+}
+
+/**
+ * Returns the largest member in the given set.
+ * Assumes the set is not empty.
+ *
+ * @param setA The set to check.
+ * @return The largest member in the set.
+ */
+long getMaximum(const set *setA) {
+    const container *last; /* The container with the largest key. */
+
+    last = &setA->containers[setA->count - NEXT_INDEX_DIFFERENCE];
+    return (long)last->key << CONTAINER_BITS | findMaximumValue(last);
+}
+
+/**
+ * Removes every member from the given set.
+ * Keeps the memory of the array of containers, so the set can be filled again.
+ *
+ * @param setA The set to empty.
+ */
+void clearSet(set *setA) {
+    size_t index; /* Current index in the set. */
+
+    /* Free every container in the set. */
+    for (index = FIRST_INDEX; index < setA->count; index++) {
+        freeContainer(&setA->containers[index]);
+    }
+
+    setA->count = STARTING_VALUE;
+}
+
+/**
+ * Inserts the given container into the set at the given index.
+ * The set takes over the container's memory.
+ *
+ * @param setA The set to insert the container into.
+ * @param index The index to insert the container at (keeping the containers sorted by their keys).
+ * @param target The container to insert.
+ * @return TRUE if the container has been inserted, FALSE if the memory allocation failed.
+ */
+static boolean insertContainer(set *setA, size_t index, const container *target) {
+    container *containers; /* The grown array of containers. */
+
+    /* Grow the array of containers (geometrically) if it is full. */
+    if (setA->count == setA->capacity) {
+        containers = realloc(setA->containers, setA->capacity * GROWTH_FACTOR * sizeof(container));
+
+        if (containers == NULL) {
+            return FALSE;
+        }
+
+        setA->containers = containers;
+        setA->capacity *= GROWTH_FACTOR;
+    }
+
+    /* Make room for the container and insert it. */
+    memmove(setA->containers + index + NEXT_INDEX_DIFFERENCE, setA->containers + index, (setA->count - index) * sizeof(container));
+    setA->containers[index] = *target;
+    setA->count++;
+    return TRUE;
+}
+
+/**
+ * Adds the given container after every other container in the set.
+ * Assumes the container's key is larger than the key of every other container in the set.
+ * The set takes over the container's memory.
+ *
+ * @param setA The set to add the container to.
+ * @param target The container to add.
+ * @return TRUE if the container has been added, FALSE if the memory allocation failed.
+ */
+boolean appendContainer(set *setA, const container *target) {
+    return insertContainer(setA, setA->count, target);
+}
+
+/**
+ * Adds the given member to the given set.
+ * Creates the member's container (as an array container) if the set has no other member with the same key.
+ * Assumes the member is in the universe.
+ *
+ * @param setA The set to add the member to.
+ * @param member The member to add.
+ * @return TRUE if the member has been added, FALSE if the memory allocation failed.
+ */
+boolean addMember(set *setA, long member) {
+    uint32_t key;      /* The high bits of the member. */
+    size_t low;        /* The lowest index the member's container can be at. */
+    size_t high;       /* The highest index the member's container can be at. */
+    container created; /* The member's container, if it has to be created. */
+
+    key = (uint32_t)(member >> CONTAINER_BITS);
+    low = FIRST_INDEX;
+    high = setA->count;
+
+    /* Members usually come in order, so check the last container first. */
+    if (high != EMPTY && setA->containers[high - NEXT_INDEX_DIFFERENCE].key <= key) {
+        low = high - NEXT_INDEX_DIFFERENCE;
+    }
+
+    /* Find the position of the member's container in the sorted array. */
+    low = findContainerIndex(setA->containers, low, high, key);
+
+    /* Create the member's container if it does not exist yet. */
+    if (low == setA->count || setA->containers[low].key != key) {
+        if (!createArrayContainer(&created, key, EMPTY)) {
+            return FALSE;
+        }
+
+        if (!insertContainer(setA, low, &created)) {
+            freeContainer(&created);
+            return FALSE;
+        }
+    }
+
+    return addContainerValue(&setA->containers[low], (uint16_t)(member & LOW_BITS_MASK));
+}
+
+/**
+ * Converts every container in the set to the kind which keeps its members in the least memory.
+ *
+ * @param setA The set to convert.
+ * @return TRUE if the set has been converted, FALSE if the memory allocation failed.
+ */
+boolean optimizeSet(set *setA) {
+    size_t index; /* Current index in the set. */
 
-    /* Loop over all sections in the set. */
-    for (index = FIRST_INDEX; index < SET_SIZE; index++) {
-        /* Check if the current section is not empty. */
-        if (setA[index] != EMPTY) {
-            /* The set is definitely not empty. */
+    /* Convert every container in the set. */
+    for (index = FIRST_INDEX; index < setA->count; index++) {
+        if (!optimizeContainer(&setA->containers[index])) {
             return FALSE;
         }
     }
 
-    /* All sections are empty, so the set is definitely empty. */
     return TRUE;
 }
 
+/**
+ * Writes the output buffer to the output sink of the calculator in use, and empties it.
+ *
+ * @param output The output buffer.
+ */
+static void flushOutput(printbuffer *output) {
+    writeOutput(output->text, output->length);
+    output->length = STARTING_VALUE;
+}
+
+/**
+ * Makes sure the output buffer has room for the given number of characters.
+ * Grows the buffer (geometrically) up to its limit, and writes it out once it cannot grow anymore.
+ * Exits the program if the first memory allocation fails.
+ *
+ * @param output The output buffer.
+ * @param needed The number of characters to make room for.
+ */
+static void reserveOutput(printbuffer *output, size_t needed) {
+    char *grown;     /* The grown output buffer. */
+    size_t capacity; /* The size of the grown output buffer. */
+
+    /* Check if there is already enough room. */
+    if (output->length + needed <= output->capacity) {
+        return;
+    }
+
+    capacity = output->capacity == EMPTY ? INITIAL_PRINT_BUFFER : output->capacity * GROWTH_FACTOR;
+
+    /* Grow the buffer if it has not reached its limit. */
+    if (output->capacity < PRINT_BUFFER_LIMIT && (grown = realloc(output->text, capacity)) != NULL) {
+        output->text = grown;
+        output->capacity = capacity;
+        return;
+    }
+
+    /* A buffer which cannot grow is written out instead. */
+    if (output->capacity == EMPTY) {
+        failMemory("Failed to allocate memory for the output.");
+    }
+
+    flushOutput(output);
+}
+
+/**
+ * Adds the given member to the output buffer, after a comma and a space (unless it is the first one).
+ * Every 16 numbers in a single line, moves to the next line.
+ * Assumes the buffer has room for the member's text.
+ *
+ * @param output The output buffer.
+ * @param member The member to add.
+ * @param numbersFound The number of members added so far (incremented).
+ */
+static void addMemberText(printbuffer *output, unsigned long member, unsigned long *numbersFound) {
+    char digits[MAXIMUM_DIGITS]; /* The digits of the member, filled from the end. */
+    size_t position;             /* The position of the first digit filled so far. */
+    const char *pair;            /* The current pair of digits in the digit table. */
+    char *end;                   /* The end of the output buffer. */
+
+    position = MAXIMUM_DIGITS;
+
+    /* Convert two digits at a time, from the lowest ones. */
+    while (member >= DIGIT_PAIRS) {
+        pair = DIGIT_TABLE + member % DIGIT_PAIRS * DIGIT_PAIR_LENGTH;
+        member /= DIGIT_PAIRS;
+        position -= DIGIT_PAIR_LENGTH;
+        digits[position] = pair[FIRST_INDEX];
+        digits[position + NEXT_INDEX_DIFFERENCE] = pair[SECOND_INDEX];
+    }
+
+    /* Convert the one or two highest digits. */
+    pair = DIGIT_TABLE + member * DIGIT_PAIR_LENGTH;
+
+    if (member >= DECIMAL_BASE) {
+        digits[--position] = pair[SECOND_INDEX];
+    }
+
+    digits[--position] = pair[member >= DECIMAL_BASE ? FIRST_INDEX : SECOND_INDEX];
+    end = output->text + output->length;
+
+    /* Add a comma and a space after each number (excluding the last one). */
+    if (*numbersFound != STARTING_VALUE) {
+        *end++ = ',';
+        *end++ = ' ';
+    }
+
+    /* Add the number. */
+    memcpy(end, digits + position, MAXIMUM_DIGITS - position);
+    end += MAXIMUM_DIGITS - position;
+    (*numbersFound)++;
+
+    /* Every 16 numbers in a single line, move to the next line by adding a newline character. */
+    if (*numbersFound % NUMBERS_PER_LINE == NO_REMAINDER) {
+        *end++ = '\n';
+    }
+
+    output->length = end - output->text;
+}
+
 /**
  * Converts a non-empty set to its string representation and prints it.
  * Assumes the set is non-empty.
  * Every number is the set is separated by a comma and a space.
  * No more than 16 numbers shall occupy the same line.
+ * The string is built in the reusable buffer of the calculator in use, and written to its output sink with a single call (unless it is larger than 1 MiB).
  *
  * @param setA The set to print.
  */
-void printSetAsString(const set setA) {
-    setindex index;              /* Current index in the set. */
-    setsection mask;             /* Current mask (used to get a specific number from a section). */
-    unsigned char currentNumber; /* Current number of positions checked in the set. */
-    unsigned char numbersFound;  /* Current number of numbers found in the set. */
+void printSetAsString(const set *setA) {
+    size_t index;               /* Current index in the set. */
+    const container *current;   /* The current container. */
+    unsigned long base;         /* The smallest potential member of the current container. */
+    uint32_t position;          /* Current index in the container. */
+    unsigned long value;        /* Current value in the container. */
+    unsigned long end;          /* The last value of the current run. */
+    setsection section;         /* The bits of the current section which have not been printed yet. */
+    unsigned long numbersFound; /* Current number of numbers found in the set. */
+    printbuffer *output;        /* The output buffer of the calculator in use. */
 
     numbersFound = STARTING_VALUE;
-    currentNumber = STARTING_VALUE;
-
-    /* Print the opening curly brace of the set. */
-    printf("{");
-
-    /* Loop over all sections in the set. */
-    for (index = FIRST_INDEX; index < SET_SIZE; index++) {
-        /* Loop over all possible numbers in each section. */
-        for (mask = SINGLE_BIT; mask != EMPTY; mask <<= SINGLE_BIT) {
-            /* Check if the current number is not in the set. */
-            if ((setA[index] & mask) == EMPTY) {
-                /* Add the position and skip the number. */
-                currentNumber++;
-                continue;
-            }
-
-            /* Print a comma and a space after each number (excluding the last one). */
-            if (numbersFound != STARTING_VALUE) {
-                printf(", ");
-            }
-
-            /* Print the number. */
-            printf("%d", currentNumber);
-
-            /* A position has been checked and a number has been found. */
-            currentNumber++;
-            numbersFound++;
-
-            /* Every 16 numbers in a single line, move to the next line by printing a newline character. */
-            if (numbersFound % NUMBERS_PER_LINE == NO_REMAINDER) {
-                printf("\n");
-            }
+    output = &getCalculator()->printed;
+    output->length = STARTING_VALUE;
+
+    /* Add the opening curly brace of the set. */
+    reserveOutput(output, SINGLE_CHARACTER);
+    output->text[output->length++] = '{';
+
+    /* Loop over all containers in the set, in order of their keys. */
+    for (index = FIRST_INDEX; index < setA->count; index++) {
+        current = &setA->containers[index];
+        base = (unsigned long)current->key << CONTAINER_BITS;
+
+        /* Loop over the members of the container, in increasing order. */
+        switch (current->type) {
+            case ARRAY_CONTAINER:
+                for (position = FIRST_INDEX; position < current->count; position++) {
+                    reserveOutput(output, MAXIMUM_MEMBER_TEXT);
+                    addMemberText(output, base + current->data.values[position], &numbersFound);
+                }
+
+                break;
+            case BITMAP_CONTAINER:
+                /* Jump straight to every set bit, clearing the lowest one each time. */
+                for (position = FIRST_INDEX; position < BITMAP_SECTIONS; position++) {
+                    for (section = current->data.sections[position]; section != EMPTY; section &= section - SINGLE_BIT) {
+                        reserveOutput(output, MAXIMUM_MEMBER_TEXT);
+                        addMemberText(output, base + position * SECTION_BITS + findLowestBit(section), &numbersFound);
+                    }
+                }
+
+                break;
+            default:
+                for (position = FIRST_INDEX; position < current->count; position++) {
+                    end = (unsigned long)current->data.runs[position].start + current->data.runs[position].length;
+
+                    for (value = current->data.runs[position].start; value <= end; value++) {
+                        reserveOutput(output, MAXIMUM_MEMBER_TEXT);
+                        addMemberText(output, base + value, &numbersFound);
+                    }
+                }
+
+                break;
         }
     }
 
-    /* Print the closing curly brace of the set. */
-    printf("}");
+    /* Add the closing curly brace of the set, and an extra newline character when necessary. */
+    reserveOutput(output, SINGLE_CHARACTER + SINGLE_CHARACTER);
+    output->text[output->length++] = '}';
 
-    /* Print an extra newline character when necessary. */
     if (numbersFound % NUMBERS_PER_LINE != NO_REMAINDER) {
-        printf("\n");
+        output->text[output->length++] = '\n';
     }
+
+    flushOutput(output);
+}
+
+/**
+ * Frees the memory of the output buffer used for printing sets, in the calculator in use.
+ */
+void freeOutputBuffer() {
+    printbuffer *output; /* The output buffer of the calculator in use. */
+
+    output = &getCalculator()->printed;
+    free(output->text);
+    output->text = NULL;
+    output->capacity = output->length = STARTING_VALUE;
 }
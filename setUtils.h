@@ -11,24 +11,135 @@
 #ifndef SET_UTILS_H
 #define SET_UTILS_H
 
+#include "container.h"
 #include "set.h"
 
+/* The buffer sets are printed into (every calculator has its own, see calculator.h). */
+typedef struct {
+    char *text;      /* The characters which have not been written out yet. */
+    size_t capacity; /* The size of the buffer. */
+    size_t length;   /* The number of characters in the buffer. */
+} printbuffer;
+
+/**
+ * Returns the largest potential member in every set of the calculator in use.
+ *
+ * @return The largest potential member.
+ */
+long getLargestMember();
+
+/**
+ * Allocates the given set with no members.
+ * Only the array of containers is allocated; every container is allocated once it has members.
+ *
+ * @param setA The set to allocate.
+ * @return TRUE if the set has been allocated, FALSE if the memory allocation failed.
+ */
+boolean createSet(set *setA);
+
+/**
+ * Frees the memory used by the given set.
+ *
+ * @param setA The set to free.
+ */
+void freeSet(set *setA);
+
+/**
+ * Replaces the members of the given set with a copy of the members of another set.
+ * The copy is built separately, so the previous members are only freed once it is complete.
+ *
+ * @param source The set to copy.
+ * @param result The set to store the copy in.
+ * @return TRUE if the set has been copied, FALSE if the memory allocation failed.
+ */
+boolean copySet(const set *source, set *result);
+
 /**
  * Checks if the given set is empty.
  *
  * @param setA The set to check.
  * @return TRUE if the set is empty, FALSE otherwise.
  */
-boolean isSetEmpty(const set setA);
+boolean isSetEmpty(const set *setA);
+
+/**
+ * Returns the number of members in the given set.
+ *
+ * @param setA The set to count the members of.
+ * @return The number of members in the set.
+ */
+unsigned long getCardinality(const set *setA);
+
+/**
+ * Returns the smallest member in the given set.
+ * Assumes the set is not empty.
+ *
+ * @param setA The set to check.
+ * @return The smallest member in the set.
+ */
+long getMinimum(const set *setA);
+
+/**
+ * Returns the largest member in the given set.
+ * Assumes the set is not empty.
+ *
+ * @param setA The set to check.
+ * @return The largest member in the set.
+ */
+long getMaximum(const set *setA);
+
+/**
+ * Removes every member from the given set.
+ * Keeps the memory of the array of containers, so the set can be filled again.
+ *
+ * @param setA The set to empty.
+ */
+void clearSet(set *setA);
+
+/**
+ * Adds the given container after every other container in the set.
+ * Assumes the container's key is larger than the key of every other container in the set.
+ * The set takes over the container's memory.
+ *
+ * @param setA The set to add the container to.
+ * @param target The container to add.
+ * @return TRUE if the container has been added, FALSE if the memory allocation failed.
+ */
+boolean appendContainer(set *setA, const container *target);
+
+/**
+ * Adds the given member to the given set.
+ * Creates the member's container (as an array container) if the set has no other member with the same key.
+ * Assumes the member is in the universe.
+ *
+ * @param setA The set to add the member to.
+ * @param member The member to add.
+ * @return TRUE if the member has been added, FALSE if the memory allocation failed.
+ */
+boolean addMember(set *setA, long member);
+
+/**
+ * Converts every container in the set to the kind which keeps its members in the least memory.
+ *
+ * @param setA The set to convert.
+ * @return TRUE if the set has been converted, FALSE if the memory allocation failed.
+ */
+boolean optimizeSet(set *setA);
 
 /**
  * Converts a non-empty set to its string representation and prints it.
  * Assumes the set is non-empty.
  * Every number is the set is separated by a comma and a space.
  * No more than 16 numbers shall occupy the same line.
+ * The string is built in the reusable buffer of the calculator in use, and written to its output sink with a single call (unless it is larger than 1 MiB).
  *
  * @param setA The set to print.
  */
-void printSetAsString(const set setA);
+void printSetAsString(const set *setA);
+
+/**
+ * Frees the memory of the output buffer used for printing sets, in the calculator in use.
+ */
+void freeOutputBuffer();
 
 #endif
@@ -0,0 +1,75 @@
+/*
+ * setcalc.h
+ * Includes the interface of the set calculator library (libsetcalc), for programs which run commands without the myset program.
+ *
+ * Each calculator has its own sets (SETA to SETF start out empty), command graph, output buffer and statistics,
+ * so any number of calculators can be used at once, as long as each one is only used by a single thread at a time.
+ * A calculator runs a single line at a time, exactly as the myset program runs a line of a script (in batch mode).
+ * Nothing is ever written to the standard output or the standard error: the printed sets go to the output sink,
+ * and the errors (with the number of the line) go to the error sink.
+ * If a memory allocation fails while a line runs, the line is abandoned instead of exiting the program.
+ *
+ * Name: Ariel Keren
+ * Course: C Lab, 20465
+ * Semester: 2024B
+ * Date: 18/10/2026
+ */
+
+#ifndef SETCALC_H
+#define SETCALC_H
+
+#include <stddef.h>
+
+/* Marks the functions below as the only ones the shared library exports (see the makefile). */
+#ifdef __GNUC__
+#define SETCALC_API __attribute__((visibility("default")))
+#else
+#define SETCALC_API
+#endif
+
+/* A set calculator (only used through the functions below). */
+typedef struct calculator calculator;
+
+/* Receives text written by a calculator (not null-terminated), along with the data given to createCalculator. */
+typedef void (*outputsink)(void *data, const char text[], size_t length);
+
+/* The result of running a line (see executeLine). */
+enum { CALCULATOR_SUCCESS,
+       CALCULATOR_INVALID,
+       CALCULATOR_FAILED,
+       CALCULATOR_STOPPED,
+       CALCULATOR_OUT_OF_MEMORY };
+
+/**
+ * Allocates a calculator, with SETA to SETF (empty).
+ *
+ * @param universe The number of potential members in every set (between 1 and 2147483647).
+ * @param output Receives everything the commands print.
+ * @param errors Receives every error message (a whole line at a time).
+ * @param data Passed to both sinks.
+ * @return The calculator, or NULL if the universe is out of range or the memory allocation failed.
+ */
+SETCALC_API calculator *createCalculator(long universe, outputsink output, outputsink errors, void *data);
+
+/**
+ * Runs a single line (without its newline character), and writes out everything it prints before returning.
+ * The line does not have to be null-terminated.
+ *
+ * @param context The calculator to run the line in.
+ * @param line The line to run.
+ * @param length The number of characters in the line.
+ * @return CALCULATOR_SUCCESS if the line has run (or it is blank),
+ *         CALCULATOR_INVALID if it is not a valid command, CALCULATOR_FAILED if the command could not be executed
+ *         (e.g. it refers to a set which is not defined), CALCULATOR_STOPPED if it is the stop command (more lines can still run),
+ *         or CALCULATOR_OUT_OF_MEMORY if a memory allocation has failed (the calculator can then only be freed, and every further line gets this result).
+ */
+SETCALC_API int executeLine(calculator *context, const char line[], size_t length);
+
+/**
+ * Frees the calculator, along with every set in it.
+ *
+ * @param context The calculator to free.
+ */
+SETCALC_API void freeCalculator(calculator *context);
+
+#endif
@@ -0,0 +1,571 @@
+/*
+ * snapshot.c
+ * Includes functions for saving every set to a binary file, and for loading the sets back from it.
+ * Saved states are written through a large buffer, which is checksummed (Fletcher) as it is written out.
+ * Loaded states are mapped into memory, checked once, and then used in place by borrowed containers.
+ *
+ * Name: Ariel Keren
+ * Course: C Lab, 20465
+ * Semester: 2024B
+ * Date: 18/10/2026
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include "snapshot.h"
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "calculator.h"
+#include "container.h"
+#include "globals.h"
+#include "graph.h"
+#include "registry.h"
+#include "set.h"
+#include "setUtils.h"
+#include "utils.h"
+
+/* The header at the start of every saved state. */
+typedef struct {
+    char magic[SNAPSHOT_MAGIC_LENGTH]; /* Identifies the file as a saved state. */
+    uint32_t version;                  /* The version of the format. */
+    uint32_t byteOrder;                /* SNAPSHOT_BYTE_ORDER, in the byte order of the machine which saved the state. */
+    uint32_t sectionSize;              /* The size of a section of a bitmap container, in bytes. */
+    uint32_t setCount;                 /* The number of sets in the state. */
+    uint32_t lengthLow;                /* The number of bytes after the header (the low 32 bits). */
+    uint32_t lengthHigh;               /* The number of bytes after the header (the high 32 bits). */
+    uint32_t firstSum;                 /* The first sum of the checksum of the bytes after the header. */
+    uint32_t secondSum;                /* The second sum of the checksum of the bytes after the header. */
+} snapshotheader;
+
+/* The start of a set's record (followed by its name, its containers, and the members of each container). */
+typedef struct {
+    uint32_t nameLength;     /* The number of characters in the name of the set. */
+    uint32_t containerCount; /* The number of containers in the set. */
+} snapshotset;
+
+/* A container in a set's record. */
+typedef struct {
+    uint32_t type;        /* The kind of the container. */
+    uint32_t key;         /* The key of the container. */
+    uint32_t cardinality; /* The number of members in the container. */
+    uint32_t count;       /* The number of values (array containers) or runs (run containers). */
+} snapshotcontainer;
+
+/* Writes a saved state through a buffer. */
+typedef struct {
+    FILE *file;            /* The file to write to. */
+    unsigned char *buffer; /* The bytes which have not been written yet. */
+    size_t used;           /* The number of bytes in the buffer. */
+    unsigned long offset;  /* The number of bytes after the header so far (including the buffer). */
+    uint32_t firstSum;     /* The first sum of the checksum of the bytes written so far. */
+    uint32_t secondSum;    /* The second sum of the checksum of the bytes written so far. */
+} snapshotwriter;
+
+/* Reads the records of a mapped saved state. */
+typedef struct {
+    const unsigned char *data; /* The bytes after the header. */
+    size_t length;             /* The number of bytes after the header. */
+    size_t offset;             /* The number of bytes which have been read. */
+} snapshotreader;
+
+/* Written before the records (in place of the header) and between them, for alignment. */
+static const unsigned char zeros[SNAPSHOT_HEADER_SIZE];
+/**
+ * Adds the given words to the checksum (Fletcher's checksum, with 32-bit sums).
+ *
+ * @param firstSum The first sum of the checksum (the sum of the words).
+ * @param secondSum The second sum of the checksum (the sum of the first sums).
+ * @param words The words to add.
+ * @param count The number of words to add.
+ */
+static void addChecksum(uint32_t *firstSum, uint32_t *secondSum, const uint32_t words[], size_t count) {
+    uint32_t first;  /* The first sum so far. */
+    uint32_t second; /* The second sum so far. */
+    size_t index;    /* Current index in the words. */
+
+    first = *firstSum;
+    second = *secondSum;
+
+    /* The sums wrap around (unsigned arithmetic). */
+    for (index = FIRST_INDEX; index < count; index++) {
+        first += words[index];
+        second += first;
+    }
+
+    *firstSum = first;
+    *secondSum = second;
+}
+
+/**
+ * Returns the number of bytes the members of a container take.
+ *
+ * @param type The kind of the container.
+ * @param count The number of values (array containers) or runs (run containers).
+ * @return The number of bytes the members take.
+ */
+static size_t getMembersSize(uint32_t type, uint32_t count) {
+    switch (type) {
+        case ARRAY_CONTAINER:
+            return count * sizeof(uint16_t);
+        case BITMAP_CONTAINER:
+            return BITMAP_BYTES;
+        default:
+            return count * sizeof(valuerun);
+    }
+}
+
+/**
+ * Writes the buffer of the writer to its file, and adds it to the checksum.
+ * Assumes the number of bytes in the buffer is a multiple of 4.
+ *
+ * @param writer The writer to flush.
+ * @return TRUE if the buffer has been written, FALSE otherwise.
+ */
+static boolean flushWriter(snapshotwriter *writer) {
+    size_t used; /* The number of bytes in the buffer. */
+
+    used = writer->used;
+    writer->used = STARTING_VALUE;
+    addChecksum(&writer->firstSum, &writer->secondSum, (const uint32_t *)writer->buffer, used / sizeof(uint32_t));
+    return fwrite(writer->buffer, SINGLE_CHARACTER, used, writer->file) == used;
+}
+
+/**
+ * Writes the given bytes through the buffer of the writer.
+ *
+ * @param writer The writer to write with.
+ * @param data The bytes to write.
+ * @param size The number of bytes to write.
+ * @return TRUE if the bytes have been written, FALSE otherwise.
+ */
+static boolean writeBytes(snapshotwriter *writer, const void *data, size_t size) {
+    const unsigned char *bytes; /* The bytes which are left to write. */
+    size_t part;                /* The number of bytes which fit in the buffer. */
+
+    bytes = data;
+    writer->offset += size;
+
+    /* Fill the buffer, and write it out whenever it is full (so the checksum always sees whole words). */
+    while (size != EMPTY) {
+        part = SNAPSHOT_BUFFER_SIZE - writer->used < size ? SNAPSHOT_BUFFER_SIZE - writer->used : size;
+        memcpy(writer->buffer + writer->used, bytes, part);
+        writer->used += part;
+        bytes += part;
+        size -= part;
+
+        if (writer->used == SNAPSHOT_BUFFER_SIZE && !flushWriter(writer)) {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+/**
+ * Writes zeros until the number of bytes after the header is a multiple of the given alignment.
+ *
+ * @param writer The writer to write with.
+ * @param alignment The alignment (at most the size of the header).
+ * @return TRUE if the zeros have been written, FALSE otherwise.
+ */
+static boolean writePadding(snapshotwriter *writer, size_t alignment) {
+    return writeBytes(writer, zeros, (alignment - writer->offset % alignment) % alignment);
+}
+
+/**
+ * Writes the record of the given set.
+ *
+ * @param writer The writer to write with.
+ * @param entry The set to write.
+ * @return TRUE if the record has been written, FALSE otherwise.
+ */
+static boolean writeSet(snapshotwriter *writer, const namedset *entry) {
+    snapshotset record;           /* The start of the record. */
+    snapshotcontainer descriptor; /* The current container of the record. */
+    const container *current;     /* The current container of the set. */
+    size_t index;                 /* Current index in the containers. */
+
+    record.nameLength = (uint32_t)entry->length;
+    record.containerCount = (uint32_t)entry->members.count;
+
+    if (!writePadding(writer, SNAPSHOT_ALIGNMENT) || !writeBytes(writer, &record, sizeof(record)) || !writeBytes(writer, entry->name, entry->length)) {
+        return FALSE;
+    }
+
+    /* Write every container (without its members), so they can be read as a single array. */
+    if (!writePadding(writer, SNAPSHOT_ALIGNMENT)) {
+        return FALSE;
+    }
+
+    for (index = FIRST_INDEX; index < entry->members.count; index++) {
+        current = &entry->members.containers[index];
+        descriptor.type = current->type;
+        descriptor.key = current->key;
+        descriptor.cardinality = current->cardinality;
+        descriptor.count = current->count;
+
+        if (!writeBytes(writer, &descriptor, sizeof(descriptor))) {
+            return FALSE;
+        }
+    }
+
+    /* Write the members of every container, keeping bitmaps aligned to a cache line. */
+    for (index = FIRST_INDEX; index < entry->members.count; index++) {
+        current = &entry->members.containers[index];
+
+        if (!writePadding(writer, current->type == BITMAP_CONTAINER ? CACHE_LINE_SIZE : SNAPSHOT_ALIGNMENT)) {
+            return FALSE;
+        }
+
+        if (!writeBytes(writer, current->data.values, getMembersSize(current->type, current->count))) {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+/**
+ * Saves every set in the registry to the file with the given path.
+ * The file is written under a temporary name first, and only replaces the previous file once it is complete.
+ * Assumes the latest version of every set has been stored in the set itself.
+ * Exits the program if the memory allocation fails.
+ *
+ * @param sets The registry of every defined set.
+ * @param path The path of the file to save the sets to.
+ * @return NULL if the sets have been saved, or the reason they could not be saved.
+ */
+const char *saveState(const setregistry *sets, const char path[]) {
+    char *temporaryPath;     /* The path the file is written to until it is complete. */
+    snapshotwriter writer;   /* Writes the records. */
+    snapshotheader header;   /* The header of the file. */
+    const namedset *current; /* The current set. */
+    size_t slot;             /* The slot of the next set in the registry. */
+    boolean isWritten;       /* Has everything been written so far? */
+
+    temporaryPath = malloc(strlen(path) + sizeof(TEMPORARY_SUFFIX));
+    writer.buffer = malloc(SNAPSHOT_BUFFER_SIZE);
+
+    if (temporaryPath == NULL || writer.buffer == NULL) {
+        failMemory("Failed to allocate memory for the saved state.");
+    }
+
+    strcpy(temporaryPath, path);
+    strcat(temporaryPath, TEMPORARY_SUFFIX);
+
+    /* Writing to another file keeps a loaded state intact (it may be mapped from the same path). */
+    if ((writer.file = fopen(temporaryPath, "wb")) == NULL) {
+        free(temporaryPath);
+        free(writer.buffer);
+        return "Failed to open the file.";
+    }
+
+    writer.used = STARTING_VALUE;
+    writer.offset = STARTING_VALUE;
+    writer.firstSum = writer.secondSum = STARTING_VALUE;
+
+    /* Leave room for the header, which is only known once every record has been written. */
+    isWritten = fwrite(zeros, SINGLE_CHARACTER, SNAPSHOT_HEADER_SIZE, writer.file) == SNAPSHOT_HEADER_SIZE;
+    slot = FIRST_INDEX;
+
+    while (isWritten && (current = nextEntry(sets, &slot)) != NULL) {
+        isWritten = writeSet(&writer, current);
+    }
+
+    isWritten = isWritten && writePadding(&writer, SNAPSHOT_ALIGNMENT) && flushWriter(&writer);
+
+    /* Fill the header and write it over the room left for it. */
+    if (isWritten) {
+        memset(&header, EMPTY, sizeof(header));
+        memcpy(header.magic, SNAPSHOT_MAGIC, SNAPSHOT_MAGIC_LENGTH);
+        header.version = SNAPSHOT_VERSION;
+        header.byteOrder = (uint32_t)SNAPSHOT_BYTE_ORDER;
+        header.sectionSize = sizeof(setsection);
+        header.setCount = (uint32_t)sets->count;
+        header.lengthLow = (uint32_t)writer.offset;
+        /* Shift in two steps, since unsigned long may only have 32 bits. */
+        header.lengthHigh = (uint32_t)(writer.offset >> CONTAINER_BITS >> CONTAINER_BITS);
+        header.firstSum = writer.firstSum;
+        header.secondSum = writer.secondSum;
+        isWritten = !fseek(writer.file, STARTING_VALUE, SEEK_SET) && fwrite(&header, SINGLE_CHARACTER, sizeof(header), writer.file) == sizeof(header);
+    }
+
+    isWritten = !fclose(writer.file) && isWritten;
+
+    /* Replace the previous file only once the new one is complete. */
+    if (!isWritten || rename(temporaryPath, path)) {
+        remove(temporaryPath);
+        isWritten = FALSE;
+    }
+
+    free(temporaryPath);
+    free(writer.buffer);
+    return isWritten ? NULL : "Failed to write the file.";
+}
+
+/**
+ * Returns the next bytes of the saved state, after skipping to the given alignment.
+ *
+ * @param reader The reader to read with.
+ * @param size The number of bytes to read.
+ * @param alignment The alignment of the bytes.
+ * @return The first byte, or NULL if there are not enough bytes left.
+ */
+static const void *readBytes(snapshotreader *reader, size_t size, size_t alignment) {
+    const unsigned char *bytes; /* The first byte. */
+
+    reader->offset += (alignment - reader->offset % alignment) % alignment;
+
+    if (reader->offset > reader->length || size > reader->length - reader->offset) {
+        return NULL;
+    }
+
+    bytes = reader->data + reader->offset;
+    reader->offset += size;
+    return bytes;
+}
+
+/**
+ * Checks if a container of a saved state is valid.
+ *
+ * @param descriptor The container to check.
+ * @param previousKey The key of the previous container in the set (-1 for the first one).
+ * @return TRUE if the container is valid, FALSE otherwise.
+ */
+static boolean isValidContainer(const snapshotcontainer *descriptor, long previousKey) {
+    /* The keys should be increasing, and every container should have at least one member. */
+    if ((long)descriptor->key <= previousKey || descriptor->key >= CONTAINER_VALUES || descriptor->cardinality == EMPTY || descriptor->cardinality > CONTAINER_VALUES) {
+        return FALSE;
+    }
+
+    switch (descriptor->type) {
+        case ARRAY_CONTAINER:
+            return descriptor->count == descriptor->cardinality && descriptor->count <= ARRAY_MAX_CARDINALITY;
+        case BITMAP_CONTAINER:
+            return TRUE;
+        case RUN_CONTAINER:
+            return descriptor->count != EMPTY && descriptor->count <= descriptor->cardinality;
+        default:
+            return FALSE;
+    }
+}
+
+/**
+ * Reads the record of the next set in the saved state.
+ * The containers of the set are borrowed from the saved state (they are not copied).
+ *
+ * @param reader The reader to read with.
+ * @param name Receives the name of the set (pointing into the saved state).
+ * @param members The set to add the containers to (NULL to only check the record).
+ * @return NULL if the record has been read, or the reason it is invalid.
+ */
+static const char *readSet(snapshotreader *reader, setname *name, set *members) {
+    const snapshotset *record;            /* The start of the record. */
+    const char *text;                     /* The name of the set. */
+    const snapshotcontainer *descriptors; /* The containers of the set. */
+    const void *data;                     /* The members of the current container. */
+    container current;                    /* The current container, borrowing its members. */
+    uint32_t index;                       /* Current index in the containers. */
+    long previousKey;                     /* The key of the previous container. */
+
+    record = readBytes(reader, sizeof(snapshotset), SNAPSHOT_ALIGNMENT);
+
+    /* Every set has at most one container for each key. */
+    if (record == NULL || record->containerCount > CONTAINER_VALUES) {
+        return "The saved state is corrupted.";
+    }
+
+    text = readBytes(reader, record->nameLength, SINGLE_CHARACTER);
+
+    if (text == NULL || !isSetName(text, record->nameLength)) {
+        return "The saved state is corrupted.";
+    }
+
+    nameSet(name, text, record->nameLength);
+
+    if ((descriptors = readBytes(reader, record->containerCount * sizeof(snapshotcontainer), SNAPSHOT_ALIGNMENT)) == NULL) {
+        return "The saved state is corrupted.";
+    }
+
+    previousKey = INVALID_INDEX;
+
+    /* Check every container, and borrow its members. */
+    for (index = FIRST_INDEX; index < record->containerCount; index++) {
+        if (!isValidContainer(&descriptors[index], previousKey)) {
+            return "The saved state is corrupted.";
+        }
+
+        data = readBytes(reader, getMembersSize(descriptors[index].type, descriptors[index].count), descriptors[index].type == BITMAP_CONTAINER ? CACHE_LINE_SIZE : SNAPSHOT_ALIGNMENT);
+
+        if (data == NULL) {
+            return "The saved state is corrupted.";
+        }
+
+        borrowContainer(&current, descriptors[index].type, descriptors[index].key, descriptors[index].cardinality, descriptors[index].count, data);
+
+        /* The members are used in place, so they should be laid out exactly as the operations expect (the checksum only catches accidental damage). */
+        if (!isConsistentContainer(&current)) {
+            return "The saved state is corrupted.";
+        }
+
+        previousKey = descriptors[index].key;
+
+        if (members != NULL && !appendContainer(members, &current)) {
+            failMemory("Failed to allocate memory for the saved state.");
+        }
+    }
+
+    /* Every member should be in the universe (only the last container has to be checked). */
+    if (record->containerCount != EMPTY && (unsigned long)previousKey * CONTAINER_VALUES + findMaximumValue(&current) > (unsigned long)getLargestMember()) {
+        return "The saved state has members outside the universe.";
+    }
+
+    return NULL;
+}
+
+/**
+ * Checks if the mapped file is a valid saved state: its header, its checksum and every record in it.
+ *
+ * @param mapping The mapped file.
+ * @param length The number of bytes in the file.
+ * @return NULL if the saved state is valid, or the reason it is invalid.
+ */
+static const char *checkState(const void *mapping, size_t length) {
+    const snapshotheader *header; /* The header of the file. */
+    snapshotreader reader;        /* Reads the records. */
+    uint32_t firstSum;            /* The first sum of the checksum of the records. */
+    uint32_t secondSum;           /* The second sum of the checksum of the records. */
+    uint32_t index;               /* Current index in the sets. */
+    setname name;                 /* The name of the current set (unused). */
+    const char *error;            /* The reason the current record is invalid. */
+
+    header = mapping;
+
+    if (memcmp(header->magic, SNAPSHOT_MAGIC, SNAPSHOT_MAGIC_LENGTH)) {
+        return "The file is not a saved state.";
+    }
+
+    /* The members are used in place, so they should have been saved by a machine which lays them out the same way. */
+    if (header->version != SNAPSHOT_VERSION || header->byteOrder != (uint32_t)SNAPSHOT_BYTE_ORDER || header->sectionSize != sizeof(setsection)) {
+        return "The saved state was made by an incompatible version.";
+    }
+
+    reader.data = (const unsigned char *)mapping + SNAPSHOT_HEADER_SIZE;
+    reader.length = length - SNAPSHOT_HEADER_SIZE;
+    reader.offset = STARTING_VALUE;
+
+    if (header->lengthLow != (uint32_t)reader.length || header->lengthHigh != (uint32_t)((unsigned long)reader.length >> CONTAINER_BITS >> CONTAINER_BITS) || reader.length % SNAPSHOT_ALIGNMENT != NO_REMAINDER) {
+        return "The saved state is corrupted.";
+    }
+
+    firstSum = secondSum = STARTING_VALUE;
+    addChecksum(&firstSum, &secondSum, (const uint32_t *)reader.data, reader.length / sizeof(uint32_t));
+
+    if (firstSum != header->firstSum || secondSum != header->secondSum) {
+        return "The saved state is corrupted.";
+    }
+
+    /* Check every record before any set is replaced. */
+    for (index = FIRST_INDEX; index < header->setCount; index++) {
+        if ((error = readSet(&reader, &name, NULL)) != NULL) {
+            return error;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Replaces every set in the registry with the sets saved in the file with the given path.
+ * The whole file is checked before any set is replaced, so an invalid file leaves the sets as they are.
+ * The file stays mapped until another state is loaded (or until the calculator is freed).
+ * Frees the command graph (every set gets a new generation).
+ * Exits the program if the memory allocation fails.
+ *
+ * @param sets The registry of every defined set.
+ * @param path The path of the file to load the sets from.
+ * @return NULL if the sets have been loaded, or the reason they could not be loaded.
+ */
+const char *loadState(setregistry *sets, const char path[]) {
+    int file;              /* The descriptor of the file. */
+    struct stat status;    /* The size of the file. */
+    size_t length;         /* The number of bytes in the file. */
+    void *mapping;         /* The mapped file. */
+    const char *error;     /* The reason the file is not a valid saved state. */
+    snapshotreader reader; /* Reads the records. */
+    uint32_t index;        /* Current index in the sets. */
+    setname name;          /* The name of the current set. */
+    set members;           /* The members of the current set. */
+
+    if ((file = open(path, O_RDONLY)) < EMPTY) {
+        return "Failed to open the file.";
+    }
+
+    if (fstat(file, &status) || status.st_size < SNAPSHOT_HEADER_SIZE) {
+        close(file);
+        return "The file is not a saved state.";
+    }
+
+    /* The mapping stays valid after the file is closed. */
+    length = (size_t)status.st_size;
+    mapping = mmap(NULL, length, PROT_READ, MAP_PRIVATE, file, STARTING_VALUE);
+    close(file);
+
+    if (mapping == MAP_FAILED) {
+        return "Failed to read the file.";
+    }
+
+    if ((error = checkState(mapping, length)) != NULL) {
+        munmap(mapping, length);
+        return error;
+    }
+
+    /* Nothing refers to the previous sets (or to the previous state) once the graph and the registry are freed. */
+    freeVersions();
+    freeRegistry(sets);
+    freeState();
+    getCalculator()->mappedState = mapping;
+    getCalculator()->mappedLength = length;
+
+    if (!createRegistry(sets) || !createSet(&members)) {
+        failMemory("Failed to allocate memory for the sets.");
+    }
+
+    reader.data = (const unsigned char *)mapping + SNAPSHOT_HEADER_SIZE;
+    reader.length = length - SNAPSHOT_HEADER_SIZE;
+    reader.offset = STARTING_VALUE;
+
+    /* Define every set with the containers of its record (the members are left empty by every version). */
+    for (index = FIRST_INDEX; index < ((const snapshotheader *)mapping)->setCount; index++) {
+        readSet(&reader, &name, &members);
+        recordMembers(sets, &name, &members);
+    }
+
+    freeSet(&members);
+    commitVersions();
+    return NULL;
+}
+
+/**
+ * Unmaps the last state loaded into the calculator in use.
+ * Assumes no set uses its containers anymore.
+ */
+void freeState() {
+    calculator *context; /* The calculator in use. */
+
+    context = getCalculator();
+
+    if (context->mappedState != NULL) {
+        munmap(context->mappedState, context->mappedLength);
+        context->mappedState = NULL;
+        context->mappedLength = EMPTY;
+    }
+}
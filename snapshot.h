@@ -0,0 +1,54 @@
+/*
+ * snapshot.h
+ * Includes the prototypes of all the functions in snapshot.c.
+ *
+ * A saved state keeps every set in the registry in a binary file, laid out the same way as the sets are in memory:
+ * - A header of 64 bytes, with the magic, the version of the format, the byte order and a checksum of the rest of the file.
+ * - A record for every set: its name, its containers, and then the members of each container.
+ * The members of bitmap containers start at a cache line, and every other record starts at a multiple of 8 bytes.
+ * A loaded state is mapped into memory, and its containers are used in place (nothing is parsed or copied).
+ *
+ * Name: Ariel Keren
+ * Course: C Lab, 20465
+ * Semester: 2024B
+ * Date: 18/10/2026
+ */
+
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "globals.h"
+#include "registry.h"
+
+/**
+ * Saves every set in the registry to the file with the given path.
+ * The file is written under a temporary name first, and only replaces the previous file once it is complete.
+ * Assumes the latest version of every set has been stored in the set itself.
+ * Exits the program if the memory allocation fails.
+ *
+ * @param sets The registry of every defined set.
+ * @param path The path of the file to save the sets to.
+ * @return NULL if the sets have been saved, or the reason they could not be saved.
+ */
+const char *saveState(const setregistry *sets, const char path[]);
+
+/**
+ * Replaces every set in the registry with the sets saved in the file with the given path.
+ * The whole file is checked before any set is replaced, so an invalid file leaves the sets as they are.
+ * The file stays mapped until another state is loaded (or until the calculator is freed).
+ * Frees the command graph (every set gets a new generation).
+ * Exits the program if the memory allocation fails.
+ *
+ * @param sets The registry of every defined set.
+ * @param path The path of the file to load the sets from.
+ * @return NULL if the sets have been loaded, or the reason they could not be loaded.
+ */
+const char *loadState(setregistry *sets, const char path[]);
+
+/**
+ * Unmaps the last state loaded into the calculator in use.
+ * Assumes no set uses its containers anymore.
+ */
+void freeState();
+
+#endif
@@ -0,0 +1,244 @@
+/*
+ * stats.c
+ * Includes functions for timing the phases of every command, and for writing the statistics out.
+ * Timers read a monotonic clock, and each measured time is added to a counter, a total and a histogram (no memory is allocated).
+ * SIGUSR1 only marks that the statistics have been requested, and they are written once the current command is done.
+ *
+ * Name: Ariel Keren
+ * Course: C Lab, 20465
+ * Semester: 2024B
+ * Date: 18/10/2026
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include "stats.h"
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "calculator.h"
+#include "globals.h"
+#include "graph.h"
+
+#ifndef NO_STATS
+
+/* Have the statistics been requested (by SIGUSR1) since they have last been written? */
+static volatile sig_atomic_t isRequested = FALSE;
+/* The file to write the statistics to (NULL for the standard error). */
+static const char *statisticsPath = NULL;
+
+/**
+ * Starts measuring a phase.
+ *
+ * @param timer The timer to start.
+ */
+void startTimer(statstimer *timer) {
+    struct timespec now; /* The current time. */
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    timer->seconds = now.tv_sec;
+    timer->nanoseconds = now.tv_nsec;
+}
+
+/**
+ * Stops measuring a phase (the time it took is kept in the timer until it is recorded).
+ *
+ * @param timer The timer to stop.
+ */
+void stopTimer(statstimer *timer) {
+    struct timespec now; /* The current time. */
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    timer->elapsed = (unsigned long)(now.tv_sec - timer->seconds) * NANOSECONDS_PER_SECOND + now.tv_nsec - timer->nanoseconds;
+}
+
+/**
+ * Adds the time a stopped timer has measured to the statistics of the given phase and operation, in the calculator in use.
+ *
+ * @param timer The stopped timer.
+ * @param phase The phase which has been measured (e.g. READ_PHASE).
+ * @param operation The operation of the command (INVALID_OPERATION for a line which is not a valid command).
+ */
+void recordTimer(const statstimer *timer, int phase, int operation) {
+    phasestatistics *entry; /* The statistics to add the time to. */
+    unsigned long rest;     /* The time, shifted right once for every bucket passed. */
+    int bucket;             /* The bucket of the time (the position of its highest set bit). */
+
+    entry = &getCalculator()->statistics.entries[phase][operation];
+    entry->count++;
+    entry->total += timer->elapsed;
+
+    /* Find the highest set bit (longer times all go to the last bucket). */
+    for (bucket = FIRST_INDEX, rest = timer->elapsed >> NEXT_INDEX_DIFFERENCE; rest != EMPTY && bucket < HISTOGRAM_BUCKETS - NEXT_INDEX_DIFFERENCE; bucket++) {
+        rest >>= NEXT_INDEX_DIFFERENCE;
+    }
+
+    entry->histogram[bucket]++;
+}
+
+/**
+ * Marks that the statistics have been requested (the handler of SIGUSR1).
+ *
+ * @param signalNumber The signal which has been received.
+ */
+static void requestStatistics(int signalNumber) {
+    (void)signalNumber;
+    isRequested = TRUE;
+}
+
+/**
+ * Writes text to a stream (the output of the statistics when they are written to a file or to the standard error).
+ *
+ * @param data The stream to write to.
+ * @param text The text to write.
+ * @param length The number of characters to write.
+ */
+static void writeToStream(void *data, const char text[], size_t length) {
+    fwrite(text, sizeof(char), length, (FILE *)data);
+}
+
+/**
+ * Writes the statistics to the file given to watchStatistics (replacing it), or to the standard error without one.
+ * Prints an error if the file cannot be written.
+ */
+static void writeStatisticsFile() {
+    FILE *output; /* The file to write the statistics to. */
+
+    /* Without a file, the statistics go to the standard error. */
+    if (statisticsPath == NULL) {
+        writeStatistics(writeToStream, stderr);
+        return;
+    }
+
+    if ((output = fopen(statisticsPath, "w")) != NULL) {
+        writeStatistics(writeToStream, output);
+        fflush(output);
+    }
+
+    if (output == NULL || ferror(output)) {
+        fprintf(stderr, "Error: Failed to write the statistics to %s.\n", statisticsPath);
+    }
+
+    if (output != NULL) {
+        fclose(output);
+    }
+}
+
+/**
+ * Writes the statistics to the file given to watchStatistics when the program exits (registered with atexit).
+ * Does nothing if they have already been written by closeStatistics, or if no calculator is in use.
+ */
+static void writeStatisticsOnExit() {
+    if (statisticsPath != NULL && getCalculator() != NULL) {
+        writeStatisticsFile();
+    }
+}
+
+/**
+ * Writes the statistics if they have been requested (by SIGUSR1) since the last check.
+ * The statistics are written to the file given to watchStatistics, or to the standard error without one.
+ */
+void checkStatistics() {
+    if (isRequested) {
+        isRequested = FALSE;
+        writeStatisticsFile();
+    }
+}
+
+/**
+ * Writes the statistics to the file given to watchStatistics one last time (if there is one), and stops writing them on exit.
+ * Called before the calculator in use is freed.
+ */
+void closeStatistics() {
+    if (statisticsPath != NULL) {
+        writeStatisticsFile();
+        statisticsPath = NULL;
+    }
+}
+
+#endif
+
+/**
+ * Writes the statistics of every phase and operation which the calculator in use has measured, along with the statistics of its result cache.
+ * Each line is "<phase> <operation> <count> <total nanoseconds>" followed by the histogram,
+ * where bucket i counts the latencies of 2^i to 2^(i+1)-1 nanoseconds (and the last bucket also counts every longer latency).
+ * The cache is written as "cache hits <count>" and "cache misses <count>".
+ *
+ * @param output Receives the statistics, a line at a time.
+ * @param data Passed to the output.
+ * @return NULL if the statistics have been written, or the reason they could not be written.
+ */
+const char *writeStatistics(outputsink output, void *data) {
+#ifndef NO_STATS
+    const phasestatistics *entry;      /* The statistics of the current phase and operation. */
+    char line[STATISTICS_LINE_LENGTH]; /* The current line. */
+    size_t length;                     /* The length of the current line. */
+    unsigned long hits;                /* The number of commands which have reused an existing result. */
+    unsigned long misses;              /* The number of commands which have not. */
+    int phase;                         /* Current index in the phases. */
+    int operation;                     /* Current index in the operations. */
+    int bucket;                        /* Current index in the histogram. */
+
+    strcpy(line, "# phase operation count total_ns histogram (bucket i: 2^i to 2^(i+1)-1 ns)\n");
+    output(data, line, strlen(line));
+
+    /* Only write the phases and operations which have been measured. */
+    for (phase = FIRST_INDEX; phase < NUMBER_OF_PHASES; phase++) {
+        for (operation = FIRST_INDEX; operation <= INVALID_OPERATION; operation++) {
+            entry = &getCalculator()->statistics.entries[phase][operation];
+
+            if (entry->count == EMPTY) {
+                continue;
+            }
+
+            length = sprintf(line, "%s %s %lu %.0f", PHASES[phase], operation == INVALID_OPERATION ? INVALID_OPERATION_NAME : OPERATIONS[operation], entry->count, entry->total);
+
+            for (bucket = FIRST_INDEX; bucket < HISTOGRAM_BUCKETS; bucket++) {
+                length += sprintf(line + length, " %lu", entry->histogram[bucket]);
+            }
+
+            line[length++] = '\n';
+            output(data, line, length);
+        }
+    }
+
+    getCacheStatistics(&hits, &misses);
+    length = sprintf(line, "cache hits %lu\ncache misses %lu\n", hits, misses);
+    output(data, line, length);
+    return NULL;
+#else
+    (void)output;
+    (void)data;
+    return "The statistics have been compiled out of the program.";
+#endif
+}
+
+/**
+ * Writes the statistics to the given file (replacing it) when the program exits, and whenever SIGUSR1 is received.
+ * Without a file, the statistics are only written to the standard error when SIGUSR1 is received.
+ *
+ * @param path The path of the file to write the statistics to (NULL for none).
+ */
+void watchStatistics(const char path[]) {
+#ifndef NO_STATS
+    struct sigaction action; /* The handler of SIGUSR1. */
+
+    statisticsPath = path;
+
+    /* The statistics are written once the current command is done (a read interrupted by the signal is retried by the reader). */
+    action.sa_handler = requestStatistics;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = EMPTY;
+    sigaction(SIGUSR1, &action, NULL);
+
+    if (path != NULL) {
+        atexit(writeStatisticsOnExit);
+    }
+#else
+    (void)path;
+#endif
+}
@@ -0,0 +1,108 @@
+/*
+ * stats.h
+ * Includes the prototypes of all the functions in stats.c.
+ *
+ * Every command is timed in 4 phases: reading its line, validating it, executing it, and computing the set operations it leads to (the kernels).
+ * Each phase keeps, for every operation, the number of commands, their total time, and a histogram of their latencies (by powers of 2 nanoseconds).
+ * The statistics can be compiled out entirely by defining NO_STATS (e.g. make DEFINES=-DNO_STATS), which leaves every timer empty.
+ *
+ * Name: Ariel Keren
+ * Course: C Lab, 20465
+ * Semester: 2024B
+ * Date: 18/10/2026
+ */
+
+#ifndef STATS_H
+#define STATS_H
+
+#include "globals.h"
+#include "setcalc.h"
+
+/* Measures the time a single phase of a command takes. */
+typedef struct {
+    long seconds;          /* The seconds part of the time the phase started at. */
+    long nanoseconds;      /* The nanoseconds part of the time the phase started at. */
+    unsigned long elapsed; /* The time the phase took, in nanoseconds (once stopped). */
+} statstimer;
+
+#ifndef NO_STATS
+
+/* The statistics of a single phase of a single operation. */
+typedef struct {
+    unsigned long count;                        /* The number of times the phase has been measured. */
+    double total;                               /* The total time of the phase, in nanoseconds. */
+    unsigned long histogram[HISTOGRAM_BUCKETS]; /* The number of times the phase has taken 2^i to 2^(i+1)-1 nanoseconds (bucket i). */
+} phasestatistics;
+
+/* The statistics of every phase of every operation (every calculator has its own, see calculator.h). */
+typedef struct {
+    phasestatistics entries[NUMBER_OF_PHASES][NUMBER_OF_OPERATIONS + NEXT_INDEX_DIFFERENCE]; /* By phase and by operation (lines which are not valid commands last). */
+} statisticstable;
+
+/**
+ * Starts measuring a phase.
+ *
+ * @param timer The timer to start.
+ */
+void startTimer(statstimer *timer);
+
+/**
+ * Stops measuring a phase (the time it took is kept in the timer until it is recorded).
+ *
+ * @param timer The timer to stop.
+ */
+void stopTimer(statstimer *timer);
+
+/**
+ * Adds the time a stopped timer has measured to the statistics of the given phase and operation, in the calculator in use.
+ *
+ * @param timer The stopped timer.
+ * @param phase The phase which has been measured (e.g. READ_PHASE).
+ * @param operation The operation of the command (INVALID_OPERATION for a line which is not a valid command).
+ */
+void recordTimer(const statstimer *timer, int phase, int operation);
+
+/**
+ * Writes the statistics if they have been requested (by SIGUSR1) since the last check.
+ * The statistics are written to the file given to watchStatistics, or to the standard error without one.
+ */
+void checkStatistics();
+
+/**
+ * Writes the statistics to the file given to watchStatistics one last time (if there is one), and stops writing them on exit.
+ * Called before the calculator in use is freed.
+ */
+void closeStatistics();
+
+#else
+
+/* Without statistics, the timers are never read (they are only mentioned, so they are not unused). */
+#define startTimer(timer) ((void)(timer))
+#define stopTimer(timer) ((void)(timer))
+#define recordTimer(timer, phase, operation) ((void)(timer))
+#define checkStatistics() ((void)EMPTY)
+#define closeStatistics() ((void)EMPTY)
+
+#endif
+
+/**
+ * Writes the statistics of every phase and operation which the calculator in use has measured, along with the statistics of its result cache.
+ * Each line is "<phase> <operation> <count> <total nanoseconds>" followed by the histogram,
+ * where bucket i counts the latencies of 2^i to 2^(i+1)-1 nanoseconds (and the last bucket also counts every longer latency).
+ * The cache is written as "cache hits <count>" and "cache misses <count>".
+ *
+ * @param output Receives the statistics, a line at a time.
+ * @param data Passed to the output.
+ * @return NULL if the statistics have been written, or the reason they could not be written.
+ */
+const char *writeStatistics(outputsink output, void *data);
+
+/**
+ * Writes the statistics of the calculator in use to the given file (replacing it) when the program exits, and whenever SIGUSR1 is received.
+ * Without a file, the statistics are only written to the standard error when SIGUSR1 is received.
+ *
+ * @param path The path of the file to write the statistics to (NULL for none).
+ */
+void watchStatistics(const char path[]);
+
+#endif
@@ -0,0 +1,267 @@
+/*
+ * tasks.c
+ * Includes the functions of the helper threads, which run tasks from a single queue, in the order they are submitted.
+ * A single lock guards the queue and the state of every task, and the helpers are woken up when a task is queued.
+ * Every task which is done wakes up the threads which wait for tasks (each of them checks its own task again).
+ *
+ * Name: Ariel Keren
+ * Course: C Lab, 20465
+ * Semester: 2024B
+ * Date: 18/10/2026
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include "tasks.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "calculator.h"
+#include "globals.h"
+
+/* The helper threads and the queue of tasks they run. */
+typedef struct {
+    pthread_mutex_t lock;    /* Guards the queue, the state of every task and the stopping flag. */
+    pthread_cond_t isQueued; /* Signaled when a task is queued, or when the helpers should stop. */
+    pthread_cond_t isDone;   /* Signaled when a task is done. */
+    task *first;             /* The oldest task in the queue (NULL if empty). */
+    task *last;              /* The newest task in the queue (NULL if empty). */
+    pthread_t *helpers;      /* The helper threads. */
+    long helperCount;        /* The number of helper threads. */
+    boolean isStopping;      /* Should the helpers end once the queue is empty? */
+} taskpool;
+
+/* The helper threads of the program (without helpers, the lock is still used). */
+static taskpool pool = {PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, PTHREAD_COND_INITIALIZER, NULL, NULL, NULL, EMPTY, FALSE};
+
+/**
+ * Removes the task from the queue, while the lock is held.
+ *
+ * @param work The queued task to remove.
+ */
+static void unlinkTask(task *work) {
+    if (work->previous == NULL) {
+        pool.first = work->next;
+    } else {
+        work->previous->next = work->next;
+    }
+
+    if (work->next == NULL) {
+        pool.last = work->previous;
+    } else {
+        work->next->previous = work->previous;
+    }
+
+    work->previous = work->next = NULL;
+}
+
+/**
+ * Runs a task which has been taken from the queue (without the lock), with the calculator it has been submitted with.
+ * Then, marks it as done.
+ *
+ * @param work The task to run (already marked as running).
+ */
+static void runTask(task *work) {
+    calculator *previous; /* The calculator the thread has used before the task. */
+
+    previous = useCalculator(work->context);
+    work->run(work->data);
+    useCalculator(previous);
+
+    pthread_mutex_lock(&pool.lock);
+    work->state = DONE_TASK;
+    pthread_cond_broadcast(&pool.isDone);
+    pthread_mutex_unlock(&pool.lock);
+}
+
+/**
+ * Runs the tasks in the queue, from the oldest to the newest, until the helpers are stopped.
+ *
+ * @param data Not used.
+ * @return Nothing.
+ */
+static void *runHelper(void *data) {
+    task *work; /* The task taken from the queue. */
+
+    (void)data;
+    pthread_mutex_lock(&pool.lock);
+
+    while (pool.first != NULL || !pool.isStopping) {
+        if (pool.first == NULL) {
+            pthread_cond_wait(&pool.isQueued, &pool.lock);
+            continue;
+        }
+
+        work = pool.first;
+        unlinkTask(work);
+        work->state = RUNNING_TASK;
+        pthread_mutex_unlock(&pool.lock);
+        runTask(work);
+        pthread_mutex_lock(&pool.lock);
+    }
+
+    pthread_mutex_unlock(&pool.lock);
+    return NULL;
+}
+
+/**
+ * Fills the task with the function which runs its work (the task is idle until it is submitted).
+ *
+ * @param work The task to fill.
+ * @param run Runs the work.
+ * @param data Passed to the function which runs the work.
+ */
+void initializeTask(task *work, void (*run)(void *data), void *data) {
+    work->run = run;
+    work->data = data;
+    work->context = NULL;
+    work->state = IDLE_TASK;
+    work->previous = work->next = NULL;
+}
+
+/**
+ * Starts the given number of helper threads (once, before any task is submitted).
+ * Exits the program if the threads cannot be started.
+ *
+ * @param count The number of helper threads.
+ */
+void startHelpers(long count) {
+    long index; /* Current index in the helper threads. */
+
+    if (count <= EMPTY) {
+        return;
+    }
+
+    if ((pool.helpers = malloc(count * sizeof(pthread_t))) == NULL) {
+        /* Exit the program. */
+        fprintf(stderr, "Failed to allocate memory for the helper threads.\n");
+        exit(ERROR);
+    }
+
+    for (index = FIRST_INDEX; index < count; index++) {
+        if (pthread_create(&pool.helpers[index], NULL, runHelper, NULL) != SUCCESS) {
+            /* Exit the program. */
+            fprintf(stderr, "Failed to start the helper threads.\n");
+            exit(ERROR);
+        }
+
+        pool.helperCount++;
+    }
+}
+
+/**
+ * Returns the number of helper threads which run tasks.
+ *
+ * @return The number of helper threads (0 if every task runs on the thread which waits for it).
+ */
+long countHelpers() {
+    return pool.helperCount;
+}
+
+/**
+ * Adds the task to the end of the queue, so a helper thread can run it with the calculator the current thread uses.
+ * Without helper threads, the task stays queued until it is waited for.
+ *
+ * @param work The task to submit (idle or done).
+ */
+void submitTask(task *work) {
+    work->context = getCalculator();
+    pthread_mutex_lock(&pool.lock);
+    work->state = QUEUED_TASK;
+    work->previous = pool.last;
+    work->next = NULL;
+
+    if (pool.last == NULL) {
+        pool.first = work;
+    } else {
+        pool.last->next = work;
+    }
+
+    pool.last = work;
+    pthread_cond_signal(&pool.isQueued);
+    pthread_mutex_unlock(&pool.lock);
+}
+
+/**
+ * Removes the task from the queue if no thread has started it yet.
+ *
+ * @param work The task to cancel.
+ * @return TRUE if the task has been removed (it is idle again), FALSE if it is running or done.
+ */
+boolean cancelTask(task *work) {
+    boolean isCanceled; /* Has the task been removed from the queue? */
+
+    pthread_mutex_lock(&pool.lock);
+    isCanceled = work->state == QUEUED_TASK;
+
+    if (isCanceled) {
+        unlinkTask(work);
+        work->state = IDLE_TASK;
+    }
+
+    pthread_mutex_unlock(&pool.lock);
+    return isCanceled;
+}
+
+/**
+ * Checks if the task is done, without waiting for it.
+ *
+ * @param work The task to check.
+ * @return TRUE if the task is done (or has never been submitted), FALSE otherwise.
+ */
+boolean isTaskDone(task *work) {
+    boolean isDone; /* Is the task done? */
+
+    pthread_mutex_lock(&pool.lock);
+    isDone = work->state == DONE_TASK || work->state == IDLE_TASK;
+    pthread_mutex_unlock(&pool.lock);
+    return isDone;
+}
+
+/**
+ * Waits until the task is done. If no thread has started it yet, runs it on the current thread.
+ * Returns right away if the task has never been submitted.
+ *
+ * @param work The task to wait for.
+ */
+void waitTask(task *work) {
+    pthread_mutex_lock(&pool.lock);
+
+    /* Run the task here rather than wait for a helper to start it. */
+    if (work->state == QUEUED_TASK) {
+        unlinkTask(work);
+        work->state = RUNNING_TASK;
+        pthread_mutex_unlock(&pool.lock);
+        runTask(work);
+        return;
+    }
+
+    while (work->state == RUNNING_TASK) {
+        pthread_cond_wait(&pool.isDone, &pool.lock);
+    }
+
+    pthread_mutex_unlock(&pool.lock);
+}
+
+/**
+ * Stops the helper threads once the queue is empty, and waits for them to end.
+ */
+void stopHelpers() {
+    long index; /* Current index in the helper threads. */
+
+    pthread_mutex_lock(&pool.lock);
+    pool.isStopping = TRUE;
+    pthread_cond_broadcast(&pool.isQueued);
+    pthread_mutex_unlock(&pool.lock);
+
+    for (index = FIRST_INDEX; index < pool.helperCount; index++) {
+        pthread_join(pool.helpers[index], NULL);
+    }
+
+    free(pool.helpers);
+    pool.helpers = NULL;
+    pool.helperCount = EMPTY;
+    pool.isStopping = FALSE;
+}
@@ -0,0 +1,95 @@
+/*
+ * tasks.h
+ * Includes the prototypes of all the functions in tasks.c.
+ * Also, includes the type of a task which the helper threads can run.
+ *
+ * The program may start helper threads (see --threads), which run tasks from a single queue, in the order they are submitted.
+ * A thread which needs the result of a task waits for it, and runs it itself if no helper has started it yet,
+ * so a thread never waits for work which nobody runs. Without helper threads, every task runs on the thread which waits for it.
+ *
+ * Name: Ariel Keren
+ * Course: C Lab, 20465
+ * Semester: 2024B
+ * Date: 18/10/2026
+ */
+
+#ifndef TASKS_H
+#define TASKS_H
+
+#include <stddef.h>
+
+#include "globals.h"
+#include "setcalc.h"
+
+/* A piece of work which may run on a helper thread. */
+typedef struct task {
+    void (*run)(void *data); /* Runs the work. */
+    void *data;              /* Passed to the function which runs the work. */
+    calculator *context;     /* The calculator in use where the task was submitted (the task runs with it). */
+    int state;               /* Whether the task is idle, queued, running or done (see the task states in globals.h). */
+    struct task *previous;   /* The task before this one in the queue. */
+    struct task *next;       /* The task after this one in the queue. */
+} task;
+
+/**
+ * Fills the task with the function which runs its work (the task is idle until it is submitted).
+ *
+ * @param work The task to fill.
+ * @param run Runs the work.
+ * @param data Passed to the function which runs the work.
+ */
+void initializeTask(task *work, void (*run)(void *data), void *data);
+
+/**
+ * Starts the given number of helper threads (once, before any task is submitted).
+ * Exits the program if the threads cannot be started.
+ *
+ * @param count The number of helper threads.
+ */
+void startHelpers(long count);
+
+/**
+ * Returns the number of helper threads which run tasks.
+ *
+ * @return The number of helper threads (0 if every task runs on the thread which waits for it).
+ */
+long countHelpers();
+
+/**
+ * Adds the task to the end of the queue, so a helper thread can run it with the calculator the current thread uses.
+ * Without helper threads, the task stays queued until it is waited for.
+ *
+ * @param work The task to submit (idle or done).
+ */
+void submitTask(task *work);
+
+/**
+ * Removes the task from the queue if no thread has started it yet.
+ *
+ * @param work The task to cancel.
+ * @return TRUE if the task has been removed (it is idle again), FALSE if it is running or done.
+ */
+boolean cancelTask(task *work);
+
+/**
+ * Checks if the task is done, without waiting for it.
+ *
+ * @param work The task to check.
+ * @return TRUE if the task is done (or has never been submitted), FALSE otherwise.
+ */
+boolean isTaskDone(task *work);
+
+/**
+ * Waits until the task is done. If no thread has started it yet, runs it on the current thread.
+ * Returns right away if the task has never been submitted.
+ *
+ * @param work The task to wait for.
+ */
+void waitTask(task *work);
+
+/**
+ * Stops the helper threads once the queue is empty, and waits for them to end.
+ */
+void stopHelpers();
+
+#endif
@@ -2,11 +2,9 @@
  * utils.c
  * Includes some general functions for the program.
  * Some of the functionality:
- * - Getting the next token from a tokenized line.
- * - Tokenization of lines.
- * - Getting the associated index of a set or an operation.
- * - Duplication of strings.
- * - Checking if a string can be interpreted as a decimal integer.
+ * - Getting the associated index of an operation, and checking set names.
+ * - Checking if a string can be interpreted as a decimal integer, and counting the digits at its start.
+ * - Reporting messages and errors (with line numbers in batch mode).
  *
  * Name: Ariel Keren
  * Course: C Lab, 20465
@@ -21,69 +19,66 @@
 #include <stdlib.h>
 #include <string.h>
 
-#include "globals.h"
-
-/**
- * Returns the next token from the last tokenized string.
- * The tokens are separated by whitespace characters and commas in the original string.
- *
- * @return The next token from the last tokenized string.
- */
-char *getNextToken() {
-    /* strtok remembers the last tokenized string, so use it to get the next token. */
-    return strtok(NULL, SEPARATORS);
-}
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
-/**
- * Tokenizes a string and returns the first token.
- * The tokens are separated by whitespace characters and commas in the original string.
- * Assumes the string is null-terminated.
- *
- * @param line The line to tokenize.
- * @return The first token from the line.
- */
-char *tokenizeLine(char line[]) {
-    /* Use strtok to tokenize the given string by whitespace characters and commas. */
-    return strtok(line, SEPARATORS);
-}
+#include "calculator.h"
+#include "globals.h"
 
 /**
  * Returns the index of the operation in the given string.
  * If the string is not one of the valid operations, returns -1.
- * Assumes the string is null-terminated.
+ * The string does not have to be null-terminated.
  *
  * @param string The string to check.
+ * @param length The length of the string.
  * @return The index of the operation in the given string or -1 if not found.
  */
-int getOperationIndex(const char string[]) {
+int getOperationIndex(const char string[], size_t length) {
     /* Use indexOf to find the index of the operation that is in the given string. */
-    return indexOf(OPERATIONS, string, NUMBER_OF_OPERATIONS);
+    return indexOf(OPERATIONS, string, length, NUMBER_OF_OPERATIONS);
 }
 
 /**
- * Returns the index of the set in the given string.
- * If the string is not one of the valid sets, returns -1.
- * Assumes the string is null-terminated.
+ * Checks if the given string is a valid set name.
+ * A set name starts with a letter or an underscore, followed by letters, digits and underscores.
+ * The string does not have to be null-terminated.
  *
  * @param string The string to check.
- * @return The index of the set in the given string or -1 if not found.
+ * @param length The length of the string.
+ * @return TRUE if the string is a valid set name, FALSE otherwise.
  */
-int getSetIndex(const char string[]) {
-    /* Use indexOf to find the index of the set that is in the given string. */
-    return indexOf(SETS, string, NUMBER_OF_SETS);
+boolean isSetName(const char string[], size_t length) {
+    size_t index; /* Current index in the string. */
+
+    /* Check if the name is empty or starts with a digit. */
+    if (length == EMPTY || isdigit((unsigned char)string[FIRST_INDEX])) {
+        return FALSE;
+    }
+
+    /* Check every character in the name. */
+    for (index = FIRST_INDEX; index < length; index++) {
+        if (!isalnum((unsigned char)string[index]) && string[index] != '_') {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
 }
 
 /**
  * Returns the index of the given word in the given array of words.
  * If the word is not in the array, returns -1.
- * Assumes the word and each word in the words array are null-terminated.
+ * Assumes each word in the words array is null-terminated (the given word does not have to be).
  *
  * @param words The array of words.
  * @param word The word to search for.
+ * @param wordLength The length of the word to search for.
  * @param length The length of the words array.
  * @return The index of the given word in the given array of words or -1 if not found.
  */
-int indexOf(const char *words[], const char word[], int length) {
+int indexOf(const char *words[], const char word[], size_t wordLength, int length) {
     int index; /* Current index in the words array. */
 
     if (word == NULL) {
@@ -92,8 +87,8 @@ int indexOf(const char *words[], const char word[], int length) {
 
     /* Loop over each word in the words array. */
     for (index = FIRST_INDEX; index < length; index++) {
-        /* Check if the current word matches the given word. */
-        if (!strcmp(words[index], word)) {
+        /* Check if the current word matches the given word (including its length). */
+        if (!strncmp(words[index], word, wordLength) && words[index][wordLength] == '\0') {
             /* Found. */
             return index;
         }
@@ -103,56 +98,35 @@ int indexOf(const char *words[], const char word[], int length) {
     return INVALID_INDEX;
 }
 
-/**
- * Duplicates the given string and returns the copy.
- * Users of this function must free the returned string.
- * Assumes the string is null-terminated.
- *
- * @param string The string to duplicate.
- * @return A copy of the given string.
- */
-char *duplicateString(const char string[]) {
-    char *copy; /* A copy of the given string. */
-
-    /* Allocate enough memory to the string's copy. */
-    copy = malloc(sizeof(char) * (strlen(string) + NULL_BYTE));
-
-    /* Check for an error in the memory allocation. */
-    if (copy == NULL) {
-        /* Exit the program. */
-        fprintf(stderr, "Error: Failed to allocate enough memory to duplicate the line.\n");
-        exit(ERROR);
-    }
-
-    /* Copy the string to the copy. */
-    strcpy(copy, string);
-    return copy;
-}
-
 /**
  * Checks if the given string is a decimal integer.
  * Allows for + and - signs before the digits.
  * Does not allow for a decimal point.
  * Does not allow for decimal places (to the right of the decimal point).
- * Assumes the string is null-terminated.
+ * The string does not have to be null-terminated.
  *
  * @param string The string to check.
+ * @param length The length of the string.
  * @return TRUE if the string is a decimal integer, FALSE otherwise.
  */
-boolean isInteger(const char string[]) {
-    /* Check if the string is empty. */
-    if (*string == '\0') {
-        return FALSE;
-    }
+boolean isInteger(const char string[], size_t length) {
+    const char *end; /* The end of the string. */
+
+    end = string + length;
 
     /* Skip over the sign if there is one. */
-    if (*string == '-' || *string == '+') {
+    if (string != end && (*string == '-' || *string == '+')) {
         string++;
     }
 
+    /* Check if there are no digits. */
+    if (string == end) {
+        return FALSE;
+    }
+
     /* Check if the remaining characters are digits. */
-    while (*string != '\0') {
-        if (!isdigit(*string)) {
+    while (string != end) {
+        if (!isdigit((unsigned char)*string)) {
             return FALSE;
         }
         /* Move to the next character. */
@@ -162,3 +136,152 @@ boolean isInteger(const char string[]) {
     /* Passed every check - an integer. */
     return TRUE;
 }
+
+/**
+ * Converts the given decimal integer string to an integer.
+ * Assumes the string is a decimal integer (see isInteger).
+ * Magnitudes larger than 2147483647 are all converted to 2147483647 (with the right sign).
+ *
+ * @param string The string to convert.
+ * @param length The length of the string.
+ * @return The integer in the string.
+ */
+long parseInteger(const char string[], size_t length) {
+    const char *end;    /* The end of the string. */
+    boolean isNegative; /* Is there a minus sign before the digits? */
+    long value;         /* The value of the digits so far. */
+    int digit;          /* The value of the current digit. */
+
+    end = string + length;
+    isNegative = *string == '-';
+    value = STARTING_VALUE;
+
+    /* Skip over the sign if there is one. */
+    if (*string == '-' || *string == '+') {
+        string++;
+    }
+
+    /* Add each digit. */
+    while (string != end) {
+        digit = *string++ - '0';
+
+        /* Saturate magnitudes which are too large (before they overflow). */
+        if (value > (INTEGER_SATURATION - digit) / DECIMAL_BASE) {
+            value = INTEGER_SATURATION;
+            break;
+        }
+
+        value = value * DECIMAL_BASE + digit;
+    }
+
+    return isNegative ? -value : value;
+}
+
+/**
+ * Counts the decimal digits at the start of the given string.
+ * With SSE2, 16 characters are checked at once (whenever at least 16 are left).
+ * The string does not have to be null-terminated.
+ *
+ * @param string The string to check.
+ * @param length The length of the string.
+ * @return The number of digits before the first character which is not a digit.
+ */
+size_t countDigits(const char string[], size_t length) {
+    size_t count; /* The number of digits so far. */
+#ifdef __SSE2__
+    __m128i characters; /* The next 16 characters. */
+    unsigned mask;      /* A bit for each of the 16 characters which is not a digit. */
+#endif
+
+    count = STARTING_VALUE;
+
+#ifdef __SSE2__
+    /* Check 16 characters at once (only while they are all inside the string). */
+    while (length - count >= VECTOR_CHARACTERS) {
+        characters = _mm_loadu_si128((const __m128i *)(string + count));
+        mask = ~(unsigned)_mm_movemask_epi8(_mm_and_si128(_mm_cmpgt_epi8(characters, _mm_set1_epi8('0' - SINGLE_BIT)), _mm_cmplt_epi8(characters, _mm_set1_epi8('9' + SINGLE_BIT))));
+
+        /* Find the first character which is not a digit. */
+        if ((mask &= (SINGLE_BIT << VECTOR_CHARACTERS) - SINGLE_BIT) != EMPTY) {
+#ifdef __GNUC__
+            return count + (size_t)__builtin_ctz(mask);
+#else
+            while (!(mask & SINGLE_BIT)) {
+                mask >>= SINGLE_BIT;
+                count++;
+            }
+
+            return count;
+#endif
+        }
+
+        count += VECTOR_CHARACTERS;
+    }
+#endif
+
+    /* Check the rest of the characters one at a time. */
+    while (count < length && isdigit((unsigned char)string[count])) {
+        count++;
+    }
+
+    return count;
+}
+
+/**
+ * Sets whether the calculator in use runs in batch mode.
+ * In batch mode, informational messages are not printed.
+ *
+ * @param isBatch TRUE to enable batch mode, FALSE otherwise.
+ */
+void setBatchMode(boolean isBatch) {
+    getCalculator()->isBatch = isBatch;
+}
+
+/**
+ * Sets the number of the input line which the calculator in use currently handles.
+ * Errors are reported along with this line number (unless it is 0).
+ *
+ * @param lineNumber The number of the current input line.
+ */
+void setLineNumber(unsigned long lineNumber) {
+    getCalculator()->lineNumber = lineNumber;
+}
+
+/**
+ * Prints an informational message (e.g. "Skipping empty line...") to the output sink of the calculator in use.
+ * Does not print anything in batch mode.
+ *
+ * @param message The message to print.
+ */
+void printMessage(const char message[]) {
+    /* Batch mode is silent. */
+    if (getCalculator()->isBatch) {
+        return;
+    }
+
+    writeOutput(message, strlen(message));
+    writeOutput("\n", SINGLE_CHARACTER);
+}
+
+/**
+ * Prints an error message to the error sink of the calculator in use, as a single line.
+ * Includes the current line number if one has been set.
+ * Messages longer than ERROR_TEXT_LENGTH characters are cut.
+ *
+ * @param message The error message to print (without the "Error: " prefix).
+ */
+void printError(const char message[]) {
+    char text[ERROR_TEXT_LENGTH + ERROR_PREFIX_LENGTH]; /* The whole line of the error. */
+    unsigned long lineNumber;                           /* The number of the current line. */
+
+    lineNumber = getCalculator()->lineNumber;
+
+    /* Check if there is a line number to report. */
+    if (lineNumber == NO_LINE_NUMBER) {
+        sprintf(text, "Error: %.*s\n", ERROR_TEXT_LENGTH, message);
+    } else {
+        sprintf(text, "Error (line %lu): %.*s\n", lineNumber, ERROR_TEXT_LENGTH, message);
+    }
+
+    writeErrors(text, strlen(text));
+}
@@ -11,78 +11,111 @@
 #ifndef UTILS_H
 #define UTILS_H
 
-#include "globals.h"
-
-/**
- * Returns the next token from the last tokenized string.
- * The tokens are separated by whitespace characters and commas in the original string.
- *
- * @return The next token from the last tokenized string.
- */
-char *getNextToken();
+#include <stddef.h>
 
-/**
- * Tokenizes a string and returns the first token.
- * The tokens are separated by whitespace characters and commas in the original string.
- * Assumes the string is null-terminated.
- *
- * @param line The line to tokenize.
- * @return The first token from the line.
- */
-char *tokenizeLine(char line[]);
+#include "globals.h"
 
 /**
  * Returns the index of the operation in the given string.
  * If the string is not one of the valid operations, returns -1.
- * Assumes the string is null-terminated.
+ * The string does not have to be null-terminated.
  *
  * @param string The string to check.
+ * @param length The length of the string.
  * @return The index of the operation in the given string or -1 if not found.
  */
-int getOperationIndex(const char string[]);
+int getOperationIndex(const char string[], size_t length);
 
 /**
- * Returns the index of the set in the given string.
- * If the string is not one of the valid sets, returns -1.
- * Assumes the string is null-terminated.
+ * Checks if the given string is a valid set name.
+ * A set name starts with a letter or an underscore, followed by letters, digits and underscores.
+ * The string does not have to be null-terminated.
  *
  * @param string The string to check.
- * @return The index of the set in the given string or -1 if not found.
+ * @param length The length of the string.
+ * @return TRUE if the string is a valid set name, FALSE otherwise.
  */
-int getSetIndex(const char string[]);
+boolean isSetName(const char string[], size_t length);
 
 /**
  * Returns the index of the given word in the given array of words.
  * If the word is not in the array, returns -1.
- * Assumes the word and each word in the words array are null-terminated.
+ * Assumes each word in the words array is null-terminated (the given word does not have to be).
  *
  * @param words The array of words.
  * @param word The word to search for.
+ * @param wordLength The length of the word to search for.
  * @param length The length of the words array.
  * @return The index of the given word in the given array of words or -1 if not found.
  */
-int indexOf(const char *words[], const char word[], int length);
-
-/**
- * Duplicates the given string and returns the copy.
- * Users of this function must free the returned string.
- * Assumes the string is null-terminated.
- *
- * @param string The string to duplicate.
- * @return A copy of the given string.
- */
-char *duplicateString(const char string[]);
+int indexOf(const char *words[], const char word[], size_t wordLength, int length);
 
 /**
  * Checks if the given string is a decimal integer.
  * Allows for + and - signs before the digits.
  * Does not allow for a decimal point.
  * Does not allow for decimal places (to the right of the decimal point).
- * Assumes the string is null-terminated.
+ * The string does not have to be null-terminated.
  *
  * @param string The string to check.
+ * @param length The length of the string.
  * @return TRUE if the string is a decimal integer, FALSE otherwise.
  */
-boolean isInteger(const char string[]);
+boolean isInteger(const char string[], size_t length);
+
+/**
+ * Converts the given decimal integer string to an integer.
+ * Assumes the string is a decimal integer (see isInteger).
+ * Magnitudes larger than 2147483647 are all converted to 2147483647 (with the right sign).
+ *
+ * @param string The string to convert.
+ * @param length The length of the string.
+ * @return The integer in the string.
+ */
+long parseInteger(const char string[], size_t length);
+
+/**
+ * Counts the decimal digits at the start of the given string.
+ * With SSE2, 16 characters are checked at once (whenever at least 16 are left).
+ * The string does not have to be null-terminated.
+ *
+ * @param string The string to check.
+ * @param length The length of the string.
+ * @return The number of digits before the first character which is not a digit.
+ */
+size_t countDigits(const char string[], size_t length);
+
+/**
+ * Sets whether the calculator in use runs in batch mode.
+ * In batch mode, informational messages are not printed.
+ *
+ * @param isBatch TRUE to enable batch mode, FALSE otherwise.
+ */
+void setBatchMode(boolean isBatch);
+
+/**
+ * Sets the number of the input line which the calculator in use currently handles.
+ * Errors are reported along with this line number (unless it is 0).
+ *
+ * @param lineNumber The number of the current input line.
+ */
+void setLineNumber(unsigned long lineNumber);
+
+/**
+ * Prints an informational message (e.g. "Skipping empty line...") to the output sink of the calculator in use.
+ * Does not print anything in batch mode.
+ *
+ * @param message The message to print.
+ */
+void printMessage(const char message[]);
+
+/**
+ * Prints an error message to the error sink of the calculator in use, as a single line.
+ * Includes the current line number if one has been set.
+ * Messages longer than ERROR_TEXT_LENGTH characters are cut.
+ *
+ * @param message The error message to print (without the "Error: " prefix).
+ */
+void printError(const char message[]);
 
 #endif
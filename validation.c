@@ -1,8 +1,9 @@
 /*
  * validation.c
- * Includes a function for validating an input line (if it is a valid command).
+ * Includes a function for validating an input line (if it is a valid command) and compiling it into an instruction.
  * Also, includes separated validation functions for each operation.
- * Finally, includes some functions to validate the commas in the user's commands.
+ * Also, includes a streaming version of the read_set validation, for lines which are too long to be kept in memory.
+ * Finally, includes a function to validate the commas in the user's commands.
  *
  * Name: Ariel Keren
  * Course: C Lab, 20465
@@ -15,184 +16,439 @@
 #include <ctype.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
+#include "calculator.h"
+#include "expression.h"
 #include "globals.h"
+#include "lexer.h"
+#include "registry.h"
+#include "set.h"
+#include "setUtils.h"
 #include "utils.h"
 
 /**
- * Checks if the given line represents a valid command.
- * Assumes the line is null-terminated.
+ * Marks the instruction as invalid because of the given error.
+ *
+ * @param command The invalid instruction.
+ * @param error The reason the line is invalid.
+ * @return FALSE (so it can be returned by the validation functions).
+ */
+static boolean rejectCommand(instruction *command, const char error[]) {
+    command->error = error;
+    return FALSE;
+}
+
+/**
+ * Checks if the given token is a valid set name, and stores it as the given operand of the instruction.
+ *
+ * @param line The line the token is in.
+ * @param setName The token which should be a set name.
+ * @param command The instruction to fill.
+ * @param operand The index of the operand to store the name in.
+ * @return TRUE if the set name is valid, FALSE otherwise.
+ */
+static boolean acceptSetName(const char line[], const token *setName, instruction *command, int operand) {
+    /* Check if the operand is a valid set name. */
+    if (!isSetName(line + setName->offset, setName->length)) {
+        return rejectCommand(command, "Invalid set name.");
+    }
+
+    /* Hash the name once, so it can be found quickly when the instruction is executed. */
+    nameSet(&command->operands[operand], line + setName->offset, setName->length);
+    return TRUE;
+}
+
+/**
+ * Stores the given token as the path of the instruction's file (null-terminated).
+ *
+ * @param line The line the token is in.
+ * @param path The token which is the path of the file.
+ * @param command The instruction to fill.
+ * @return TRUE if the path has been stored, FALSE if it is too long.
+ */
+static boolean acceptPath(const char line[], const token *path, instruction *command) {
+    /* Keep room for the terminating null character. */
+    if (path->length >= FILENAME_MAX) {
+        return rejectCommand(command, "The file path is too long.");
+    }
+
+    memcpy(command->path, line + path->offset, path->length);
+    command->path[path->length] = '\0';
+    return TRUE;
+}
+
+/**
+ * Skips the spaces and tabs at the given position of the line.
+ *
+ * @param line The line to walk over.
+ * @param length The number of characters in the line.
+ * @param position The position to start from.
+ * @return The position of the first character after the spaces and tabs.
+ */
+static size_t skipBlanks(const char line[], size_t length, size_t position) {
+    while (position < length && (line[position] == ' ' || line[position] == '\t')) {
+        position++;
+    }
+
+    return position;
+}
+
+/**
+ * Decodes a well-formed read_set line in a single pass, straight into the members of the instruction.
+ * Digit runs are found with countDigits (16 characters at a time), and every member is range-checked and added as it is decoded.
+ * Gives up on anything unusual (e.g. signs, other whitespace characters or any error), so the line is validated the usual way.
+ *
+ * @param line The line to decode.
+ * @param length The number of characters in the line.
+ * @param command The instruction to fill.
+ * @return TRUE if the line has been decoded, FALSE if it should be validated the usual way.
+ */
+static boolean decodeReadSet(const char line[], size_t length, instruction *command) {
+    size_t position;      /* The current position in the line. */
+    size_t start;         /* The position of the set's name. */
+    size_t digits;        /* The number of digits in the current number. */
+    size_t index;         /* Current index in the digits. */
+    unsigned long member; /* The current member. */
+
+    position = skipBlanks(line, length, FIRST_INDEX);
+
+    /* The operation should be read_set, followed by a space or a tab. */
+    if (length - position <= strlen(OPERATIONS[READ_SET]) || memcmp(line + position, OPERATIONS[READ_SET], strlen(OPERATIONS[READ_SET]))) {
+        return FALSE;
+    }
+
+    position += strlen(OPERATIONS[READ_SET]);
+
+    if (line[position] != ' ' && line[position] != '\t') {
+        return FALSE;
+    }
+
+    /* The set's name continues until a blank or a comma. */
+    start = position = skipBlanks(line, length, position);
+
+    while (position < length && line[position] != ',' && line[position] != ' ' && line[position] != '\t') {
+        position++;
+    }
+
+    if (!isSetName(line + start, position - start)) {
+        return FALSE;
+    }
+
+    nameSet(&command->operands[FIRST_INDEX], line + start, position - start);
+    clearSet(&command->members);
+    command->operation = READ_SET;
+
+    /* Every number is preceded by a single comma. */
+    while ((position = skipBlanks(line, length, position)) < length && line[position] == ',') {
+        position = skipBlanks(line, length, position + NEXT_INDEX_DIFFERENCE);
+
+        /* Check for the terminator, which should be the last thing in the line. */
+        if (length - position >= sizeof("-1") - NEXT_INDEX_DIFFERENCE && !memcmp(line + position, "-1", sizeof("-1") - NEXT_INDEX_DIFFERENCE)) {
+            if (skipBlanks(line, length, position + sizeof("-1") - NEXT_INDEX_DIFFERENCE) != length) {
+                break;
+            }
+
+            /* Convert the containers of the members to the kinds which fit them best. */
+            if (!optimizeSet(&command->members)) {
+                failMemory("Failed to allocate memory for the members.");
+            }
+
+            return TRUE;
+        }
+
+        digits = countDigits(line + position, length - position);
+
+        /* Leave numbers which might not fit (and anything which is not a number) to the usual validation. */
+        if (digits == EMPTY || digits >= MAXIMUM_DIGITS) {
+            break;
+        }
+
+        member = STARTING_VALUE;
+
+        for (index = FIRST_INDEX; index < digits; index++) {
+            member = member * DECIMAL_BASE + (unsigned long)(line[position + index] - '0');
+        }
+
+        if (member > (unsigned long)getLargestMember()) {
+            break;
+        }
+
+        if (!addMember(&command->members, (long)member)) {
+            failMemory("Failed to allocate memory for the members.");
+        }
+
+        position += digits;
+    }
+
+    /* The line is validated the usual way, which decodes the members again. */
+    clearSet(&command->members);
+    return FALSE;
+}
+
+/**
+ * Allocates the memory an instruction needs (the members of read_set start out with no containers).
+ * The same instruction can be reused for every line.
+ *
+ * @param command The instruction to allocate.
+ * @return TRUE if the instruction has been allocated, FALSE if the memory allocation failed.
+ */
+boolean createInstruction(instruction *command) {
+    command->error = NULL;
+    initializeExpression(&command->formula);
+    return createSet(&command->members);
+}
+
+/**
+ * Frees the memory used by the instruction.
+ *
+ * @param command The instruction to free.
+ */
+void freeInstruction(instruction *command) {
+    freeSet(&command->members);
+    freeExpression(&command->formula);
+}
+
+/**
+ * Checks if the given line represents a valid command and compiles it into an instruction.
+ * A well-formed read_set line is decoded in a single pass over its characters, without splitting it into tokens.
+ * Every other line (including a read_set line with any error, so the error is reported as usual) is split into tokens first.
+ * Leaves the words of the line in the token list (the operation and its operands, without the commas).
+ * If the line is invalid, sets the instruction's error (or leaves it NULL if the line is blank).
  *
  * @param line The line to validate.
+ * @param length The number of characters in the line.
+ * @param tokens The token list to split the line into (reused for every line).
+ * @param command The instruction to fill.
  * @return TRUE if the line is valid, FALSE otherwise.
  */
-boolean isLineValid(const char line[]) {
-    char *lineCopy;  /* A copy of the input line. */
-    char *operation; /* The operation's name (e.g. "read_set"). */
-    boolean isValid; /* Is the line valid? */
-
-    /* Copy the input line to tokenize it. */
-    lineCopy = duplicateString(line);
-    /* Tokenize the line and get the first token (the operation). */
-    operation = tokenizeLine(lineCopy);
-
-    /* If the line only consists of whitespace characters, it should be skipped. */
-    if (operation == NULL) {
-        printf("Skipping empty line...\n");
-        /* Skip this line without printing an error message. */
-        free(lineCopy);
+boolean compileLine(const char line[], size_t length, tokenlist *tokens, instruction *command) {
+    const token *operation; /* The operation's name (e.g. "read_set"). */
+
+    command->error = NULL;
+
+    /* Try the fast path for read_set first. */
+    if (decodeReadSet(line, length, command)) {
+        return TRUE;
+    }
+
+    /* Walk over the line a single time to find all of its tokens. */
+    tokenizeLine(line, length, tokens);
+
+    /* If the line only consists of whitespace characters, it should be skipped (without an error). */
+    if (tokens->count == EMPTY) {
         return FALSE;
     }
 
+    operation = &tokens->tokens[FIRST_INDEX];
+    command->operation = getOperationIndex(line + operation->offset, operation->length);
+
+    /* Handle eval (its expression is not a list of operands, so it is validated on its own). */
+    if (command->operation == EVAL_SET) {
+        return validateEval(line, tokens, command);
+    }
+
     /* Validate every comma in the input line. */
-    if (!validateCommas(line)) {
-        free(lineCopy);
+    if (!validateCommas(tokens, command)) {
         return FALSE;
     }
 
+    /* Only the operation and its operands are left. */
+    removeCommas(tokens);
+
     /* Separate the validation into different cases based on the operation. */
-    switch (getOperationIndex(operation)) {
+    switch (command->operation) {
         case STOP:
-            /* Handle stop. */
-            isValid = validateStop();
-            break;
+        case CACHE_STATS:
+        case STATISTICS:
+            /* Handle stop, cache_stats or stats. */
+            return validateStop(tokens, command);
         case PRINT_SET:
             /* Handle print_set. */
-            isValid = validatePrintSet();
-            break;
+            return validatePrintSet(line, tokens, command);
         case READ_SET:
             /* Handle read_set. */
-            isValid = validateReadSet();
-            break;
+            return validateReadSet(line, tokens, command);
+        case DROP_SET:
+            /* Handle drop_set. */
+            return validateDropSet(line, tokens, command);
+        case COUNT_SET:
+        case MIN_SET:
+        case MAX_SET:
+            /* Handle count_set, min_set or max_set. */
+            return validateSetQuery(line, tokens, command);
+        case SAVE_STATE:
+        case LOAD_STATE:
+            /* Handle save_state or load_state. */
+            return validateStateFile(line, tokens, command);
+        case LOAD_SET:
+        case DUMP_SET:
+            /* Handle load_set or dump_set. */
+            return validateSetFile(line, tokens, command);
         case INVALID_INDEX:
             /* This means that the operation is invalid. */
-            fprintf(stderr, "Error: Invalid operation.\n");
-            isValid = FALSE;
-            break;
+            return rejectCommand(command, "Invalid operation.");
         default:
             /* Handle union_set, intersect_set, sub_set or symdiff_set. */
-            isValid = validateSetOperation();
-            break;
+            return validateSetOperation(line, tokens, command);
     }
-
-    /* The line copy is no longer used. */
-    free(lineCopy);
-    return isValid;
 }
 
 /**
- * Checks if the stop command is valid.
- * Gets the command via the tokenized line.
+ * Checks if the stop command (or another command which accepts no operands, e.g. cache_stats) is valid.
+ * Assumes the commas have been removed from the token list.
  *
+ * @param tokens The tokens of the line.
+ * @param command The instruction to fill.
  * @return TRUE if the command is valid, FALSE otherwise.
  */
-boolean validateStop() {
+boolean validateStop(const tokenlist *tokens, instruction *command) {
     /* Check if there are any operands, which should not be there. */
-    if (getNextToken() != NULL) {
-        fprintf(stderr, "Error: stop does not accept any operands.\n");
-        return FALSE;
+    if (tokens->count != SINGLE_TOKEN) {
+        sprintf(command->errorBuffer, "%s does not accept any operands.", OPERATIONS[command->operation]);
+        return rejectCommand(command, command->errorBuffer);
     }
 
     return TRUE;
 }
 
 /**
- * Checks if the print_set command is valid.
- * Gets the command via the tokenized line.
+ * Checks if a command which accepts a single set operand (e.g. print_set) is valid.
+ * Stores the set in the instruction.
+ * Assumes the commas have been removed from the token list.
  *
+ * @param line The line to validate.
+ * @param tokens The tokens of the line.
+ * @param command The instruction to fill.
+ * @param missingError The error to report if no set has been provided.
  * @return TRUE if the command is valid, FALSE otherwise.
  */
-boolean validatePrintSet() {
-    char *token; /* Current token. */
-
-    /* Get what should be the target set's name. */
-    token = getNextToken();
-
+static boolean validateSingleSet(const char line[], const tokenlist *tokens, instruction *command, const char missingError[]) {
     /* Check if an operand has been provided. */
-    if (token == NULL) {
-        fprintf(stderr, "Error: No set to print.\n");
-        return FALSE;
+    if (tokens->count == SINGLE_TOKEN) {
+        return rejectCommand(command, missingError);
     }
 
     /* Check if there is an operand, which represents valid set. */
-    if (getSetIndex(token) == INVALID_INDEX) {
-        fprintf(stderr, "Error: Invalid set name.\n");
+    if (!acceptSetName(line, &tokens->tokens[SECOND_INDEX], command, FIRST_INDEX)) {
         return FALSE;
     }
 
     /* Check if there any extra operands, which should not be there. */
-    if (getNextToken() != NULL) {
-        fprintf(stderr, "Error: print_set only accepts a single set operand.\n");
-        return FALSE;
+    if (tokens->count > THIRD_INDEX) {
+        sprintf(command->errorBuffer, "%s only accepts a single set operand.", OPERATIONS[command->operation]);
+        return rejectCommand(command, command->errorBuffer);
     }
 
     return TRUE;
 }
 
 /**
- * Checks if the read_set command is valid.
- * Gets the command via the tokenized line.
+ * Checks if the print_set command is valid.
+ * Stores the set to print in the instruction.
+ * Assumes the commas have been removed from the token list.
  *
+ * @param line The line to validate.
+ * @param tokens The tokens of the line.
+ * @param command The instruction to fill.
  * @return TRUE if the command is valid, FALSE otherwise.
  */
-boolean validateReadSet() {
-    char *token;       /* The current token. */
-    char *nextToken;   /* The next token. */
-    int numberOperand; /* The current number operand, converted to an integer. */
+boolean validatePrintSet(const char line[], const tokenlist *tokens, instruction *command) {
+    return validateSingleSet(line, tokens, command, "No set to print.");
+}
 
-    /* Get what should be the target set's name. */
-    token = getNextToken();
+/**
+ * Checks if the drop_set command is valid.
+ * Stores the set to drop in the instruction.
+ * Assumes the commas have been removed from the token list.
+ *
+ * @param line The line to validate.
+ * @param tokens The tokens of the line.
+ * @param command The instruction to fill.
+ * @return TRUE if the command is valid, FALSE otherwise.
+ */
+boolean validateDropSet(const char line[], const tokenlist *tokens, instruction *command) {
+    return validateSingleSet(line, tokens, command, "No set to drop.");
+}
+
+/**
+ * Checks if the count_set, min_set or max_set command is valid.
+ * Stores the set to check in the instruction.
+ * Assumes the commas have been removed from the token list.
+ *
+ * @param line The line to validate.
+ * @param tokens The tokens of the line.
+ * @param command The instruction to fill.
+ * @return TRUE if the command is valid, FALSE otherwise.
+ */
+boolean validateSetQuery(const char line[], const tokenlist *tokens, instruction *command) {
+    return validateSingleSet(line, tokens, command, "No set to check.");
+}
+
+/**
+ * Checks if the read_set command is valid.
+ * Stores the set to fill and the decoded members in the instruction.
+ * Assumes the commas have been removed from the token list.
+ *
+ * @param line The line to validate.
+ * @param tokens The tokens of the line.
+ * @param command The instruction to fill.
+ * @return TRUE if the command is valid, FALSE otherwise.
+ */
+boolean validateReadSet(const char line[], const tokenlist *tokens, instruction *command) {
+    const token *current; /* The current token. */
+    const token *last;    /* The last token. */
+    long numberOperand;   /* The current number operand, converted to an integer. */
 
     /* Check if an operand has been provided. */
-    if (token == NULL) {
-        fprintf(stderr, "Error: No set to fill.\n");
-        return FALSE;
+    if (tokens->count == SINGLE_TOKEN) {
+        return rejectCommand(command, "No set to fill.");
     }
 
     /* Check if the target set's name is valid. */
-    if (getSetIndex(token) == INVALID_INDEX) {
-        fprintf(stderr, "Error: Invalid set name.\n");
+    if (!acceptSetName(line, &tokens->tokens[SECOND_INDEX], command, FIRST_INDEX)) {
         return FALSE;
     }
 
-    /* Get the first (supposed) number operand. */
-    token = getNextToken();
-
     /* Check if there are any operands after the set's name. */
-    if (token == NULL) {
-        fprintf(stderr, "Error: A read_set command should include some numbers as operands.\n");
-        return FALSE;
+    if (tokens->count == THIRD_INDEX) {
+        return rejectCommand(command, "A read_set command should include some numbers as operands.");
     }
 
-    /* Get the operand after it to always know if the current operand is the last one (to check for a comma). */
-    nextToken = getNextToken();
+    last = &tokens->tokens[tokens->count - NEXT_INDEX_DIFFERENCE];
+    /* The members are decoded while they are checked. */
+    clearSet(&command->members);
 
     /* Loops over all remaining operands. They should all be numbers. */
-    while (token != NULL) {
+    for (current = &tokens->tokens[THIRD_INDEX]; current <= last; current++) {
         /* Check if the operand is an integer. */
-        if (!isInteger(token)) {
-            fprintf(stderr, "Error: Set members should be integers only.\n");
-            return FALSE;
+        if (!isInteger(line + current->offset, current->length)) {
+            return rejectCommand(command, "Set members should be integers only.");
         }
 
         /* Convert the operand to an integer. */
-        numberOperand = atoi(token);
+        numberOperand = parseInteger(line + current->offset, current->length);
 
         /* Check if the operand is outside the valid range of integers. The last one should always be -1. */
-        if (numberOperand > LARGEST_MEMBER || (nextToken != NULL && numberOperand < SMALLEST_MEMBER)) {
-            fprintf(stderr, "Error: Set members should only be integers in the range 0-127.\n");
-            return FALSE;
+        if (numberOperand > getLargestMember() || (current != last && numberOperand < SMALLEST_MEMBER)) {
+            sprintf(command->errorBuffer, "Set members should only be integers in the range %d-%ld.", SMALLEST_MEMBER, getLargestMember());
+            return rejectCommand(command, command->errorBuffer);
         }
 
         /* Check if the last operand is indeed a -1. */
-        if (nextToken == NULL && numberOperand != TERMINATOR) {
-            fprintf(stderr, "Error: A read_set command should be terminated with a -1.\n");
-            return FALSE;
+        if (current == last && numberOperand != TERMINATOR) {
+            return rejectCommand(command, "A read_set command should be terminated with a -1.");
         }
 
-        /* Move to the next operand to check. */
-        token = nextToken;
-        nextToken = getNextToken();
+        /* Add the member (the terminator is not a member). */
+        if (current != last && !addMember(&command->members, numberOperand)) {
+            failMemory("Failed to allocate memory for the members.");
+        }
+    }
+
+    /* Convert the containers of the members to the kinds which fit them best. */
+    if (!optimizeSet(&command->members)) {
+        failMemory("Failed to allocate memory for the members.");
     }
 
     return TRUE;
@@ -200,211 +456,479 @@ boolean validateReadSet() {
 
 /**
  * Checks if the union_set, intersect_set, sub_set or symdiff_set command is valid.
- * Gets the command via the tokenized line.
+ * union_set, intersect_set and symdiff_set accept any number of sets to combine (at least two), while sub_set accepts exactly two.
+ * Stores the sets to combine in the instruction's expression, and the set to store the result in as the third operand.
+ * Assumes the commas have been removed from the token list.
  *
+ * @param line The line to validate.
+ * @param tokens The tokens of the line.
+ * @param command The instruction to fill.
  * @return TRUE if the command is valid, FALSE otherwise.
  */
-boolean validateSetOperation() {
-    char *token;                   /* The current token. */
-    char *nextToken;               /* The next token. */
-    unsigned char operandsChecked; /* The current number of operands checked. */
-
-    operandsChecked = STARTING_VALUE;
-    /* Get the first operand. */
-    token = getNextToken();
-    /* Get the next operand to always know if the current operand is the last one (to check for a comma). */
-    nextToken = getNextToken();
-
-    /* Loops over all operands. */
-    while (token != NULL) {
-        /* Check if there are too many operands (more than the three sets needed). */
-        if (operandsChecked == SET_OPERATION_OPERANDS) {
-            fprintf(stderr, "Error: Set operations only accept exactly 3 set operands.\n");
-            return FALSE;
+boolean validateSetOperation(const char line[], const tokenlist *tokens, instruction *command) {
+    const token *current; /* The current token. */
+    const token *last;    /* The last token (the set to store the result in). */
+    steptype type;        /* The kind of the operation, as a step of the expression. */
+
+    /* Check if there are too few operands (two sets to combine and the set to store the result in). */
+    if (tokens->count < SET_OPERATION_OPERANDS + NEXT_INDEX_DIFFERENCE) {
+        sprintf(command->errorBuffer, command->operation == SUB_SET ? "%s only accepts exactly 3 set operands." : "%s accepts at least 3 set operands.", OPERATIONS[command->operation]);
+        return rejectCommand(command, command->errorBuffer);
+    }
+
+    /* Check if there are too many operands (sub_set only has two sets to combine). */
+    if (command->operation == SUB_SET && tokens->count > SET_OPERATION_OPERANDS + NEXT_INDEX_DIFFERENCE) {
+        return rejectCommand(command, "sub_set only accepts exactly 3 set operands.");
+    }
+
+    type = command->operation == UNION_SET ? UNION_STEP : command->operation == INTERSECT_SET ? INTERSECT_STEP : command->operation == SUB_SET ? SUB_STEP : SYMDIFF_STEP;
+    last = &tokens->tokens[tokens->count - NEXT_INDEX_DIFFERENCE];
+    clearExpression(&command->formula);
+
+    /* Loops over all the sets to combine. */
+    for (current = &tokens->tokens[SECOND_INDEX]; current < last; current++) {
+        /* Check if the operand is a valid set name. */
+        if (!isSetName(line + current->offset, current->length)) {
+            return rejectCommand(command, "Invalid set name.");
         }
 
-        /* Check if the operand is a valid set. */
-        if (getSetIndex(token) == INVALID_INDEX) {
-            fprintf(stderr, "Error: Invalid set name.\n");
-            return FALSE;
+        appendOperand(&command->formula, line + current->offset, current->length, type);
+    }
+
+    /* Check if the set to store the result in is valid. */
+    return acceptSetName(line, last, command, THIRD_INDEX);
+}
+
+/**
+ * Checks if the save_state or load_state command is valid.
+ * Stores the path of the file in the instruction (null-terminated).
+ * Assumes the commas have been removed from the token list.
+ *
+ * @param line The line to validate.
+ * @param tokens The tokens of the line.
+ * @param command The instruction to fill.
+ * @return TRUE if the command is valid, FALSE otherwise.
+ */
+boolean validateStateFile(const char line[], const tokenlist *tokens, instruction *command) {
+    /* Check if a file has been provided. */
+    if (tokens->count == SINGLE_TOKEN) {
+        return rejectCommand(command, command->operation == SAVE_STATE ? "No file to save to." : "No file to load from.");
+    }
+
+    /* Check if there any extra operands, which should not be there. */
+    if (tokens->count > THIRD_INDEX) {
+        sprintf(command->errorBuffer, "%s only accepts a single file operand.", OPERATIONS[command->operation]);
+        return rejectCommand(command, command->errorBuffer);
+    }
+
+    return acceptPath(line, &tokens->tokens[SECOND_INDEX], command);
+}
+
+/**
+ * Checks if the load_set or dump_set command is valid.
+ * Stores the set, the path of the file and its format (bitmap unless given) in the instruction.
+ * Assumes the commas have been removed from the token list.
+ *
+ * @param line The line to validate.
+ * @param tokens The tokens of the line.
+ * @param command The instruction to fill.
+ * @return TRUE if the command is valid, FALSE otherwise.
+ */
+boolean validateSetFile(const char line[], const tokenlist *tokens, instruction *command) {
+    const token *format; /* The format of the file (if given). */
+
+    /* Check if a set has been provided. */
+    if (tokens->count == SINGLE_TOKEN) {
+        return rejectCommand(command, command->operation == LOAD_SET ? "No set to load into." : "No set to dump.");
+    }
+
+    if (!acceptSetName(line, &tokens->tokens[SECOND_INDEX], command, FIRST_INDEX)) {
+        return FALSE;
+    }
+
+    /* Check if a file has been provided. */
+    if (tokens->count == THIRD_INDEX) {
+        return rejectCommand(command, command->operation == LOAD_SET ? "No file to load from." : "No file to dump to.");
+    }
+
+    /* Check if there any extra operands, which should not be there. */
+    if (tokens->count > FIFTH_INDEX) {
+        sprintf(command->errorBuffer, "%s only accepts a set, a file and a format.", OPERATIONS[command->operation]);
+        return rejectCommand(command, command->errorBuffer);
+    }
+
+    if (!acceptPath(line, &tokens->tokens[THIRD_INDEX], command)) {
+        return FALSE;
+    }
+
+    command->format = BITMAP_FORMAT;
+
+    /* Check the format (if given). */
+    if (tokens->count == FIFTH_INDEX) {
+        format = &tokens->tokens[FOURTH_INDEX];
+        command->format = indexOf(FORMATS, line + format->offset, format->length, NUMBER_OF_FORMATS);
+
+        if (command->format == INVALID_INDEX) {
+            return rejectCommand(command, "Invalid format (should be bitmap or array).");
         }
+    }
+
+    return TRUE;
+}
+
+/**
+ * Checks if the eval command is valid.
+ * Stores the set to assign to in the instruction, and compiles the expression after the = into it.
+ * Assumes the commas are still in the token list (commas are not allowed anywhere in the command).
+ *
+ * @param line The line to validate.
+ * @param tokens The tokens of the line.
+ * @param command The instruction to fill.
+ * @return TRUE if the command is valid, FALSE otherwise.
+ */
+boolean validateEval(const char line[], const tokenlist *tokens, instruction *command) {
+    const token *last; /* The last token. */
+    size_t position;   /* The offset of the current character in the line. */
+    size_t end;        /* The offset right after the last token. */
+    token target;      /* The name of the set to assign to. */
+    size_t index;      /* Current index in the token list. */
+
+    /* Check if there is a comma anywhere in the command. */
+    for (index = FIRST_INDEX; index < tokens->count; index++) {
+        if (tokens->tokens[index].type == COMMA_TOKEN) {
+            return rejectCommand(command, "eval does not accept commas.");
+        }
+    }
+
+    last = &tokens->tokens[tokens->count - NEXT_INDEX_DIFFERENCE];
+    end = last->offset + last->length;
+    position = tokens->tokens[FIRST_INDEX].offset + tokens->tokens[FIRST_INDEX].length;
+
+    /* Skip the whitespace characters before the set to assign to. */
+    while (position < end && isspace((unsigned char)line[position])) {
+        position++;
+    }
+
+    target.type = WORD_TOKEN;
+    target.offset = position;
 
-        /* Move to the next operand to check. */
-        token = nextToken;
-        nextToken = getNextToken();
-        /* Increment the number of operands checked. */
-        operandsChecked++;
+    /* Find the end of the set's name (it may be followed by the = with no whitespace). */
+    while (position < end && !isspace((unsigned char)line[position]) && line[position] != '=') {
+        position++;
     }
 
-    /* Check if there too few operands. */
-    if (operandsChecked < SET_OPERATION_OPERANDS) {
-        fprintf(stderr, "Error: Set operations only accept exactly 3 operands.\n");
+    target.length = position - target.offset;
+
+    /* Check if a set to assign to has been provided. */
+    if (target.length == EMPTY) {
+        return rejectCommand(command, "No set to assign to.");
+    }
+
+    /* Check if the set's name is valid. */
+    if (!acceptSetName(line, &target, command, FIRST_INDEX)) {
         return FALSE;
     }
 
+    /* Skip the whitespace characters before the =. */
+    while (position < end && isspace((unsigned char)line[position])) {
+        position++;
+    }
+
+    /* Check if the set's name is followed by an =. */
+    if (position == end || line[position] != '=') {
+        return rejectCommand(command, "Missing = after the set to assign to.");
+    }
+
+    /* Compile the rest of the line as the expression. */
+    position++;
+
+    if (!compileExpression(&command->formula, line + position, end - position)) {
+        return rejectCommand(command, command->formula.error);
+    }
+
     return TRUE;
 }
 
 /**
- * Checks if every comma in the given line is valid.
- * Assumes the line is null-terminated.
+ * Starts validating a read_set line which is too long to be kept in memory, given the start of the line.
+ * Only starts if the start of the line has the read_set operation and a valid set name, followed by a whitespace character or a comma.
+ * Stores the set to fill in the instruction (pointing into the start of the line, which should be kept until the instruction is executed).
  *
- * @param line The line to validate the commas in.
- * @return TRUE if all of the commas in the line are valid, FALSE otherwise.
+ * @param stream The stream to start.
+ * @param line The start of the line.
+ * @param length The number of characters in the start of the line.
+ * @param command The instruction to fill.
+ * @return TRUE if the stream has been started (and the rest of the start of the line has been checked), FALSE if the line should be read in full.
  */
-boolean validateCommas(const char line[]) {
-    char *lineCopy;      /* A copy of the input line. */
-    char *current;       /* The current character. */
-    boolean commaBefore; /* Whether a comma has been seen and there has not been a non-whitespace character after it. */
-    boolean spaceSeen;   /* Whether a whitespace character has been seen. */
-
-    commaBefore = FALSE;
-    spaceSeen = FALSE;
-
-    /* Copy the input line. */
-    lineCopy = duplicateString(line);
-    /* Remove all whitespace characters, except for the first one after the first token, from the copy. */
-    removeWhitespace(lineCopy);
-
-    /* Check if the first character is a comma. */
-    if (*lineCopy == ',') {
-        free(lineCopy);
-        fprintf(stderr, "Error: Comma before the operation.\n");
+boolean startReadSetStream(readsetstream *stream, const char line[], size_t length, instruction *command) {
+    size_t position; /* The current position in the line. */
+    size_t start;    /* The position of the set's name. */
+
+    position = FIRST_INDEX;
+
+    while (position < length && isspace((unsigned char)line[position])) {
+        position++;
+    }
+
+    /* The operation should be read_set, followed by a whitespace character (a comma is an error, which is left to the usual validation). */
+    if (length - position <= strlen(OPERATIONS[READ_SET]) || memcmp(line + position, OPERATIONS[READ_SET], strlen(OPERATIONS[READ_SET])) || !isspace((unsigned char)line[position + strlen(OPERATIONS[READ_SET])])) {
         return FALSE;
     }
 
-    /* Loops over all characters in the line. */
-    for (current = lineCopy; *current != '\0'; current++) {
-        /* Check for a comma. */
-        if (*current == ',') {
-            /* Check if there is a comma after the operation's name. */
-            if (!spaceSeen) {
-                free(lineCopy);
-                fprintf(stderr, "Error: Comma after the operation.\n");
-                return FALSE;
-            }
+    position += strlen(OPERATIONS[READ_SET]);
+
+    while (position < length && isspace((unsigned char)line[position])) {
+        position++;
+    }
+
+    /* The set's name should be complete (followed by another character) and valid. */
+    for (start = position; position < length && line[position] != ',' && !isspace((unsigned char)line[position]); position++) {
+        continue;
+    }
+
+    if (position == length || !isSetName(line + start, position - start)) {
+        return FALSE;
+    }
+
+    nameSet(&command->operands[FIRST_INDEX], line + start, position - start);
+    clearSet(&command->members);
+    command->operation = READ_SET;
+    command->error = NULL;
+
+    /* The operation and the set's name are the first two tokens. */
+    stream->command = command;
+    stream->tokens = SET_OPERATION_OPERANDS - NEXT_INDEX_DIFFERENCE;
+    stream->commas = STARTING_VALUE;
+    stream->isComma = FALSE;
+    stream->commaError = stream->memberError = NULL;
+    stream->isInWord = FALSE;
+    stream->hasPending = FALSE;
+
+    feedReadSetStream(stream, line + position, length - position);
+    return TRUE;
+}
+
+/**
+ * Checks the number which is waiting to be checked, now that it is known whether it is the last one.
+ * Adds it to the members of the instruction if it is valid (and no error has been found yet).
+ * Exits the program if the memory allocation fails.
+ *
+ * @param stream The stream the number belongs to.
+ * @param isLast Is the number the last one in the line?
+ */
+static void checkPendingMember(readsetstream *stream, boolean isLast) {
+    instruction *command; /* The instruction to fill. */
+
+    command = stream->command;
+    stream->hasPending = FALSE;
+
+    /* Only the first error is reported, and the members are not needed once there is one. */
+    if (stream->commaError != NULL || stream->memberError != NULL) {
+        return;
+    }
+
+    /* Check the number the same way as validateReadSet. */
+    if (!stream->isPendingValid) {
+        stream->memberError = "Set members should be integers only.";
+    } else if (stream->pendingValue > getLargestMember() || (!isLast && stream->pendingValue < SMALLEST_MEMBER)) {
+        sprintf(command->errorBuffer, "Set members should only be integers in the range %d-%ld.", SMALLEST_MEMBER, getLargestMember());
+        stream->memberError = command->errorBuffer;
+    } else if (isLast && stream->pendingValue != TERMINATOR) {
+        stream->memberError = "A read_set command should be terminated with a -1.";
+    } else if (!isLast && !addMember(&command->members, stream->pendingValue)) {
+        failMemory("Failed to allocate memory for the members.");
+    }
+}
+
+/**
+ * Ends the current word (if there is one), and makes it the number which is waiting to be checked.
+ *
+ * @param stream The stream the word belongs to.
+ */
+static void endStreamWord(readsetstream *stream) {
+    if (!stream->isInWord) {
+        return;
+    }
+
+    /* The previous number is not the last one. */
+    if (stream->hasPending) {
+        checkPendingMember(stream, FALSE);
+    }
+
+    stream->isInWord = FALSE;
+    stream->tokens++;
+    stream->hasPending = TRUE;
+    stream->isPendingValid = stream->isInteger && stream->hasDigits;
+    stream->pendingValue = stream->isNegative ? -stream->value : stream->value;
+}
+
+/**
+ * Checks the next piece of a read_set line, and adds its members to the instruction (until an error is found).
+ * A word may be split between pieces.
+ *
+ * @param stream The stream the piece belongs to.
+ * @param text The characters of the piece.
+ * @param length The number of characters in the piece.
+ */
+void feedReadSetStream(readsetstream *stream, const char text[], size_t length) {
+    size_t position; /* Current index in the piece. */
+    size_t digits;   /* The number of digits in the current run. */
+    size_t end;      /* The end of the current run of digits. */
+    int digit;       /* The value of the current digit. */
+    char character;  /* The current character. */
+
+    for (position = FIRST_INDEX; position < length; position++) {
+        character = text[position];
+
+        /* Whitespace characters and commas end the current word. */
+        if (isspace((unsigned char)character)) {
+            endStreamWord(stream);
+            continue;
+        }
+
+        if (character == ',') {
+            endStreamWord(stream);
 
-            /* Check if there are two or more consecutive commas. */
-            if (commaBefore) {
-                free(lineCopy);
-                fprintf(stderr, "Error: Two or more consecutive commas.\n");
-                return FALSE;
+            /* Check the comma the same way as validateCommas. */
+            if (stream->isComma && stream->commaError == NULL) {
+                stream->commaError = "Two or more consecutive commas.";
             }
 
-            /* Mark that a comma has been seen. */
-            commaBefore = TRUE;
+            stream->tokens++;
+            stream->commas++;
+            stream->isComma = TRUE;
             continue;
         }
 
-        /* Check for a whitespace character. */
-        if (isspace(*current)) {
-            /* Mark that a whitespace character has been seen. */
-            spaceSeen = TRUE;
+        /* Start a new word. */
+        if (!stream->isInWord) {
+            stream->isInWord = TRUE;
+            stream->isComma = FALSE;
+            stream->hasCharacters = stream->isNegative = stream->hasDigits = FALSE;
+            stream->isInteger = TRUE;
+            stream->value = STARTING_VALUE;
+        }
+
+        /* Add a whole run of digits at once (saturating the magnitude, like parseInteger). */
+        if (isdigit((unsigned char)character)) {
+            digits = countDigits(text + position, length - position);
 
-            /* Check if there is a comma after the space, that is after operation's name. */
-            if (*(current + NEXT_INDEX_DIFFERENCE) == ',') {
-                free(lineCopy);
-                fprintf(stderr, "Error: Comma after the operation.\n");
-                return FALSE;
+            for (end = position + digits; position < end; position++) {
+                digit = text[position] - '0';
+                stream->value = stream->value > (INTEGER_SATURATION - digit) / DECIMAL_BASE ? INTEGER_SATURATION : stream->value * DECIMAL_BASE + digit;
             }
 
+            stream->hasCharacters = stream->hasDigits = TRUE;
+            position--;
             continue;
         }
 
-        /* A non-whitespace character has been seen. */
-        commaBefore = FALSE;
+        /* A sign is only allowed before the digits. */
+        if ((character == '-' || character == '+') && !stream->hasCharacters) {
+            stream->isNegative = character == '-';
+        } else {
+            stream->isInteger = FALSE;
+        }
+
+        stream->hasCharacters = TRUE;
     }
+}
 
-    /* The line copy is no longer used. */
-    free(lineCopy);
+/**
+ * Finishes validating a read_set line once all of its pieces have been checked.
+ * Reports the same error as validateReadSet would for the whole line (comma errors first, then the first invalid member).
+ * If the line is invalid, sets the instruction's error and leaves its members empty.
+ * Exits the program if the memory allocation fails.
+ *
+ * @param stream The stream to finish.
+ * @return TRUE if the line is valid, FALSE otherwise.
+ */
+boolean finishReadSetStream(readsetstream *stream) {
+    instruction *command; /* The instruction to fill. */
 
-    /* Check if the last character is a comma. */
-    if (commaBefore) {
-        fprintf(stderr, "Error: Comma after the last operand.\n");
-        return FALSE;
+    command = stream->command;
+    endStreamWord(stream);
+
+    /* The last number is checked as the terminator. */
+    if (stream->hasPending) {
+        checkPendingMember(stream, TRUE);
+    }
+
+    /* Report the errors in the same order as validateCommas and validateReadSet. */
+    if (stream->commaError != NULL) {
+        command->error = stream->commaError;
+    } else if (stream->isComma) {
+        command->error = "Comma after the last operand.";
+    } else if (stream->commas + TOKENS_COMMAS_DIFFERENCE != stream->tokens - stream->commas) {
+        command->error = "Missing comma.";
+    } else if (stream->tokens - stream->commas == THIRD_INDEX) {
+        command->error = "A read_set command should include some numbers as operands.";
+    } else {
+        command->error = stream->memberError;
     }
 
-    /* Check if there have been enough commas for the number of tokens. */
-    if (!commasMatchTokens(line)) {
-        fprintf(stderr, "Error: Missing comma.\n");
+    if (command->error != NULL) {
+        clearSet(&command->members);
         return FALSE;
     }
 
+    /* Convert the containers of the members to the kinds which fit them best. */
+    if (!optimizeSet(&command->members)) {
+        failMemory("Failed to allocate memory for the members.");
+    }
+
     return TRUE;
 }
 
 /**
- * Checks if the number of commas in the given line fits the number of tokens in it.
+ * Checks if every comma in the token list is valid.
+ * Operands should be separated by exactly one comma, with no comma before the first operand or after the last one.
  *
- * @param line The line to check.
- * @return TRUE if the number of commas fits the number of tokens, FALSE otherwise.
+ * @param tokens The tokens of the line.
+ * @param command The instruction to set the error of.
+ * @return TRUE if all of the commas in the line are valid, FALSE otherwise.
  */
-boolean commasMatchTokens(const char line[]) {
+boolean validateCommas(const tokenlist *tokens, instruction *command) {
+    size_t index;       /* Current index in the token list. */
     size_t commasFound; /* The number of commas found. */
-    size_t tokensFound; /* The number of tokens (words separated by whitespace characters and commas) found. */
-    boolean inToken;    /* Whether we are currently in a token. */
+    const token *list;  /* The tokens of the line. */
 
-    inToken = FALSE;
+    list = tokens->tokens;
     commasFound = STARTING_VALUE;
-    tokensFound = STARTING_VALUE;
-
-    /* Loop over all characters in the line. */
-    while (*line != '\0') {
-        if (isspace(*line)) {
-            /* We are not in a token anymore. */
-            inToken = FALSE;
-        } else if (*line == ',') {
-            /* We are not in a token anymore and a comma has been found. */
-            inToken = FALSE;
-            commasFound++;
-        } else if (!inToken) {
-            /* We are currently in a token. Count it. */
-            inToken = TRUE;
-            tokensFound++;
-        }
 
-        /* Move to the next character. */
-        line++;
+    /* Check if the first token is a comma. */
+    if (list[FIRST_INDEX].type == COMMA_TOKEN) {
+        return rejectCommand(command, "Comma before the operation.");
     }
 
-    /* Generally, there should be two more tokens than commas, unless we are talking about a command consisting of a single token. */
-    return tokensFound == SINGLE_TOKEN || commasFound + TOKENS_COMMAS_DIFFERENCE == tokensFound;
-}
+    /* Loops over all tokens after the operation. */
+    for (index = SECOND_INDEX; index < tokens->count; index++) {
+        if (list[index].type != COMMA_TOKEN) {
+            continue;
+        }
 
-/**
- * Removes almost all whitespace characters from the given string.
- * Does not remove the first whitespace character after the first token.
- *
- * @param string The string to remove whitespace characters from.
- */
-void removeWhitespace(char string[]) {
-    char *current;         /* The current character. */
-    char *insert;          /* The position to insert into. */
-    boolean characterSeen; /* Whether a non-whitespace character has been seen. */
-    boolean addedSpace;    /* Whether a whitespace character has already been added to the string. */
-
-    characterSeen = FALSE;
-    addedSpace = FALSE;
-
-    /* Loop over all characters in the string. */
-    for (current = insert = string; *current != '\0'; current++) {
-        /* Determine whether the current character is a whitespace character. */
-        if (isspace(*current)) {
-            /* Add a single whitespace character if a non-whitespace character has been seen. */
-            if (!addedSpace && characterSeen) {
-                /* Insert the whitespace character. */
-                *insert++ = *current;
-                /* Mark that a whitespace character has been added. */
-                addedSpace = TRUE;
-            }
-        } else {
-            /* Insert the non-whitespace character. */
-            *insert++ = *current;
-            /* Mark that a non-whitespace character has been seen. */
-            characterSeen = TRUE;
+        /* Check if there is a comma after the operation's name. */
+        if (index == SECOND_INDEX) {
+            return rejectCommand(command, "Comma after the operation.");
         }
+
+        /* Check if there are two or more consecutive commas. */
+        if (list[index - NEXT_INDEX_DIFFERENCE].type == COMMA_TOKEN) {
+            return rejectCommand(command, "Two or more consecutive commas.");
+        }
+
+        commasFound++;
+    }
+
+    /* Check if the last token is a comma. */
+    if (list[tokens->count - NEXT_INDEX_DIFFERENCE].type == COMMA_TOKEN) {
+        return rejectCommand(command, "Comma after the last operand.");
+    }
+
+    /* Generally, there should be two more words than commas, unless the command consists of a single word. */
+    if (tokens->count != SINGLE_TOKEN && commasFound + TOKENS_COMMAS_DIFFERENCE != tokens->count - commasFound) {
+        return rejectCommand(command, "Missing comma.");
     }
 
-    /* Insert the terminating null character. */
-    *insert = '\0';
+    return TRUE;
 }
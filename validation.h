@@ -1,6 +1,7 @@
 /*
  * validation.h
  * Includes the prototypes of all the functions in validation.c.
+ * Also, includes the type of a compiled instruction.
  *
  * Name: Ariel Keren
  * Course: C Lab, 20465
@@ -12,73 +13,225 @@
 #define VALIDATION_H
 
 #include <stddef.h>
+#include <stdio.h>
 
+#include "expression.h"
 #include "globals.h"
+#include "lexer.h"
+#include "registry.h"
+#include "set.h"
+
+/* A validated command, which can be executed without looking at its line again. */
+typedef struct {
+    int operation;                            /* The index of the operation (e.g. READ_SET). */
+    setname operands[SET_OPERATION_OPERANDS]; /* The names of the set operands (pointing into the line). */
+    set members;                              /* The members to fill the set with (read_set only). */
+    expression formula;                       /* The expression to assign to the first operand (eval), or the sets to combine (set operations). */
+    char path[FILENAME_MAX];                  /* The path of the file to read or write (save_state, load_state, load_set and dump_set only). */
+    int format;                               /* The format of the file (load_set and dump_set only). */
+    const char *error;                        /* The reason the line is invalid or could not be executed (NULL for blank lines). */
+    char errorBuffer[ERROR_MESSAGE_LENGTH];   /* Holds error messages which include numbers. */
+} instruction;
+
+/* Validates a read_set line which is too long to be kept in memory, a piece at a time (in the order of the line). */
+typedef struct {
+    instruction *command;    /* The instruction to fill. */
+    unsigned long tokens;    /* The number of tokens so far (words and commas). */
+    unsigned long commas;    /* The number of commas so far. */
+    boolean isComma;         /* Is the last token a comma? */
+    const char *commaError;  /* The first error found by the comma checks (NULL if none so far). */
+    const char *memberError; /* The first error found by the member checks (NULL if none so far). */
+    boolean isInWord;        /* Is the last character part of a word (which may continue in the next piece)? */
+    boolean hasCharacters;   /* Does the current word have any characters yet? */
+    boolean isInteger;       /* Is the current word an integer so far? */
+    boolean isNegative;      /* Does the current word start with a minus sign? */
+    boolean hasDigits;       /* Does the current word have any digits? */
+    long value;              /* The magnitude of the current word so far (saturated, like parseInteger). */
+    boolean hasPending;      /* Is there a number waiting to be checked (it may only be -1 if it is the last one)? */
+    boolean isPendingValid;  /* Is the waiting number an integer? */
+    long pendingValue;       /* The value of the waiting number. */
+} readsetstream;
 
 /**
- * Checks if the given line represents a valid command.
- * Assumes the line is null-terminated.
+ * Allocates the memory an instruction needs (the members of read_set start out with no containers).
+ * The same instruction can be reused for every line.
+ *
+ * @param command The instruction to allocate.
+ * @return TRUE if the instruction has been allocated, FALSE if the memory allocation failed.
+ */
+boolean createInstruction(instruction *command);
+
+/**
+ * Frees the memory used by the instruction.
+ *
+ * @param command The instruction to free.
+ */
+void freeInstruction(instruction *command);
+
+/**
+ * Checks if the given line represents a valid command and compiles it into an instruction.
+ * A well-formed read_set line is decoded in a single pass over its characters, without splitting it into tokens.
+ * Every other line (including a read_set line with any error, so the error is reported as usual) is split into tokens first.
+ * Leaves the words of the line in the token list (the operation and its operands, without the commas).
+ * If the line is invalid, sets the instruction's error (or leaves it NULL if the line is blank).
  *
  * @param line The line to validate.
+ * @param length The number of characters in the line.
+ * @param tokens The token list to split the line into (reused for every line).
+ * @param command The instruction to fill.
  * @return TRUE if the line is valid, FALSE otherwise.
  */
-boolean isLineValid(const char line[]);
+boolean compileLine(const char line[], size_t length, tokenlist *tokens, instruction *command);
 
 /**
- * Checks if the stop command is valid.
- * Gets the command via the tokenized line.
+ * Checks if the stop command (or another command which accepts no operands, e.g. cache_stats) is valid.
+ * Assumes the commas have been removed from the token list.
  *
+ * @param tokens The tokens of the line.
+ * @param command The instruction to fill.
  * @return TRUE if the command is valid, FALSE otherwise.
  */
-boolean validateStop();
+boolean validateStop(const tokenlist *tokens, instruction *command);
 
 /**
  * Checks if the print_set command is valid.
- * Gets the command via the tokenized line.
+ * Stores the set to print in the instruction.
+ * Assumes the commas have been removed from the token list.
  *
+ * @param line The line to validate.
+ * @param tokens The tokens of the line.
+ * @param command The instruction to fill.
  * @return TRUE if the command is valid, FALSE otherwise.
  */
-boolean validatePrintSet();
+boolean validatePrintSet(const char line[], const tokenlist *tokens, instruction *command);
+
+/**
+ * Checks if the drop_set command is valid.
+ * Stores the set to drop in the instruction.
+ * Assumes the commas have been removed from the token list.
+ *
+ * @param line The line to validate.
+ * @param tokens The tokens of the line.
+ * @param command The instruction to fill.
+ * @return TRUE if the command is valid, FALSE otherwise.
+ */
+boolean validateDropSet(const char line[], const tokenlist *tokens, instruction *command);
+
+/**
+ * Checks if the count_set, min_set or max_set command is valid.
+ * Stores the set to check in the instruction.
+ * Assumes the commas have been removed from the token list.
+ *
+ * @param line The line to validate.
+ * @param tokens The tokens of the line.
+ * @param command The instruction to fill.
+ * @return TRUE if the command is valid, FALSE otherwise.
+ */
+boolean validateSetQuery(const char line[], const tokenlist *tokens, instruction *command);
 
 /**
  * Checks if the read_set command is valid.
- * Gets the command via the tokenized line.
+ * Stores the set to fill and the decoded members in the instruction.
+ * Assumes the commas have been removed from the token list.
  *
+ * @param line The line to validate.
+ * @param tokens The tokens of the line.
+ * @param command The instruction to fill.
  * @return TRUE if the command is valid, FALSE otherwise.
  */
-boolean validateReadSet();
+boolean validateReadSet(const char line[], const tokenlist *tokens, instruction *command);
 
 /**
  * Checks if the union_set, intersect_set, sub_set or symdiff_set command is valid.
- * Gets the command via the tokenized line.
+ * union_set, intersect_set and symdiff_set accept any number of sets to combine (at least two), while sub_set accepts exactly two.
+ * Stores the sets to combine in the instruction's expression, and the set to store the result in as the third operand.
+ * Assumes the commas have been removed from the token list.
+ *
+ * @param line The line to validate.
+ * @param tokens The tokens of the line.
+ * @param command The instruction to fill.
+ * @return TRUE if the command is valid, FALSE otherwise.
+ */
+boolean validateSetOperation(const char line[], const tokenlist *tokens, instruction *command);
+
+/**
+ * Checks if the save_state or load_state command is valid.
+ * Stores the path of the file in the instruction (null-terminated).
+ * Assumes the commas have been removed from the token list.
  *
+ * @param line The line to validate.
+ * @param tokens The tokens of the line.
+ * @param command The instruction to fill.
  * @return TRUE if the command is valid, FALSE otherwise.
  */
-boolean validateSetOperation();
+boolean validateStateFile(const char line[], const tokenlist *tokens, instruction *command);
 
 /**
- * Checks if every comma in the given line is valid.
- * Assumes the line is null-terminated.
+ * Checks if the load_set or dump_set command is valid.
+ * Stores the set, the path of the file and its format (bitmap unless given) in the instruction.
+ * Assumes the commas have been removed from the token list.
  *
- * @param line The line to validate the commas in.
- * @return TRUE if all of the commas in the line are valid, FALSE otherwise.
+ * @param line The line to validate.
+ * @param tokens The tokens of the line.
+ * @param command The instruction to fill.
+ * @return TRUE if the command is valid, FALSE otherwise.
  */
-boolean validateCommas(const char line[]);
+boolean validateSetFile(const char line[], const tokenlist *tokens, instruction *command);
 
 /**
- * Checks if the number of commas in the given line fits the number of tokens in it.
+ * Checks if the eval command is valid.
+ * Stores the set to assign to in the instruction, and compiles the expression after the = into it.
+ * Assumes the commas are still in the token list (commas are not allowed anywhere in the command).
  *
- * @param line The line to check.
- * @return TRUE if the number of commas fits the number of tokens, FALSE otherwise.
+ * @param line The line to validate.
+ * @param tokens The tokens of the line.
+ * @param command The instruction to fill.
+ * @return TRUE if the command is valid, FALSE otherwise.
  */
-boolean commasMatchTokens(const char line[]);
+boolean validateEval(const char line[], const tokenlist *tokens, instruction *command);
 
 /**
- * Removes almost all whitespace characters from the given string.
- * Does not remove the first whitespace character after the first token.
+ * Starts validating a read_set line which is too long to be kept in memory, given the start of the line.
+ * Only starts if the start of the line has the read_set operation and a valid set name, followed by a whitespace character or a comma.
+ * Stores the set to fill in the instruction (pointing into the start of the line, which should be kept until the instruction is executed).
  *
- * @param string The string to remove whitespace characters from.
+ * @param stream The stream to start.
+ * @param line The start of the line.
+ * @param length The number of characters in the start of the line.
+ * @param command The instruction to fill.
+ * @return TRUE if the stream has been started (and the rest of the start of the line has been checked), FALSE if the line should be read in full.
+ */
+boolean startReadSetStream(readsetstream *stream, const char line[], size_t length, instruction *command);
+
+/**
+ * Checks the next piece of a read_set line, and adds its members to the instruction (until an error is found).
+ * A word may be split between pieces.
+ *
+ * @param stream The stream the piece belongs to.
+ * @param text The characters of the piece.
+ * @param length The number of characters in the piece.
+ */
+void feedReadSetStream(readsetstream *stream, const char text[], size_t length);
+
+/**
+ * Finishes validating a read_set line once all of its pieces have been checked.
+ * Reports the same error as validateReadSet would for the whole line (comma errors first, then the first invalid member).
+ * If the line is invalid, sets the instruction's error and leaves its members empty.
+ * Exits the program if the memory allocation fails.
+ *
+ * @param stream The stream to finish.
+ * @return TRUE if the line is valid, FALSE otherwise.
+ */
+boolean finishReadSetStream(readsetstream *stream);
+
+/**
+ * Checks if every comma in the token list is valid.
+ * Operands should be separated by exactly one comma, with no comma before the first operand or after the last one.
+ *
+ * @param tokens The tokens of the line.
+ * @param command The instruction to set the error of.
+ * @return TRUE if all of the commas in the line are valid, FALSE otherwise.
  */
-void removeWhitespace(char string[]);
+boolean validateCommas(const tokenlist *tokens, instruction *command);
 
 #endif
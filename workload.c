@@ -0,0 +1,236 @@
+/*
+ * workload.c
+ * Includes the main function of the workload generator, which writes a random script of commands for the benchmark.
+ * The script mixes read_set commands, set operations (union_set, intersect_set, sub_set and symdiff_set) and print_set commands,
+ * over the 6 sets which are defined when the program starts, and always ends with stop.
+ * The same options (and seed) always generate the same script, on every machine.
+ *
+ * Name: Ariel Keren
+ * Course: C Lab, 20465
+ * Semester: 2024B
+ * Date: 18/10/2026
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "globals.h"
+
+/* The options the workload is generated with (from the command line). */
+typedef struct {
+    long commands;                 /* The number of commands before stop. */
+    long universe;                 /* The number of potential members in every set. */
+    long members;                  /* The average number of members in a read_set command. */
+    long weights[NUMBER_OF_KINDS]; /* The weight of each kind of command (read_set, set operations and print_set). */
+    long seed;                     /* The starting state of the random numbers. */
+} workloadoptions;
+
+/**
+ * Returns the next random number (xorshift), and advances the state.
+ *
+ * @param state The state of the random numbers (never 0).
+ * @return A random number in the range 0-4294967295.
+ */
+static unsigned long nextRandom(unsigned long *state) {
+    *state ^= (*state << RANDOM_FIRST_SHIFT) & RANDOM_MASK;
+    *state ^= *state >> RANDOM_SECOND_SHIFT;
+    *state ^= (*state << RANDOM_THIRD_SHIFT) & RANDOM_MASK;
+    return *state;
+}
+
+/**
+ * Prints the usage of the workload generator, and exits the program.
+ *
+ * @param programName The name of the program.
+ */
+static void printWorkloadUsage(const char programName[]) {
+    fprintf(stderr, "Usage: %s [%s <count>] [%s <size>] [%s <count>] [%s <weight>] [%s <weight>] [%s <weight>] [%s <seed>]\n", programName, COMMANDS_FLAG, UNIVERSE_FLAG, MEMBERS_FLAG, READ_WEIGHT_FLAG, OPERATION_WEIGHT_FLAG, PRINT_WEIGHT_FLAG, SEED_FLAG);
+    exit(ERROR);
+}
+
+/**
+ * Converts the value of a numeric option.
+ * Prints the usage and exits the program if the value is not an integer in the given range.
+ *
+ * @param programName The name of the program (for the usage).
+ * @param flag The flag of the option.
+ * @param value The value of the option.
+ * @param smallest The smallest valid value.
+ * @param largest The largest valid value.
+ * @return The value of the option.
+ */
+static long parseOption(const char programName[], const char flag[], const char value[], long smallest, long largest) {
+    char *end;   /* The end of the number. */
+    long number; /* The value of the option. */
+
+    number = strtol(value, &end, DECIMAL_BASE);
+
+    /* The value should be a whole number in the valid range. */
+    if (*end != '\0' || number < smallest || number > largest) {
+        fprintf(stderr, "Error: The value of %s should be an integer in the range %ld-%ld.\n", flag, smallest, largest);
+        printWorkloadUsage(programName);
+    }
+
+    return number;
+}
+
+/**
+ * Parses the command line arguments into the given options.
+ * Prints the usage and exits the program if the arguments are invalid.
+ *
+ * @param argc The number of command line arguments.
+ * @param argv The command line arguments.
+ * @param workload The options to fill.
+ */
+static void parseWorkloadArguments(int argc, char *argv[], workloadoptions *workload) {
+    int index;     /* Current index in the arguments. */
+    long *value;   /* The option the current argument sets. */
+    long smallest; /* The smallest valid value of the option. */
+    long largest;  /* The largest valid value of the option. */
+
+    workload->commands = DEFAULT_COMMANDS;
+    workload->universe = DEFAULT_UNIVERSE;
+    workload->members = DEFAULT_MEMBERS;
+    workload->weights[READ_KIND] = DEFAULT_READ_WEIGHT;
+    workload->weights[OPERATION_KIND] = DEFAULT_OPERATION_WEIGHT;
+    workload->weights[PRINT_KIND] = DEFAULT_PRINT_WEIGHT;
+    workload->seed = DEFAULT_SEED;
+
+    /* Every option is a flag followed by a number. */
+    for (index = FIRST_ARGUMENT; index < argc; index++) {
+        value = NULL;
+        /* Sizes and the seed should be positive (a seed of 0 would make every random number 0), and weights may be 0. */
+        smallest = MINIMUM_UNIVERSE;
+        largest = MAXIMUM_WORKLOAD_OPTION;
+
+        if (!strcmp(argv[index], COMMANDS_FLAG)) {
+            value = &workload->commands;
+            smallest = STARTING_VALUE;
+        } else if (!strcmp(argv[index], UNIVERSE_FLAG)) {
+            value = &workload->universe;
+            largest = MAXIMUM_UNIVERSE;
+        } else if (!strcmp(argv[index], MEMBERS_FLAG)) {
+            value = &workload->members;
+        } else if (!strcmp(argv[index], READ_WEIGHT_FLAG)) {
+            value = &workload->weights[READ_KIND];
+            smallest = STARTING_VALUE;
+        } else if (!strcmp(argv[index], OPERATION_WEIGHT_FLAG)) {
+            value = &workload->weights[OPERATION_KIND];
+            smallest = STARTING_VALUE;
+        } else if (!strcmp(argv[index], PRINT_WEIGHT_FLAG)) {
+            value = &workload->weights[PRINT_KIND];
+            smallest = STARTING_VALUE;
+        } else if (!strcmp(argv[index], SEED_FLAG)) {
+            value = &workload->seed;
+        }
+
+        /* Unknown argument (or a flag without a value). */
+        if (value == NULL || index + NEXT_INDEX_DIFFERENCE == argc) {
+            fprintf(stderr, "Error: Unknown argument %s.\n", argv[index]);
+            printWorkloadUsage(argv[FIRST_INDEX]);
+        }
+
+        *value = parseOption(argv[FIRST_INDEX], argv[index], argv[index + NEXT_INDEX_DIFFERENCE], smallest, largest);
+        index++;
+    }
+
+    /* At least one kind of command should be generated. */
+    if (workload->weights[READ_KIND] + workload->weights[OPERATION_KIND] + workload->weights[PRINT_KIND] == EMPTY) {
+        fprintf(stderr, "Error: At least one of the weights should be positive.\n");
+        exit(ERROR);
+    }
+}
+
+/**
+ * Writes a read_set command with a random set and random members.
+ * The number of members is spread evenly between 1 and twice the average.
+ *
+ * @param workload The options of the workload.
+ * @param state The state of the random numbers.
+ */
+static void writeReadSet(const workloadoptions *workload, unsigned long *state) {
+    unsigned long count; /* The number of members to write. */
+
+    count = nextRandom(state) % (unsigned long)(workload->members * GROWTH_FACTOR) + NEXT_INDEX_DIFFERENCE;
+    printf("%s %s", OPERATIONS[READ_SET], SETS[nextRandom(state) % NUMBER_OF_SETS]);
+
+    /* Write each member (members may repeat). */
+    while (count-- > EMPTY) {
+        printf(", %lu", nextRandom(state) % (unsigned long)workload->universe);
+    }
+
+    printf(", %d\n", TERMINATOR);
+}
+
+/**
+ * Writes a set operation with random sets.
+ * union_set, intersect_set and symdiff_set get 2 to 4 sets to combine, and sub_set gets 2.
+ *
+ * @param state The state of the random numbers.
+ */
+static void writeSetOperation(unsigned long *state) {
+    int operation;       /* The operation to write. */
+    unsigned long count; /* The number of sets to combine. */
+
+    operation = UNION_SET + (int)(nextRandom(state) % (SYMDIFF_SET - UNION_SET + NEXT_INDEX_DIFFERENCE));
+    count = THIRD_INDEX;
+
+    /* Every operation but sub_set can combine more than 2 sets. */
+    if (operation != SUB_SET) {
+        count += nextRandom(state) % (MAXIMUM_EXTRA_OPERANDS + NEXT_INDEX_DIFFERENCE);
+    }
+
+    printf("%s %s", OPERATIONS[operation], SETS[nextRandom(state) % NUMBER_OF_SETS]);
+
+    /* Write the rest of the sets to combine, and then the set to store the result in. */
+    while (--count > EMPTY) {
+        printf(", %s", SETS[nextRandom(state) % NUMBER_OF_SETS]);
+    }
+
+    printf(", %s\n", SETS[nextRandom(state) % NUMBER_OF_SETS]);
+}
+
+/**
+ * Parses the options, and writes the workload to the standard output.
+ *
+ * @param argc The number of command line arguments.
+ * @param argv The command line arguments.
+ * @return 0 when run successfully.
+ */
+int main(int argc, char *argv[]) {
+    /* The options the workload is generated with. */
+    workloadoptions workload;
+    /* The state of the random numbers. */
+    unsigned long state;
+    /* The sum of the weights of every kind of command. */
+    unsigned long totalWeight;
+    /* A random number, used to pick the kind of the next command. */
+    unsigned long pick;
+    /* The number of commands written so far. */
+    long written;
+
+    parseWorkloadArguments(argc, argv, &workload);
+    setvbuf(stdout, NULL, _IOFBF, OUTPUT_BUFFER_SIZE);
+
+    state = (unsigned long)workload.seed;
+    totalWeight = workload.weights[READ_KIND] + workload.weights[OPERATION_KIND] + workload.weights[PRINT_KIND];
+
+    for (written = STARTING_VALUE; written < workload.commands; written++) {
+        pick = nextRandom(&state) % totalWeight;
+
+        /* Pick the kind of the command by its weight. */
+        if (pick < (unsigned long)workload.weights[READ_KIND]) {
+            writeReadSet(&workload, &state);
+        } else if (pick < (unsigned long)(workload.weights[READ_KIND] + workload.weights[OPERATION_KIND])) {
+            writeSetOperation(&state);
+        } else {
+            printf("%s %s\n", OPERATIONS[PRINT_SET], SETS[nextRandom(&state) % NUMBER_OF_SETS]);
+        }
+    }
+
+    printf("%s\n", OPERATIONS[STOP]);
+
+    /* Return 0 when run successfully. */
+    return SUCCESS;
+}